@@ -55,6 +55,7 @@ typedef struct
 {
 	unsigned short nLength;
 	unsigned char *apParams[SOUND1_PARAMETER_COUNT];
+	unsigned short *pRows;		// Compiled rows, 0 if not compiled
 } SSound1Pattern;
 
 // Sound 2 pattern
@@ -62,6 +63,7 @@ typedef struct
 {
 	unsigned short nLength;
 	unsigned char *apParams[SOUND2_PARAMETER_COUNT];
+	unsigned short *pRows;		// Compiled rows, 0 if not compiled
 } SSound2Pattern;
 
 // Sound 3 pattern
@@ -69,6 +71,7 @@ typedef struct
 {
 	unsigned short nLength;
 	unsigned char *apParams[SOUND3_PARAMETER_COUNT];
+	unsigned short *pRows;		// Compiled rows, 0 if not compiled
 } SSound3Pattern;
 
 // Sound 4 pattern
@@ -76,22 +79,154 @@ typedef struct
 {
 	unsigned short nLength;
 	unsigned char *apParams[SOUND4_PARAMETER_COUNT];
+	unsigned short *pRows;		// Compiled rows, 0 if not compiled
 } SSound4Pattern;
 
+// Players that can share the sound channels, including the default one
+#define BOYSCOUT_MAX_PLAYERS	4
+
+// Alignment of everything BoyScout places in its memory
+#define BOYSCOUT_MEMORY_ALIGN	4
+
+// Memory handed out to songs from a caller supplied pool
+typedef struct SBoyScoutArena
+{
+	unsigned int nAddress;				// Next free address
+	unsigned int nEnd;					// End of the pool
+} SBoyScoutArena;
+
+// A parsed song. The pattern tables are in memory from an arena, so a
+// loaded song can be switched to without parsing its header again.
+typedef struct SBoyScoutSong
+{
+	unsigned char cSound1Patterns;		// Pattern counts
+	unsigned char cSound2Patterns;
+	unsigned char cSound3Patterns;
+	unsigned char cSound4Patterns;
+
+	unsigned short nSongLength;			// Song length
+
+	unsigned char nSequencerBeatsPerRow;	// Beats per sequencer row
+
+	unsigned char nBeatLength;			// Length of a beat
+
+	unsigned char cSound3WaveForms;		// Wave form count
+	unsigned int *pSound3WaveForms;		// Wave forms
+
+	unsigned char *apSequencerParams[SOUND_CHANNEL_COUNT];	// Sequencer parameters
+
+	SSound1Pattern *pSound1Patterns;	// Sound channel patterns
+	SSound2Pattern *pSound2Patterns;
+	SSound3Pattern *pSound3Patterns;
+	SSound4Pattern *pSound4Patterns;
+
+	int nSongCompiled;					// Song patterns compiled to row records
+} SBoyScoutSong;
+
+// State of one song player. A music song and sound effects can play at
+// the same time from separate players, each with its own memory area.
+typedef struct SBoyScoutPlayer
+{
+	SBoyScoutSong *pSong;				// Song being played
+	SBoyScoutSong Song;					// Song opened with BoyScoutOpenSong
+
+	unsigned char nPlaySpeed;			// The playback speed
+	unsigned int nPlaySpeedFixed;		// The playback speed in 16.16 frames per row
+	unsigned int nTickAccumulator;		// 16.16 frames since the last row, timer mode
+
+	int nMuteChannel1;					// Mute options
+	int nMuteChannel2;
+	int nMuteChannel3;
+	int nMuteChannel4;
+
+	short nSound3PlayWaveForm;			// Wave form in playing buffer, as loaded by this player
+	short nSound3WaveForm;				// Wave form this player wants loaded
+	unsigned char iSound3PlayBank;		// Which buffer playing waveform resides
+
+	SRLEIterator aRLESequencer[SOUND_CHANNEL_COUNT];		// Sequencer iterators
+
+	SRLEIterator aRLESound1[SOUND1_PARAMETER_COUNT];	// Sound channel iterators
+	SRLEIterator aRLESound2[SOUND2_PARAMETER_COUNT];
+	SRLEIterator aRLESound3[SOUND3_PARAMETER_COUNT];
+	SRLEIterator aRLESound4[SOUND4_PARAMETER_COUNT];
+
+	unsigned char nPlayState;						// Current play state
+	int iTickCounter;								// Tick counter
+	int iBeatsPerRowCounter;						// Counter for sequencer update
+	int iPlayPosition;								// Current play position
+	short aiPlayPatterns[SOUND_CHANNEL_COUNT];		// Current play patterns
+	int aiPlayPatternPositions[SOUND_CHANNEL_COUNT];	// Current play positions in patterns
+
+	short anSound1Params[SOUND1_PARAMETER_COUNT];	// Current channel parameters
+	short anSound2Params[SOUND2_PARAMETER_COUNT];
+	short anSound3Params[SOUND3_PARAMETER_COUNT];
+	short anSound4Params[SOUND4_PARAMETER_COUNT];
+
+	unsigned short *apPlayRows[SOUND_CHANNEL_COUNT];	// Current row records when compiled
+
+	unsigned int nMemoryArea;			// Address to a free memory area which BS needs
+	unsigned int nMemorySize;			// Size of the memory area, 0 if not checked
+	unsigned int nMemoryUsed;			// Bytes of the memory area used by the open song
+
+	int nPriority;						// Higher priority players take channels from lower ones
+	unsigned char nOwnedChannels;		// Channels this player wrote to on its last row, bit per channel
+	unsigned char nStruckChannels;		// Channels with a note since the song started, bit per channel
+} SBoyScoutPlayer;
+
 // PROTOTYPES /////
 
 void RLEISet(unsigned char *pData, SRLEIterator *pRLEIterator);
 void RLEINext(SRLEIterator *pRLEIterator);
 
 void BoyScoutInitialize();
-void BoyScoutOpenSong(const unsigned char *pSongData);
+int BoyScoutOpenSong(const unsigned char *pSongData);
 void BoyScoutPlaySong(int nLoop);
 void BoyScoutStopSong();
 unsigned short BoyScoutGetNeededSongMemory(const unsigned char *pSongData);
 void BoyScoutSetMemoryArea(unsigned int nMemoryAddress);
 unsigned int BoyScoutGetMemoryArea();
+void BoyScoutSetMemoryAreaSize(unsigned int nSize);	// Makes BoyScoutOpenSong check the song fits
 int BoyScoutUpdateSong();
 
+// Optional compile step, run after BoyScoutOpenSong. Converts the
+// patterns into one row-major stream per pattern, stored in the memory
+// area after the pattern structures, so each row of a channel is read
+// from a single record instead of stepping every parameter iterator.
+// A record is a halfword holding a mask of the parameters set on the
+// row in the low byte and their count in the high byte, followed by
+// the values of those parameters. A song can't be compiled while a
+// player is playing it, the compile functions return 0.
+unsigned int BoyScoutGetNeededCompiledMemory();
+unsigned int BoyScoutCompileSong();
+
+// Preloaded songs: the pattern tables, and optionally the compiled
+// rows, of several songs are placed in a pool up front, eg during a
+// loading screen. BoyScoutGetNeededSongMemory and
+// BoyScoutGetNeededLoadedCompiledMemory give the exact sizes when the
+// pool starts on a BOYSCOUT_MEMORY_ALIGN boundary. A loaded song is
+// then started on the selected player with BoyScoutSetSong, which only
+// switches a pointer. The song data and the pool have to stay in place
+// while the song is in use.
+void BoyScoutArenaInit(SBoyScoutArena *pArena, unsigned int nAddress, unsigned int nSize);
+unsigned int BoyScoutArenaAlloc(SBoyScoutArena *pArena, unsigned int nSize);	// 0 if out of room
+unsigned int BoyScoutArenaGetFree(const SBoyScoutArena *pArena);
+int BoyScoutLoadSong(SBoyScoutSong *pSong, const unsigned char *pSongData, SBoyScoutArena *pArena);
+unsigned int BoyScoutGetNeededLoadedCompiledMemory(const SBoyScoutSong *pSong);
+int BoyScoutCompileLoadedSong(SBoyScoutSong *pSong, SBoyScoutArena *pArena);
+void BoyScoutSetSong(SBoyScoutSong *pSong);
+
+// Several players: BoyScoutInitialize sets up the default player, used
+// for music, and BoyScoutAddPlayer adds others, eg for sound effects.
+// All the song functions work on the selected player, and a player
+// with a pattern playing on a channel takes it from any player of
+// lower priority. The lower priority player keeps its parameters up
+// to date and gets the channel back once the pattern ends.
+void BoyScoutAddPlayer(SBoyScoutPlayer *pPlayer, int nPriority);
+void BoyScoutRemovePlayer(SBoyScoutPlayer *pPlayer);
+void BoyScoutSelectPlayer(SBoyScoutPlayer *pPlayer);	// 0 selects the default player
+SBoyScoutPlayer *BoyScoutGetPlayer();
+int BoyScoutUpdateAllSongs();							// Updates every player, returns 0 if none are playing
+
 void DMA3Copy32(unsigned int Src, unsigned int Dst, unsigned short Count);
 
 // WK Set to 1 to use dma, or to 0 to use software copy
@@ -103,8 +238,6 @@ void DMA3Copy32(unsigned int Src, unsigned int Dst, unsigned short Count);
 // a beat takes x/60, where x is the value you give
 // increasing this value slows the song down, decreasing speeds it up
 
-// TODO?  move the timing to a timer to get a better control through increades granularity
-
 unsigned char BoyScoutGetNormalSpeed();
 unsigned char BoyScoutGetSpeed();
 
@@ -112,6 +245,20 @@ void BoyScoutIncSpeed(unsigned char speed);
 void BoyScoutDecSpeed(unsigned char speed);
 void BoyScoutSetSpeed(unsigned char speed);
 
+// The speed in 16.16 fixed point frames per row, so 0x68000 plays a row
+// every 6.5 frames. Fractions only take effect in timer mode.
+void BoyScoutSetFixedSpeed(unsigned int speed);
+unsigned int BoyScoutGetFixedSpeed();
+
+// Timer mode: a timer interrupt, registered with irqSet, plays the song
+// at exactly the frame rate whatever the main loop does, and
+// BoyScoutUpdateSong no longer needs to be called. The timer (0-3) is
+// reserved until BoyScoutStopTimer. Returns 0 for an invalid timer.
+// Only the tick handler is in IWRAM, the rows are played by ROM code
+// inside the interrupt, which takes longer on rows with many changes.
+int BoyScoutStartTimer(int nTimer);
+void BoyScoutStopTimer();
+
 
 // WK  some functions to mute individual channels
 void BoyScoutMuteChannel1(int mute);
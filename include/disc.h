@@ -31,6 +31,58 @@
 
 #include "disc_io.h"
 
+// Room for the built in interfaces plus a few registered ones
+#define DISC_MAX_INTERFACES		8
+
+// Sectors read by discMeasureInterfaces to time each interface
+#define DISC_MEASURE_SECTORS	16
+
+// Quick check that the hardware for an interface is there
+typedef bool (* FN_MEDIUM_PROBE)(void) ;
+
+/*
+Finds the interface for the inserted hardware and starts it up.
+The last interface found is tried first, then the one named by the
+SRAM hint if enabled, then the rest with a quick probe before each
+slow startup.
+*/
 extern const DISC_INTERFACE* discGetInterface (void);
 
+/*
+Add an interface, such as a loaded DLDI, to the ones discGetInterface
+tries. probe may be NULL if startup is already quick to fail.
+Returns false if the list is full or the interface can't read.
+*/
+extern bool discRegisterInterface (const DISC_INTERFACE* disc, FN_MEDIUM_PROBE probe);
+extern void discUnregisterInterface (const DISC_INTERFACE* disc);
+
+/*
+Start and time every interface that is present, so discGetInterface
+picks the fastest working one, which is left started up. Uses the
+cascaded timers timer and timer+1 (0 to 2) while it runs and needs
+8KB of heap.
+Returns the number of working interfaces, -1 on error.
+*/
+extern int discMeasureInterfaces (int timer);
+
+/*
+Read speed in bytes per second found by discMeasureInterfaces
+*/
+extern u32 discGetSpeed (const DISC_INTERFACE* disc);
+
+/*
+Keep a hint of the last interface found in 8 bytes of SRAM at hint,
+so it is tried first after a reboot. NULL (the default) disables it.
+*/
+extern void discSetHintLocation (vu8* hint);
+
+/*
+Read or write whole sectors scattered across a list of segments, so
+data can go straight to where it is used (VRAM, several buffers)
+without an extra copy. Each segment buffer and length must be even and
+the total a multiple of 512 bytes. Returns false for a bad segment list.
+*/
+extern bool discReadSectorsV (const DISC_INTERFACE* disc, sec_t sector, const DISC_SEGMENT* segments, int numSegments);
+extern bool discWriteSectorsV (const DISC_INTERFACE* disc, sec_t sector, const DISC_SEGMENT* segments, int numSegments);
+
 #endif // GBA_DISC_INCLUDE
@@ -0,0 +1,108 @@
+/*
+ disc_async.h
+ Interrupt driven sector transfers
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GBA_DISC_ASYNC_INCLUDE
+#define GBA_DISC_ASYNC_INCLUDE
+
+#include "disc_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	DISC_ASYNC_IDLE = 0,	// nothing submitted yet
+	DISC_ASYNC_BUSY,		// transfer in progress
+	DISC_ASYNC_DONE,		// last transfer succeeded
+	DISC_ASYNC_FAILED		// last transfer failed
+} DISC_ASYNC_STATUS;
+
+/*
+Called when a transfer finishes, from the timer interrupt when the
+transfer was interrupt driven.
+*/
+typedef void (* DISC_ASYNC_CALLBACK)(bool result, void* userData) ;
+
+/*
+A tick moves one sector at most, about 3500 cycles with the CF read
+loop and the interrupt dispatch, against 16384 cycles between ticks.
+While a transfer is in progress it takes up to about a fifth of the
+CPU and moves up to 512KB a second, a tick where the card isn't ready
+costs under 1%.
+*/
+// Sectors moved at most per timer interrupt, bounds the time spent in it
+#define DISC_ASYNC_SECTORS_PER_TICK 1
+// Interrupts per second while a transfer is in progress
+#define DISC_ASYNC_TICKS_PER_SECOND 1024
+// Interrupts without progress before a transfer is abandoned, about 2 seconds
+#define DISC_ASYNC_TIMEOUT_TICKS (2 * DISC_ASYNC_TICKS_PER_SECOND)
+
+/*-----------------------------------------------------------------
+discAsyncInit
+Prepares disc, which must already have been started up, for
+asynchronous transfers. The CF interfaces are driven one step at a
+time from the interrupt of timer (0 to 3), which only runs while a
+transfer is in progress. Other interfaces complete each transfer
+synchronously inside the submit call.
+-----------------------------------------------------------------*/
+extern bool discAsyncInit (const DISC_INTERFACE* disc, int timer);
+
+/*-----------------------------------------------------------------
+discAsyncStop
+Abandons any transfer in progress and releases the timer.
+-----------------------------------------------------------------*/
+extern void discAsyncStop (void);
+
+/*-----------------------------------------------------------------
+discAsyncRead / discAsyncWrite
+Start a transfer and return straight away. The buffer must stay
+valid, and the interface must not be used directly, until the
+transfer has finished. callback may be NULL.
+Return false if a transfer is already in progress.
+-----------------------------------------------------------------*/
+extern bool discAsyncRead (sec_t sector, sec_t numSectors, void* buffer, DISC_ASYNC_CALLBACK callback, void* userData);
+extern bool discAsyncWrite (sec_t sector, sec_t numSectors, const void* buffer, DISC_ASYNC_CALLBACK callback, void* userData);
+
+/*-----------------------------------------------------------------
+discAsyncPoll
+Returns the state of the current or last transfer.
+-----------------------------------------------------------------*/
+extern DISC_ASYNC_STATUS discAsyncPoll (void);
+
+/*-----------------------------------------------------------------
+discAsyncWait
+Waits for the current transfer to finish, returns its result. The
+CPU is halted in IntrWait between ticks, so interrupts must be on.
+-----------------------------------------------------------------*/
+extern bool discAsyncWait (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GBA_DISC_ASYNC_INCLUDE
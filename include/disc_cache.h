@@ -0,0 +1,86 @@
+/*
+ disc_cache.h
+ Write-back sector cache for any DISC_INTERFACE
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GBA_DISC_CACHE_INCLUDE
+#define GBA_DISC_CACHE_INCLUDE
+
+#include "disc_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISC_CACHE_SECTOR_SIZE	512
+
+typedef struct DISC_CACHE_STATS {
+	u32	readHits;		// sectors read from the cache
+	u32	readMisses;		// sectors read from the disc
+	u32	writeHits;		// sectors written to a sector already cached
+	u32	writeMisses;	// sectors written to a newly cached sector
+	u32	writeThrough;	// sectors written straight to the disc
+	u32	writeBacks;		// multi-sector writes issued when flushing
+	u32	sectorsFlushed;	// dirty sectors written when flushing
+} DISC_CACHE_STATS;
+
+/*-----------------------------------------------------------------
+discCacheInit
+Wraps disc in a write-back cache of numSectors 512 byte sectors,
+allocated from the heap (EWRAM). Any previous cache is flushed and
+freed. The wrapper keeps the ioType and features of disc.
+Returns the wrapper interface or NULL if the cache couldn't be allocated.
+-----------------------------------------------------------------*/
+extern const DISC_INTERFACE* discCacheInit (const DISC_INTERFACE* disc, int numSectors);
+
+/*-----------------------------------------------------------------
+discCacheFlush
+Writes all dirty sectors to the disc, adjacent sectors are written
+with a single multi-sector write.
+-----------------------------------------------------------------*/
+extern bool discCacheFlush (void);
+
+/*-----------------------------------------------------------------
+discCacheInvalidate
+Flushes then forgets every cached sector, use after the disc
+has been written behind the cache's back.
+-----------------------------------------------------------------*/
+extern bool discCacheInvalidate (void);
+
+/*-----------------------------------------------------------------
+discCacheFree
+Flushes and releases the cache, the wrapper is unusable afterwards.
+-----------------------------------------------------------------*/
+extern bool discCacheFree (void);
+
+extern void discCacheGetStats (DISC_CACHE_STATS* stats);
+extern void discCacheResetStats (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GBA_DISC_CACHE_INCLUDE
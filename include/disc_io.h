@@ -61,4 +61,16 @@ struct DISC_INTERFACE_STRUCT {
 
 typedef struct DISC_INTERFACE_STRUCT DISC_INTERFACE ;
 
+/*
+One piece of a scattered buffer for the vectored transfers in disc.h.
+Buffers and lengths must be even, so transfers can be done a halfword
+at a time straight into VRAM, and the lengths add up to whole sectors.
+*/
+typedef struct DISC_SEGMENT_STRUCT {
+	void*		buffer ;
+	uint32_t	length ;
+} DISC_SEGMENT ;
+
+typedef bool (* FN_MEDIUM_READSECTORSV)(sec_t sector, const DISC_SEGMENT* segments, int numSegments) ;
+
 #endif	// define GBA_DISC_IO_INCLUDE
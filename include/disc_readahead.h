@@ -0,0 +1,84 @@
+/*
+ disc_readahead.h
+ Sequential readahead for any DISC_INTERFACE
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GBA_DISC_READAHEAD_INCLUDE
+#define GBA_DISC_READAHEAD_INCLUDE
+
+#include "disc_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest readahead, one CF command or one SD READ_MULTIPLE_BLOCK run
+#define DISC_READAHEAD_MAX_SECTORS	256
+// Readahead used when a sequential run is first detected
+#define DISC_READAHEAD_MIN_SECTORS	8
+
+typedef struct DISC_READAHEAD_STATS {
+	u32	sectorsBuffered;	// sectors served from the readahead buffer
+	u32	sectorsDirect;		// sectors read straight into the caller's buffer
+	u32	sectorsPrefetched;	// sectors read into the readahead buffer
+	u32	readCommands;		// reads issued to the wrapped disc
+} DISC_READAHEAD_STATS;
+
+/*-----------------------------------------------------------------
+discReadaheadInit
+Wraps disc so that runs of sequential reads are turned into larger
+reads of up to maxSectors sectors, the extra sectors are held in a
+buffer allocated from the heap (EWRAM). The readahead starts at
+DISC_READAHEAD_MIN_SECTORS and doubles each time the buffer is used
+up by sequential reads, any other read drops it back to nothing.
+Writes go straight to the disc and update the buffer. The wrapper
+keeps the ioType and features of disc.
+Returns the wrapper interface or NULL if the buffer couldn't be
+allocated.
+-----------------------------------------------------------------*/
+extern const DISC_INTERFACE* discReadaheadInit (const DISC_INTERFACE* disc, int maxSectors);
+
+/*-----------------------------------------------------------------
+discReadaheadInvalidate
+Discards the buffered sectors, use after the disc has been written
+behind the wrapper's back.
+-----------------------------------------------------------------*/
+extern void discReadaheadInvalidate (void);
+
+/*-----------------------------------------------------------------
+discReadaheadFree
+Releases the buffer, the wrapper is unusable afterwards.
+-----------------------------------------------------------------*/
+extern void discReadaheadFree (void);
+
+extern void discReadaheadGetStats (DISC_READAHEAD_STATS* stats);
+extern void discReadaheadResetStats (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GBA_DISC_READAHEAD_INCLUDE
@@ -0,0 +1,139 @@
+/*
+ disc_stats.h
+ I/O statistics and tracing for any DISC_INTERFACE
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GBA_DISC_STATS_INCLUDE
+#define GBA_DISC_STATS_INCLUDE
+
+#include "disc_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Batch sizes are counted in powers of two: 1, 2-3, 4-7 ... 256 and over
+#define DISC_STATS_BATCH_BUCKETS 9
+
+// Latencies are measured in timer ticks of 64 cpu cycles
+#define DISC_STATS_TICKS_PER_SECOND 262144
+
+typedef struct DISC_STATS {
+	u32	reads;							// readSectors calls
+	u32	writes;							// writeSectors calls
+	u32	readErrors;						// readSectors calls that failed
+	u32	writeErrors;					// writeSectors calls that failed
+	u32	sectorsRead;
+	u32	sectorsWritten;
+	u32	readBatches[DISC_STATS_BATCH_BUCKETS];	// reads by number of sectors
+	u32	writeBatches[DISC_STATS_BATCH_BUCKETS];	// writes by number of sectors
+	u32	readTicks;						// total time spent reading
+	u32	writeTicks;						// total time spent writing
+	u32	maxReadTicks;					// slowest single read
+	u32	maxWriteTicks;					// slowest single write
+} DISC_STATS;
+
+/*
+Counters kept by the built in drivers themselves, shared by all of
+them. They show time lost in the drivers' polling loops. Counting
+costs a little in every loop, so it is only built in when libgba is
+compiled with -DDISC_STATS_DRIVERS, otherwise the counters stay 0.
+*/
+typedef struct DISC_DRIVER_STATS {
+	u32	busyWaitLoops;		// iterations of the drivers' busy wait loops
+	u32	statusPolls;		// SEND_STATUS polls waiting for SD writes to finish
+	u32	cardTimeouts;		// CF_CARD_TIMEOUT expiries
+	u32	busyWaitTimeouts;	// BUSY_WAIT_TIMEOUT and TRANSMIT_TIMEOUT expiries
+	u32	writeTimeouts;		// WRITE_TIMEOUT expiries
+} DISC_DRIVER_STATS;
+
+extern DISC_DRIVER_STATS discDriverStats;
+
+#ifdef DISC_STATS_DRIVERS
+#define DISC_DRIVER_COUNT(counter, n) (discDriverStats.counter += (n))
+#else
+#define DISC_DRIVER_COUNT(counter, n) ((void)0)
+#endif
+
+enum DISC_TRACE_OP {
+	DISC_TRACE_READ = 0,
+	DISC_TRACE_WRITE,
+	DISC_TRACE_STARTUP,
+	DISC_TRACE_CLEARSTATUS,
+	DISC_TRACE_SHUTDOWN
+};
+
+/*
+One traced call, 16 bytes so a trace can be dumped straight to a
+file and read back on any little endian machine.
+*/
+typedef struct DISC_TRACE_ENTRY {
+	u32	time;			// timer ticks when the call started
+	u32	sector;
+	u32	ticks;			// time taken by the call
+	u16	numSectors;
+	u8	op;				// DISC_TRACE_OP
+	u8	result;			// 1 if the call succeeded
+} DISC_TRACE_ENTRY;
+
+/*-----------------------------------------------------------------
+discStatsInit
+Wraps disc so every call is counted. Latencies are measured with
+the two cascaded timers timer and timer + 1 (timer 0 to 2), which
+are reserved until discStatsStop, or not measured if timer is -1.
+The wrapper keeps the ioType and features of disc.
+-----------------------------------------------------------------*/
+extern const DISC_INTERFACE* discStatsInit (const DISC_INTERFACE* disc, int timer);
+
+/*-----------------------------------------------------------------
+discStatsStop
+Stops the latency timers, the wrapper keeps counting.
+-----------------------------------------------------------------*/
+extern void discStatsStop (void);
+
+extern void discStatsGet (DISC_STATS* stats);
+extern void discStatsReset (void);
+
+/*-----------------------------------------------------------------
+discStatsTraceStart
+Records every call in a ring of numEntries entries at buffer,
+once full the oldest entries are overwritten.
+-----------------------------------------------------------------*/
+extern void discStatsTraceStart (DISC_TRACE_ENTRY* buffer, int numEntries);
+
+/*-----------------------------------------------------------------
+discStatsTraceStop
+Stops tracing and returns the total number of calls traced, the
+oldest entry still in the ring is at that count modulo numEntries
+if the ring filled up, otherwise at 0.
+-----------------------------------------------------------------*/
+extern u32 discStatsTraceStop (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GBA_DISC_STATS_INCLUDE
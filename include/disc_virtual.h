@@ -0,0 +1,97 @@
+/*
+ disc_virtual.h
+ RAM and file backed DISC_INTERFACEs for testing and benchmarking
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+These are for host builds: disc_virtual.c opens files through POSIX
+calls and isn't part of libgba.a, link it in with the program.
+*/
+
+#ifndef GBA_DISC_VIRTUAL_INCLUDE
+#define GBA_DISC_VIRTUAL_INCLUDE
+
+#include "disc_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 'RAMD'
+#define DEVICE_TYPE_RAMDISC 0x444D4152
+// 'FILE'
+#define DEVICE_TYPE_FILEDISC 0x454C4946
+
+/*
+Simulated device timing. Nothing is slowed down, instead every command
+adds its cost to an elapsed time counter which can be read back, so
+results are the same on every machine.
+commandLatency: microseconds charged for each read or write command
+bytesPerSecond: transfer rate charged for the data, 0 for no cost
+*/
+typedef struct DISC_TIMING {
+	u32	commandLatency;
+	u32	bytesPerSecond;
+} DISC_TIMING;
+
+// Rough figures for a CF adapter and a bit-banged SD adapter
+extern const DISC_TIMING discTimingCF;
+extern const DISC_TIMING discTimingSD;
+
+/*-----------------------------------------------------------------
+discRamInit
+Uses numSectors 512 byte sectors at image as a disc. Writes are
+refused unless writable is set.
+-----------------------------------------------------------------*/
+extern const DISC_INTERFACE* discRamInit (void* image, sec_t numSectors, bool writable);
+
+/*-----------------------------------------------------------------
+discFileInit
+Uses a disc image file as a disc, the file is opened by the
+interface's startup and closed by its shutdown. Writes are refused
+unless writable is set.
+-----------------------------------------------------------------*/
+extern const DISC_INTERFACE* discFileInit (const char* path, bool writable);
+
+/*-----------------------------------------------------------------
+discVirtualSetTiming
+Sets the simulated timing of a RAM or file disc, NULL for none.
+-----------------------------------------------------------------*/
+extern bool discVirtualSetTiming (const DISC_INTERFACE* disc, const DISC_TIMING* timing);
+
+/*-----------------------------------------------------------------
+discVirtualElapsed
+Simulated microseconds spent by a RAM or file disc since it was
+initialised or discVirtualResetElapsed was called.
+-----------------------------------------------------------------*/
+extern unsigned long long discVirtualElapsed (const DISC_INTERFACE* disc);
+extern void discVirtualResetElapsed (const DISC_INTERFACE* disc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GBA_DISC_VIRTUAL_INCLUDE
@@ -39,6 +39,9 @@
 #define DLDI_MAGIC_STRING_LEN 		8
 #define DLDI_FRIENDLY_NAME_LEN 		48
 
+// Size of the header at the start of a driver, sizeof(DLDI_INTERFACE) on the GBA
+#define DLDI_HEADER_SIZE			0x80
+
 extern const u32  DLDI_MAGIC_NUMBER;
 
 // I/O interface with DLDI extensions
@@ -89,6 +92,33 @@ Adjust the pointer addresses within a DLDI driver
 */
 extern void dldiFixDriverAddresses (DLDI_INTERFACE* io);
 
+/*
+Adjust the pointer addresses within a DLDI driver held at io so it
+runs from address instead, eg when preparing an image to be written
+elsewhere. dldiFixDriverAddresses(io) is dldiRelocate(io, (u32)io).
+*/
+extern void dldiRelocate (DLDI_INTERFACE* io, u32 address);
+
+/*
+Stricter check than dldiIsValid for a driver held in size bytes at a
+word aligned address: the data, glue and GOT sections must be in
+order and within the buffer, and the driver must fit the size given
+in its header.
+*/
+extern bool dldiValidate (const DLDI_INTERFACE* io, size_t size);
+
+/*
+Patch a driver into the DLDI stub of a ROM or multiboot image ahead of
+time, so the program doesn't need to load and relocate one at boot.
+The driver is relocated to the address the stub was linked at, and
+must fit in the space the stub has allocated.
+Returns false if the driver is invalid, there is no stub or it is
+too small. dldiRelocate, dldiValidate, dldiGetSize and this only use
+the driver's header as 32 bit words, so they also build into host
+tools, see tools/dldipatch.c.
+*/
+extern bool dldiPatchImage (u8* image, size_t imageSize, const DLDI_INTERFACE* driver, size_t driverSize);
+
 /*
 Load a DLDI from disc and set up the bus permissions.
 This returns a type not directly usable in libfat,
@@ -100,6 +130,32 @@ fatMount(&loadedDldi->ioInterface, "devname", 0);
 */
 extern DLDI_INTERFACE* dldiLoadFromFile (const char* path);
 
+/*
+Like dldiLoadFromFile, but loads into a caller supplied word aligned
+buffer, such as a block of IWRAM for faster drivers. Returns NULL if
+the buffer is smaller than dldiGetSize of the driver. Nothing needs
+to be freed afterwards.
+*/
+extern DLDI_INTERFACE* dldiLoadFromFileInto (const char* path, void* buffer, size_t size);
+
+/*
+Copy a loaded or embedded DLDI to a word aligned buffer and relocate
+it there, eg to IWRAM so the sector loops run from 32 bit zero wait
+state memory. The driver must not have been started yet, as its BSS
+is cleared. Returns NULL if the buffer is smaller than dldiGetSize.
+A DLDI on disc can be loaded straight into IWRAM with
+dldiLoadFromFileInto instead. To use it for discGetInterface:
+static u32 dldiSpace[2048] IWRAM_DATA;
+DLDI_INTERFACE* fast = dldiCopyTo (io_dldi_data, dldiSpace, sizeof(dldiSpace));
+discRegisterInterface (&fast->ioInterface, NULL);
+*/
+extern DLDI_INTERFACE* dldiCopyTo (const DLDI_INTERFACE* io, void* buffer, size_t size);
+
+/*
+Size in bytes needed to load a DLDI, including its BSS
+*/
+extern size_t dldiGetSize (const DLDI_INTERFACE* io);
+
 /* 
 Free resources used by a loaded DLDI. 
 Remember to unmount and shutdown first:
@@ -34,6 +34,8 @@
 #include <gba_dma.h>
 #include <gba_input.h>
 #include <gba_interrupt.h>
+#include <gba_adpcm.h>
+#include <gba_mixer.h>
 #include <gba_multiboot.h>
 #include <gba_sio.h>
 #include <gba_sound.h>
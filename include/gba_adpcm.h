@@ -0,0 +1,160 @@
+/*---------------------------------------------------------------------------------
+
+	Header file for libgba IMA ADPCM streaming
+
+	Copyright 2003-2005 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+---------------------------------------------------------------------------------*/
+
+//---------------------------------------------------------------------------------
+#ifndef _gba_adpcm_h_
+#define _gba_adpcm_h_
+//---------------------------------------------------------------------------------
+#ifdef __cplusplus
+extern "C" {
+#endif
+//---------------------------------------------------------------------------------
+
+#include "gba_base.h"
+#include "disc_io.h"
+
+/*---------------------------------------------------------------------------------
+	A stream is a run of blocks of ADPCM_BLOCK_SIZE bytes, one disc sector
+	each. A block starts with the decoder state, a little endian 16 bit
+	predictor, the step index and a pad byte, followed by ADPCM_BLOCK_SAMPLES
+	4 bit codes, low nibble first. Mono at 4 bits a sample, a stream is a
+	quarter the size of 16 bit PCM and half that of 8 bit PCM.
+
+	A stream on a disc holds two blocks, the one being played and the next.
+	adpcmRead runs in the mixer's interrupt and never reads the disc, as
+	the drivers can't be entered again from an interrupt and a sector read
+	takes too long there. The main loop reads the next block in good time
+	with adpcmPrefetch. Until it has, adpcmRead returns short and the
+	stream is silent for the rest of that refill.
+
+	tools/adpcmenc encodes 16 bit WAV files to streams.
+---------------------------------------------------------------------------------*/
+#define ADPCM_BLOCK_SIZE	512
+#define ADPCM_HEADER_SIZE	4
+#define ADPCM_BLOCK_SAMPLES	((ADPCM_BLOCK_SIZE - ADPCM_HEADER_SIZE) * 2)
+
+/** \struct AdpcmState
+ *  \brief The state of the decoder between samples.
+ */
+typedef struct AdpcmState {
+	s32 predictor;
+	s32 index;
+} AdpcmState;
+
+/** \struct AdpcmStream
+ *  \brief A stream being decoded from memory or from a disc.
+ */
+typedef struct AdpcmStream {
+	const u8 *data;					/*!< blocks in memory, NULL when on a disc */
+	const DISC_INTERFACE *disc;		/*!< interface the blocks are read from */
+	sec_t sector;					/*!< sector of the first block */
+	u32 samples;					/*!< length of the stream */
+	u32 position;					/*!< next sample to decode */
+	u32 block;						/*!< current block */
+	int offset;						/*!< next sample in the current block */
+	bool loop;						/*!< start again at the end */
+	AdpcmState state;
+	const u8 *codes;				/*!< codes of the current block */
+	int current;					/*!< buffer of the current block of a disc stream */
+	volatile s32 loaded[2];			/*!< block read into each buffer, -1 for none */
+	u8 buffer[2][ADPCM_BLOCK_SIZE] ALIGN(4);
+} AdpcmStream;
+
+/** \brief Open a stream held in memory, such as ROM.
+ *  \details The codes are read straight from the data, so nothing is copied.
+ *  @param stream The stream
+ *  @param data The encoded blocks
+ *  @param samples Length of the stream, the number of samples encoded
+ *  @param loop true to start again at the end
+ */
+void adpcmOpen(AdpcmStream *stream, const u8 *data, u32 samples, bool loop);
+
+/** \brief Open a stream stored in consecutive sectors of a disc.
+ *  \details Reads the first two blocks, after that \c adpcmPrefetch()
+ *  has to read each block before it is played. Not for interrupt context.
+ *  @return false if the first block could not be read.
+ */
+bool adpcmOpenDisc(AdpcmStream *stream, const DISC_INTERFACE *disc, sec_t sector, u32 samples, bool loop);
+
+/** \brief Start a stream from the beginning again.
+ *  \details Reads the disc like \c adpcmOpenDisc(), so not while the
+ *  stream is playing or from interrupt context.
+ *  @return false if the first block could not be read.
+ */
+bool adpcmRewind(AdpcmStream *stream);
+
+/** \brief Read the next block of a disc stream ahead of time.
+ *  \details Call it from the main loop, not from an interrupt, at least
+ *  once per \c ADPCM_BLOCK_SAMPLES samples played. Once a frame is
+ *  plenty, a block lasts 56ms at 18157Hz. Does nothing if the next block
+ *  is already there or the stream is in memory.
+ *  @return false if the disc read failed, it is tried again on the next call.
+ */
+bool adpcmPrefetch(AdpcmStream *stream);
+
+/** \brief Decode the next samples of a stream.
+ *  \details Decodes to signed 8 bit samples, as played by Direct Sound.
+ *  @param stream The stream
+ *  @param buffer Receives the samples
+ *  @param samples Number of samples wanted
+ *  @return the number of samples decoded, less than wanted at the end of a
+ *  stream which doesn't loop or if the next block of a disc stream hasn't
+ *  been read by \c adpcmPrefetch() yet.
+ */
+int adpcmRead(AdpcmStream *stream, s8 *buffer, int samples);
+
+/** \brief Stream function for \c mixerSetStream().
+ *  \details Decodes a stream straight into the mixer stream buffer each time
+ *  it is refilled, the stream has to be encoded at the mixer rate. A disc
+ *  stream needs \c adpcmPrefetch() called from the main loop as well.
+ *  @param stream The \c AdpcmStream
+ */
+int adpcmMixerStream(void *stream, s8 *buffer, int samples);
+
+/** \brief The decoding kernel.
+ *  \details Runs from IWRAM in ARM mode, about 30 cycles a sample estimated
+ *  from the instruction timings, 9000 cycles a frame at 18157Hz. Does not
+ *  touch the hardware, so it can be built and checked on a host.
+ *  @param state The decoder state, updated
+ *  @param codes The codes of a block
+ *  @param offset First sample of the block to decode
+ *  @param out Receives the samples
+ *  @param count Number of samples to decode
+ */
+extern IWRAM_CODE void adpcmDecode(AdpcmState *state, const u8 *codes, int offset, s8 *out, int count);
+
+/** \brief The IMA ADPCM tables, shared by the decoder and encoder.
+ */
+extern s16 adpcmStepTable[89];
+extern s8 adpcmIndexTable[16];
+
+//---------------------------------------------------------------------------------
+#ifdef __cplusplus
+}	   // extern "C"
+#endif
+//---------------------------------------------------------------------------------
+#endif // _gba_adpcm_h_
+//---------------------------------------------------------------------------------
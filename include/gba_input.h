@@ -117,6 +117,190 @@ u16 keysHeld();
  */
 void setRepeat( int SetDelay, int SetRepeat);
 
+/** \brief Start recording the keys seen by \c scanKeys().
+ *  \details The held keys of every frame are stored as a stream of 16 bit
+ *  little endian entries. Bits 0-9 of an entry are XORed with the previous
+ *  key state, which starts at 0, and bits 10-15 hold the number of frames
+ *  after the first that the new state lasts. An idle pad costs 2 bytes
+ *  every 64 frames. The buffer is written a byte at a time, so it can be in
+ *  SRAM. Recording stops when the buffer is full.
+ *  @param buffer Memory to record into
+ *  @param size Size of the buffer in bytes
+ */
+void keysRecordStart(u8 *buffer, int size);
+
+/** \brief Stop recording.
+ *  @return The number of bytes of the buffer used by the recording.
+ */
+int keysRecordStop(void);
+
+/** \brief Check if a recording is in progress.
+ *  @return false once the recording has been stopped or the buffer is full.
+ */
+bool keysRecording(void);
+
+/** \brief Replay a recording made with \c keysRecordStart().
+ *  \details Each call to \c scanKeys() takes one frame from the recording
+ *  in place of \c REG_KEYINPUT. The key state and repeat counters are reset
+ *  at the start of both recording and replay, so \c keysDown(), \c keysUp()
+ *  and \c keysDownRepeat() report exactly what they did while recording.
+ *  The keypad is read again once the recording runs out.
+ *  @param data The recording
+ *  @param size Size of the recording in bytes, as returned by
+ *  \c keysRecordStop()
+ */
+void keysReplayStart(const u8 *data, int size);
+
+/** \brief Stop replaying and go back to reading the keypad.
+ */
+void keysReplayStop(void);
+
+/** \brief Check if a recording is being replayed.
+ */
+bool keysReplaying(void);
+
+/** \enum KEYEVENT_TYPE
+ *  \brief Types of queued keypad events.
+ */
+typedef enum KEYEVENT_TYPE {
+	KEYEVENT_PRESS		=	1,	/*!< keys were pressed */
+	KEYEVENT_RELEASE	=	2	/*!< keys were released */
+} KEYEVENT_TYPE;
+
+/** \def KEYEVENT_TICKS_PER_SECOND
+ *  \brief Rate of the keypad event timestamps, 64 cpu cycles per tick.
+ */
+#define KEYEVENT_TICKS_PER_SECOND	262144
+
+/** \struct KeyEvent
+ *  \brief A timestamped keypad event.
+ *  @param time Timer ticks at which the change was sampled
+ *  @param keys The keys which changed state
+ *  @param type \c KEYEVENT_PRESS or \c KEYEVENT_RELEASE
+ */
+typedef struct KeyEvent {
+	u32 time;
+	u16 keys;
+	u16 type;
+} KeyEvent;
+
+/** \brief Start queueing timestamped keypad events.
+ *  \details Presses are caught by the keypad interrupt as they happen, so
+ *  presses shorter than a frame are not lost. Releases do not raise the keypad
+ *  interrupt, call \c keysEventSample() from your vblank handler to pick them
+ *  up once per frame. The timestamps come from two cascaded timers, \c timer
+ *  and \c timer + 1, which are reserved until \c keysEventStop() is called.
+ *  The polled \c scanKeys() functions are not affected.
+ *  @param timer The first of the two timers to use, 0 to 2
+ *  @return false if the timer number is invalid.
+ */
+bool keysEventInit(int timer);
+
+/** \brief Stop queueing keypad events and release the timers.
+ */
+void keysEventStop(void);
+
+/** \brief Sample the keypad and queue any changes.
+ *  \details This is the keypad interrupt handler, it should also be called
+ *  once per frame from the vblank handler to detect released keys.
+ */
+void keysEventSample(void);
+
+/** \brief Take the oldest event from the queue.
+ *  @param event Receives the event
+ *  @return false if the queue is empty.
+ */
+bool keysEventNext(KeyEvent *event);
+
+/** \brief Obtain the number of events waiting in the queue.
+ */
+int keysEventPending(void);
+
+/** \brief Discard all queued events.
+ */
+void keysEventFlush(void);
+
+/** \def COMBO_MAX_COMBOS
+ *  \brief The maximum number of combos which can be registered.
+ */
+#define COMBO_MAX_COMBOS	16
+
+/** \def COMBO_MAX_STEPS
+ *  \brief The maximum number of steps in a single combo.
+ */
+#define COMBO_MAX_STEPS		16
+
+/** \def COMBO_MAX_STATES
+ *  \brief The maximum number of states in the compiled combo matcher.
+ *  \details Combos sharing a common start share states, the total number of
+ *  steps plus one is always enough.
+ */
+#define COMBO_MAX_STATES	64
+
+/** \enum COMBO_SYMBOL
+ *  \brief The steps a combo is made of.
+ *  \details Directions are relative to the facing set with
+ *  \c comboSetFacing(), a direction step happens when the stick moves to that
+ *  direction, a button step when the button is pressed.
+ */
+typedef enum COMBO_SYMBOL {
+	COMBO_NEUTRAL = 0,	/*!< no direction held */
+	COMBO_UP,			/*!< up */
+	COMBO_UP_FORWARD,	/*!< up and forward */
+	COMBO_FORWARD,		/*!< forward */
+	COMBO_DOWN_FORWARD,	/*!< down and forward */
+	COMBO_DOWN,			/*!< down */
+	COMBO_DOWN_BACK,	/*!< down and back */
+	COMBO_BACK,			/*!< back */
+	COMBO_UP_BACK,		/*!< up and back */
+	COMBO_A,			/*!< A pressed */
+	COMBO_B,			/*!< B pressed */
+	COMBO_L,			/*!< L pressed */
+	COMBO_R,			/*!< R pressed */
+	COMBO_START,		/*!< START pressed */
+	COMBO_SELECT,		/*!< SELECT pressed */
+	COMBO_SYMBOLS		/*!< number of symbols */
+} COMBO_SYMBOL;
+
+/** \brief Register a combo.
+ *  \details The steps are only read by \c comboCompile(), which must be
+ *  called once all the combos have been added.
+ *  @param steps The sequence of \c COMBO_SYMBOL steps
+ *  @param length The number of steps, 1 to \c COMBO_MAX_STEPS
+ *  @param frames The most frames allowed between the first and last step,
+ *  values above 65535 are taken as 65535
+ *  @return the combo id, or -1 if the combo could not be added.
+ */
+int comboAdd(const u8 *steps, int length, int frames);
+
+/** \brief Remove all registered combos.
+ */
+void comboClear(void);
+
+/** \brief Build the matcher from the registered combos.
+ *  \details Every combo is matched in a single pass, each input step costs one
+ *  table lookup regardless of the number of combos.
+ *  @return false if the combos need more than \c COMBO_MAX_STATES states, or
+ *  two combos have the same steps. Nothing is matched until a compile succeeds.
+ */
+bool comboCompile(void);
+
+/** \brief Forget any partially entered combo.
+ */
+void comboReset(void);
+
+/** \brief Set which way forward is.
+ *  @param left true if forward is left, false if forward is right
+ */
+void comboSetFacing(bool left);
+
+/** \brief Feed this frame's keys to the matcher.
+ *  \details Call once per frame after \c scanKeys(). When several combos
+ *  finish on the same step the longest one entered in time is reported.
+ *  @return the id of the combo completed this frame, or -1.
+ */
+int comboUpdate(void);
+
 //---------------------------------------------------------------------------------
 #ifdef __cplusplus
 	}	   // extern "C"
@@ -0,0 +1,222 @@
+/*---------------------------------------------------------------------------------
+
+	Header file for libgba software sound mixer
+
+	Copyright 2003-2005 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+---------------------------------------------------------------------------------*/
+
+//---------------------------------------------------------------------------------
+#ifndef _gba_mixer_h_
+#define _gba_mixer_h_
+//---------------------------------------------------------------------------------
+#ifdef __cplusplus
+extern "C" {
+#endif
+//---------------------------------------------------------------------------------
+
+#include "gba_base.h"
+
+/** \def MIXER_MAX_VOICES
+ *  \brief The most voices the mixer can be started with.
+ */
+#define MIXER_MAX_VOICES	8
+
+/** \def MIXER_FRACTION_BITS
+ *  \brief Fraction bits of the voice positions.
+ */
+#define MIXER_FRACTION_BITS	12
+
+/** \def MIXER_MAX_LENGTH
+ *  \brief The longest sample mixerPlay takes, just under 1M samples.
+ *  \details The end of a sample has to fit in a 32 bit position, with room
+ *  left for a voice to step up to 256 samples past it before it is stopped.
+ */
+#define MIXER_MAX_LENGTH	((1 << (32 - MIXER_FRACTION_BITS)) - 256)
+
+/** \def MIXER_CHUNK
+ *  \brief Samples mixed at a time, sets the size of the IWRAM mix buffer.
+ */
+#define MIXER_CHUNK			64
+
+/** \def MIXER_MAX_SAMPLES
+ *  \brief Samples per frame at the highest rate.
+ */
+#define MIXER_MAX_SAMPLES	704
+
+/** \def MIXER_VOLUME_MAX
+ *  \brief Full voice volume.
+ */
+#define MIXER_VOLUME_MAX	256
+
+/** \def MIXER_PAN_LEFT
+ *  \brief Pan values range from \c MIXER_PAN_LEFT to \c MIXER_PAN_RIGHT.
+ */
+#define MIXER_PAN_LEFT		0
+#define MIXER_PAN_CENTRE	128
+#define MIXER_PAN_RIGHT		256
+
+/** \enum MIXER_RATE
+ *  \brief Sample rates with a whole number of samples per frame.
+ *  \details Each value is the number of samples mixed per frame, so the
+ *  buffers line up exactly with VBlank.
+ */
+typedef enum MIXER_RATE {
+	MIXER_RATE_5734		=	96,
+	MIXER_RATE_10512	=	176,
+	MIXER_RATE_13379	=	224,
+	MIXER_RATE_18157	=	304,
+	MIXER_RATE_21024	=	352,
+	MIXER_RATE_26758	=	448,
+	MIXER_RATE_31536	=	528,
+	MIXER_RATE_36314	=	608,
+	MIXER_RATE_40137	=	672,
+	MIXER_RATE_42048	=	704
+} MIXER_RATE;
+
+/** \enum MIXER_REFILL
+ *  \brief What triggers the refill of the buffer which has just played.
+ */
+typedef enum MIXER_REFILL {
+	MIXER_REFILL_VBLANK	=	0,	/*!< call \c mixerUpdate() first thing in your vblank handler */
+	MIXER_REFILL_TIMER	=	1	/*!< timer 1 counts the samples and raises an interrupt */
+} MIXER_REFILL;
+
+/** \struct MixerVoice
+ *  \brief The state of a voice, as used by the mixing kernel.
+ *  @param data Signed 8 bit samples, NULL when the voice is off
+ *  @param position Current position in samples, with \c MIXER_FRACTION_BITS fraction bits
+ *  @param step Added to the position for each output sample
+ *  @param end Length of the sample, same format as the position
+ *  @param loopLength Length of the loop at the end of the sample, 0 to play once
+ *  @param leftVolume Volume on the left, 0 to 256
+ *  @param rightVolume Volume on the right, 0 to 256
+ */
+typedef struct MixerVoice {
+	const s8 *data;
+	u32 position;
+	u32 step;
+	u32 end;
+	u32 loopLength;
+	u16 leftVolume;
+	u16 rightVolume;
+} MixerVoice;
+
+/** \brief Start the mixer.
+ *  \details Mixes into a double buffer per side which DMA 1 and DMA 2 feed
+ *  to Direct Sound FIFO A (left) and FIFO B (right) at the rate of timer 0.
+ *  The buffers are in EWRAM, the mixing kernel runs from IWRAM in ARM mode.
+ *
+ *  The kernel costs roughly 25 cycles per voice for each output sample,
+ *  plus 20 cycles per output sample to clip and store both sides. Each
+ *  voice also divides once per \c MIXER_CHUNK samples to find how far it
+ *  is from its end, a library call in ROM of 50 to 100 cycles, so about
+ *  1.5 cycles more per voice and sample. These figures are estimated from
+ *  the ARM instruction timings with the sample data in EWRAM, data in ROM
+ *  adds its wait states. Eight voices at 18157Hz take about 71000 cycles,
+ *  a quarter of a frame.
+ *
+ *  Voices start silent, with full volume centred as after
+ *  mixerSetVolume(voice, \c MIXER_VOLUME_MAX, \c MIXER_PAN_CENTRE), which
+ *  is \c MIXER_VOLUME_MAX / 2 on each side.
+ *  @param rate Sample rate
+ *  @param voices Number of voices, 1 to \c MIXER_MAX_VOICES
+ *  @param refill \c MIXER_REFILL_VBLANK or \c MIXER_REFILL_TIMER, which
+ *  takes timer 1 and its interrupt
+ *  @return false if the rate or voice count is invalid.
+ */
+bool mixerInit(MIXER_RATE rate, int voices, MIXER_REFILL refill);
+
+/** \brief Stop the mixer, releasing the DMA channels and timers.
+ */
+void mixerStop(void);
+
+/** \brief Refill the buffer which has just played.
+ *  \details With \c MIXER_REFILL_VBLANK this has to be called at the start
+ *  of every vblank, before anything which can take long.
+ */
+void mixerUpdate(void);
+
+/** \brief Start a sample on a voice.
+ *  @param voice The voice
+ *  @param data Signed 8 bit samples
+ *  @param length Length of the sample in samples, 1 to \c MIXER_MAX_LENGTH,
+ *  the voice is left as it was otherwise
+ *  @param loopLength Samples at the end of the sample to loop, 0 to play once
+ *  @param freq Playback rate in Hz
+ */
+void mixerPlay(int voice, const s8 *data, u32 length, u32 loopLength, u32 freq);
+
+/** \brief Silence a voice.
+ */
+void mixerStopVoice(int voice);
+
+/** \brief Set the volume of a voice.
+ *  @param voice The voice
+ *  @param volume 0 to \c MIXER_VOLUME_MAX
+ *  @param pan \c MIXER_PAN_LEFT to \c MIXER_PAN_RIGHT
+ */
+void mixerSetVolume(int voice, int volume, int pan);
+
+/** \brief Change the playback rate of a voice.
+ *  @param voice The voice
+ *  @param freq Playback rate in Hz
+ */
+void mixerSetFreq(int voice, u32 freq);
+
+/** \brief Check if a voice is still playing.
+ */
+bool mixerVoiceActive(int voice);
+
+/** \typedef int (* MixerStreamFn)(void *context, s8 *buffer, int samples)
+ *  \brief Fills the stream buffer with samples at the mixer rate.
+ *  @return the number of samples written, fewer at the end of the stream.
+ */
+typedef int (* MixerStreamFn)(void *context, s8 *buffer, int samples);
+
+/** \brief Play a stream, such as decoded music, on a voice.
+ *  \details The function is called for each buffer refill to write one
+ *  frame of samples, which the voice then mixes with its volume and pan.
+ *  @param voice The voice
+ *  @param fn The stream function, NULL to stop the stream
+ *  @param context Passed to the stream function
+ */
+void mixerSetStream(int voice, MixerStreamFn fn, void *context);
+
+/** \brief The mixing kernel.
+ *  \details Mixes the voices into signed 8 bit left and right output and
+ *  advances them, turning off voices which reach the end. Does not touch
+ *  the hardware, so it can be built and checked on a host.
+ *  @param voices The voices, those with NULL data are skipped
+ *  @param numVoices Number of voices
+ *  @param left Left output
+ *  @param right Right output
+ *  @param samples Number of samples to mix
+ */
+extern IWRAM_CODE void mixerMixVoices(MixerVoice *voices, int numVoices, s8 *left, s8 *right, int samples);
+
+//---------------------------------------------------------------------------------
+#ifdef __cplusplus
+}	   // extern "C"
+#endif
+//---------------------------------------------------------------------------------
+#endif // _gba_mixer_h_
+//---------------------------------------------------------------------------------
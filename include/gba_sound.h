@@ -348,6 +348,23 @@ void SoundDriverMode(u32 mode);
 
 u32  MidiKey2Freq(WaveData *wa, u8 mk, u8 fp);
 
+//---------------------------------------------------------------------------------
+//	Table based pitch conversion, a fast replacement for MidiKey2Freq
+//---------------------------------------------------------------------------------
+// MIDI key in 8.8 fixed point, as taken by pitchToFreq
+#define PITCH(mk, fp)	(((mk) << 8) | (fp))
+
+// freq * 2^((pitch - PITCH(180, 0)) / 3072) truncated, the power function
+// GBATEK gives for MidiKey2Freq. Keys above 178 give key 178 with fp 255.
+u32  pitchToFreq(u32 freq, u32 pitch);
+
+// pitchToFreq on a WaveData, with the arguments of MidiKey2Freq
+u32  pitchMidiKeyToFreq(WaveData *wa, u8 mk, u8 fp);
+
+// Convert count pitches at once, eg for the slides and vibrato of all the
+// voices each frame
+void pitchToFreqBatch(const u32 *freq, const u16 *pitch, u32 *out, int count);
+
 //---------------------------------------------------------------------------------
 #ifdef __cplusplus
 }	   // extern "C"
@@ -50,10 +50,52 @@ extern "C" {
 #define REG_TM3CNT_L	*(vu16*)(REG_BASE + 0x10c)
 #define REG_TM3CNT_H	*(vu16*)(REG_BASE + 0x10e)
 
+#define REG_TMCNT_L(n)	*(vu16*)(REG_BASE + 0x100 + ((n)<<2))
+#define REG_TMCNT_H(n)	*(vu16*)(REG_BASE + 0x102 + ((n)<<2))
+
+#define	TIMER_FREQ_1	0	// 16.78MHz
+#define	TIMER_FREQ_64	1	// 262.144kHz
+#define	TIMER_FREQ_256	2	// 65.536kHz
+#define	TIMER_FREQ_1024	3	// 16.384kHz
+
 #define	TIMER_COUNT	BIT(2)
 #define	TIMER_IRQ	BIT(6)
 #define	TIMER_START	BIT(7)
 
+/*! \fn void timerStartCascaded(int timer, u16 frequency)
+	\brief Start two cascaded timers counting from 0.
+	\param timer The low timer, 0 to 2, timer + 1 counts its overflows with \c TIMER_COUNT.
+	\param frequency The low timer's prescaler, one of \c TIMER_FREQ_1 to \c TIMER_FREQ_1024.
+
+	Both timers are stopped first, and the high one is started before the
+	low one so no overflow is missed. Read the count with timerReadCascaded.
+*/
+static inline void timerStartCascaded(int timer, u16 frequency) {
+	REG_TMCNT_H(timer) = 0;
+	REG_TMCNT_H(timer + 1) = 0;
+	REG_TMCNT_L(timer) = 0;
+	REG_TMCNT_L(timer + 1) = 0;
+	REG_TMCNT_H(timer + 1) = TIMER_START | TIMER_COUNT;
+	REG_TMCNT_H(timer) = TIMER_START | frequency;
+}
+
+/*! \fn u32 timerReadCascaded(int timer)
+	\brief Read a 32 bit count from two cascaded timers.
+	\param timer The low timer, timer + 1 counts its overflows with \c TIMER_COUNT.
+	\return The high timer in the upper 16 bits and the low timer in the lower.
+
+	The high timer is read again if the low one overflowed in between.
+*/
+static inline u32 timerReadCascaded(int timer) {
+	u16 high, low;
+
+	do {
+		high = REG_TMCNT_L(timer + 1);
+		low = REG_TMCNT_L(timer);
+	} while ( high != REG_TMCNT_L(timer + 1));
+
+	return ((u32)high << 16) | low;
+}
 
 //---------------------------------------------------------------------------------
 #ifdef __cplusplus
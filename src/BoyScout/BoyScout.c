@@ -21,60 +21,24 @@
 #include "BoyScout.h"
 #include "GBASoundRegs.h"
 
-// GLOBALS ////////
-
-unsigned char g_cSound1Patterns;		// Pattern counts
-unsigned char g_cSound2Patterns;
-unsigned char g_cSound3Patterns;
-unsigned char g_cSound4Patterns;
-
-unsigned short g_nSongLength;			// Song length
-
-unsigned char g_nSequencerBeatsPerRow;	// Beats per sequencer row
-
-unsigned char g_nBeatLength;			// Length of a beat
-
-
-// WK
-unsigned char g_nPlaySpeed;             // The playback speed
-
-int g_nMuteChannel1;                    // Lets add some Mute options
-int g_nMuteChannel2;
-int g_nMuteChannel3;
-int g_nMuteChannel4;
+#include <string.h>
 
+#include <gba_base.h>
+#include <gba_interrupt.h>
+#include <gba_timers.h>
 
-unsigned char g_cSound3WaveForms;		// Wave form count
-unsigned int *g_pSound3WaveForms;		// Wave forms
-short g_nSound3PlayWaveForm;			// Wave form in playing buffer
-unsigned char g_iSound3PlayBank;		// Which buffer playing waveform resides
+// Cycles per frame divided by the 64 cycle timer prescaler
+#define TIMER_TICKS_PER_FRAME	4389
 
-unsigned char *g_apSequencerParams[SOUND_CHANNEL_COUNT];	// Sequencer parameters
-SRLEIterator g_aRLESequencer[SOUND_CHANNEL_COUNT];			// Sequencer iterators
-
-SSound1Pattern *g_pSound1Patterns;					// Sound channel patterns
-SSound2Pattern *g_pSound2Patterns;
-SSound3Pattern *g_pSound3Patterns;
-SSound4Pattern *g_pSound4Patterns;
-
-SRLEIterator g_aRLESound1[SOUND1_PARAMETER_COUNT];	// Sound channel iterators
-SRLEIterator g_aRLESound2[SOUND2_PARAMETER_COUNT];
-SRLEIterator g_aRLESound3[SOUND3_PARAMETER_COUNT];
-SRLEIterator g_aRLESound4[SOUND4_PARAMETER_COUNT];
+// GLOBALS ////////
 
-unsigned char g_nPlayState;							// Current play state
-int g_iTickCounter;									// Tick counterint g_iPlayPosition;								// Current play position
-int g_iBeatsPerRowCounter;							// Counter for sequencer update
-int g_iPlayPosition;								// Current play position
-short g_aiPlayPatterns[SOUND_CHANNEL_COUNT];		// Current play patterns
-int g_aiPlayPatternPositions[SOUND_CHANNEL_COUNT];	// Current play positions in patterns
+SBoyScoutPlayer g_BoyScoutMusic;						// Player used until another is selected
+SBoyScoutPlayer *g_pBoyScoutPlayer = &g_BoyScoutMusic;	// Player the song functions work on
 
-short g_anSound1Params[SOUND1_PARAMETER_COUNT];		// Current channel parameters
-short g_anSound2Params[SOUND2_PARAMETER_COUNT];
-short g_anSound3Params[SOUND3_PARAMETER_COUNT];
-short g_anSound4Params[SOUND4_PARAMETER_COUNT];
+SBoyScoutPlayer *g_apBoyScoutPlayers[BOYSCOUT_MAX_PLAYERS];	// Players sharing the sound channels
+int g_cBoyScoutPlayers = 0;
 
-unsigned int g_nBoyScoutMemoryArea;	// Address to a free memory area which BS needs
+int g_nPlayTimer = -1;					// Timer driving playback, -1 if driven by BoyScoutUpdateSong
 
 const unsigned short canNoteFrequencies[72] = {
 44,		// C3
@@ -152,6 +116,11 @@ const unsigned short canNoteFrequencies[72] = {
 
 // FUNCTIONS //////
 
+// Also called from the IWRAM timer handler, which can't reach ROM with a plain branch.
+// It stays in ROM with the static helpers it calls, so in timer mode each row is
+// played from ROM inside the interrupt
+static int BoyScoutPlayRow(SBoyScoutPlayer *pPlayer) __attribute__((long_call));
+
 /////////////////////////////////////////////////////////////////
 // Function: RLEISet                                           //
 //                                                             //
@@ -258,53 +227,42 @@ void DMA3Copy32(unsigned int Src, unsigned int Dst, unsigned short Count) ////
 // End of DMA3Copy32
 
 ///////////////////////////////////////////////////////
-// Function: BoyScoutInitialize                      //
+// Function: BoyScoutInitPlayer                      //
 //                                                   //
-// Description: Initializes all internal parameters. //
+// Description: Initializes the parameters of a      //
+//              player.                              //
 //                                                   //
-void BoyScoutInitialize() /////////////////////////////
+// Parameters: The player.                           //
+//                                                   //
+static void BoyScoutInitPlayer(SBoyScoutPlayer *pPlayer)
 {
-    // Loop variable
-    int i;
-
-    g_cSound1Patterns = 0;
-    g_cSound2Patterns = 0;
-    g_cSound3Patterns = 0;
-    g_cSound4Patterns = 0;
+	// Speeds, mutes and positions all start at 0
+	memset(pPlayer, 0, sizeof(SBoyScoutPlayer));
 
-    g_nSongLength = 0;
-    g_nSequencerBeatsPerRow = 0;
-    g_nBeatLength = 0;
+	// No song until one is opened
+	pPlayer->pSong = &pPlayer->Song;
 
-    // WK Some inits
-    g_nPlaySpeed = 0;
-    g_nMuteChannel1 = 0;
-    g_nMuteChannel2 = 0;
-    g_nMuteChannel3 = 0;
-    g_nMuteChannel4 = 0;
+	pPlayer->nPlayState = PLAYSTATE_STOP;
 
-    g_cSound3WaveForms = 0;
-    g_pSound3WaveForms = 0;
-
-    g_pSound1Patterns = 0;
-    g_pSound2Patterns = 0;
-    g_pSound3Patterns = 0;
-    g_pSound4Patterns = 0;
-
-    g_nPlayState = PLAYSTATE_STOP;
-	g_iTickCounter = 0;
-    g_iPlayPosition = 0;
-    g_iBeatsPerRowCounter = 0;
+	// Default memory to beginning of external RAM, unchecked
+	pPlayer->nMemoryArea = 0x02000000;
+}
+// End of BoyScoutInitPlayer
 
-	// Default memory to beginning of external RAM
-	g_nBoyScoutMemoryArea = 0x02000000;
+///////////////////////////////////////////////////////
+// Function: BoyScoutInitialize                      //
+//                                                   //
+// Description: Initializes all internal parameters, //
+//              leaving only the default player.     //
+//                                                   //
+void BoyScoutInitialize() /////////////////////////////
+{
+	BoyScoutStopTimer();
 
-	for(i = 0; i < SOUND_CHANNEL_COUNT; i++)
-	{
-		g_apSequencerParams[i] = 0;
-		g_aiPlayPatterns[i] = 0;
-		g_aiPlayPatternPositions[i] = 0;
-	}
+	BoyScoutInitPlayer(&g_BoyScoutMusic);
+	g_pBoyScoutPlayer = &g_BoyScoutMusic;
+	g_apBoyScoutPlayers[0] = &g_BoyScoutMusic;
+	g_cBoyScoutPlayers = 1;
 
 	// Set the all sound sound operate flag with sound channels
 	SGCNT1 = SGCNT1ALLSNDOPERATE | SGCNT1SND1OPERATE | SGCNT1SND2OPERATE | SGCNT1SND3OPERATE | SGCNT1SND4OPERATE;
@@ -320,75 +278,68 @@ void BoyScoutInitialize() /////////////////////////////
 // End of BoyScoutInitialize
 
 /////////////////////////////////////////////////////////////////
-// Function: BoyScoutOpenSong                                  //
+// Function: BoyScoutLoadSong                                  //
 //                                                             //
-// Description: Setup the neccessary structures and parameters //
-//				to allow music playback of song                //
+// Description: Parses a song into its pattern tables, so it   //
+//              can be played with BoyScoutSetSong.            //
 //                                                             //
-// Parameters: Pointer to exported song data.                  //
+// Parameters: Song to set up, pointer to exported song data   //
+//             and the arena to take the tables from.          //
 //                                                             //
-void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
+// Returns: 0 if the arena doesn't have room for the song.     //
+//                                                             //
+int BoyScoutLoadSong(SBoyScoutSong *pSong, const unsigned char *pSongData, SBoyScoutArena *pArena)
 {
 	// Loop variable
 	int i,j;
 
-	// Address to memory for pattern storage
-	unsigned int dwMemAddress;
-
 	// Storage of compressed data size
 	unsigned short wCompressedSize;
 
+	// Leave everything as it was if the song doesn't fit
+	if(BoyScoutGetNeededSongMemory(pSongData) > BoyScoutArenaGetFree(pArena))
+		return(0);
+
 	// First 4 bytes is song size parameter - go past this
 	pSongData += 4;
 
 	// Get sound pattern counts - 1 byte each
-	g_cSound1Patterns = *pSongData;
+	pSong->cSound1Patterns = *pSongData;
 	pSongData++;
-	g_cSound2Patterns = *pSongData;
+	pSong->cSound2Patterns = *pSongData;
 	pSongData++;
-	g_cSound3Patterns = *pSongData;
+	pSong->cSound3Patterns = *pSongData;
 	pSongData++;
-	g_cSound4Patterns = *pSongData;
+	pSong->cSound4Patterns = *pSongData;
 	pSongData++;
 
 	// Get song length - 2 bytes
-	g_nSongLength = pSongData[0] | (pSongData[1]<<8);
+	pSong->nSongLength = pSongData[0] | (pSongData[1]<<8);
 	pSongData += 2;
 
 	// Get sequencer beats per row - 1 byte
-	g_nSequencerBeatsPerRow = *pSongData;
+	pSong->nSequencerBeatsPerRow = *pSongData;
 	pSongData++;
 
 	// Get beat length - 1 byte
-	g_nBeatLength = *pSongData;
-    g_nPlaySpeed = g_nBeatLength;
+	pSong->nBeatLength = *pSongData;
 	pSongData++;
 
-	// Set to beginning of BoyScout memory area
-	dwMemAddress = g_nBoyScoutMemoryArea;
+	// Allocate the pattern tables
+	pSong->pSound1Patterns = (SSound1Pattern*)BoyScoutArenaAlloc(pArena, sizeof(SSound1Pattern)*pSong->cSound1Patterns);
+	pSong->pSound2Patterns = (SSound2Pattern*)BoyScoutArenaAlloc(pArena, sizeof(SSound2Pattern)*pSong->cSound2Patterns);
+	pSong->pSound3Patterns = (SSound3Pattern*)BoyScoutArenaAlloc(pArena, sizeof(SSound3Pattern)*pSong->cSound3Patterns);
+	pSong->pSound4Patterns = (SSound4Pattern*)BoyScoutArenaAlloc(pArena, sizeof(SSound4Pattern)*pSong->cSound4Patterns);
 
-	// "Allocate" sound 1 patterns
-	g_pSound1Patterns = (SSound1Pattern*)dwMemAddress;
-	dwMemAddress += sizeof(SSound1Pattern)*g_cSound1Patterns;
-
-	// "Allocate" sound 2 patterns
-	g_pSound2Patterns = (SSound2Pattern*)dwMemAddress;
-	dwMemAddress += sizeof(SSound2Pattern)*g_cSound2Patterns;
-
-	// "Allocate" sound 3 patterns
-	g_pSound3Patterns = (SSound3Pattern*)dwMemAddress;
-	dwMemAddress += sizeof(SSound3Pattern)*g_cSound3Patterns;
-
-	// "Allocate" sound 4 patterns
-	g_pSound4Patterns = (SSound4Pattern*)dwMemAddress;
-	dwMemAddress += sizeof(SSound4Pattern)*g_cSound4Patterns;
+	pSong->nSongCompiled = 0;
 
 	// Get sound 1 pattern data
-	for(i = 0; i < g_cSound1Patterns; i++)
+	for(i = 0; i < pSong->cSound1Patterns; i++)
 	{
 		// Get pattern length - 2 bytes
-		g_pSound1Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
+		pSong->pSound1Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
 		pSongData += 2;
+		pSong->pSound1Patterns[i].pRows = 0;
 
 		// Get pattern parameter pointers
 		for(j = 0; j < SOUND1_PARAMETER_COUNT; j++)
@@ -398,7 +349,7 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 			pSongData += 2;
 
 			// Set pointer to parameter compressed data
-			g_pSound1Patterns[i].apParams[j] = (unsigned char *)pSongData;
+			pSong->pSound1Patterns[i].apParams[j] = (unsigned char *)pSongData;
 
 			// Move past compressed data
 			pSongData += wCompressedSize;
@@ -406,11 +357,12 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 	}
 
 	// Get sound 2 pattern data
-	for(i = 0; i < g_cSound2Patterns; i++)
+	for(i = 0; i < pSong->cSound2Patterns; i++)
 	{
 		// Get pattern length - 2 bytes
-		g_pSound2Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
+		pSong->pSound2Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
 		pSongData += 2;
+		pSong->pSound2Patterns[i].pRows = 0;
 
 		// Get pattern parameter pointers - 2 bytes
 		for(j = 0; j < SOUND2_PARAMETER_COUNT; j++)
@@ -420,7 +372,7 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 			pSongData += 2;
 
 			// Set pointer to parameter compressed data
-			g_pSound2Patterns[i].apParams[j] = (unsigned char *)pSongData;
+			pSong->pSound2Patterns[i].apParams[j] = (unsigned char *)pSongData;
 
 			// Move past compressed data
 			pSongData += wCompressedSize;
@@ -428,11 +380,12 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 	}
 
 	// Get sound 3 pattern data
-	for(i = 0; i < g_cSound3Patterns; i++)
+	for(i = 0; i < pSong->cSound3Patterns; i++)
 	{
 		// Get pattern length - 2 bytes
-		g_pSound3Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
+		pSong->pSound3Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
 		pSongData += 2;
+		pSong->pSound3Patterns[i].pRows = 0;
 
 		// Get pattern parameter pointers
 		for(j = 0; j < SOUND3_PARAMETER_COUNT; j++)
@@ -442,7 +395,7 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 			pSongData += 2;
 
 			// Set pointer to parameter compressed data
-			g_pSound3Patterns[i].apParams[j] = (unsigned char *)pSongData;
+			pSong->pSound3Patterns[i].apParams[j] = (unsigned char *)pSongData;
 
 			// Move past compressed data
 			pSongData += wCompressedSize;
@@ -450,11 +403,12 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 	}
 
 	// Get sound 4 pattern data
-	for(i = 0; i < g_cSound4Patterns; i++)
+	for(i = 0; i < pSong->cSound4Patterns; i++)
 	{
 		// Get pattern length - 2 bytes
-		g_pSound4Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
+		pSong->pSound4Patterns[i].nLength = pSongData[0] | (pSongData[1]<<8);
 		pSongData += 2;
+		pSong->pSound4Patterns[i].pRows = 0;
 
 		// Get pattern parameter pointers
 		for(j = 0; j < SOUND4_PARAMETER_COUNT; j++)
@@ -464,7 +418,7 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 			pSongData += 2;
 
 			// Set pointer to parameter compressed data
-			g_pSound4Patterns[i].apParams[j] = (unsigned char *)pSongData;
+			pSong->pSound4Patterns[i].apParams[j] = (unsigned char *)pSongData;
 
 			// Move past compressed data
 			pSongData += wCompressedSize;
@@ -472,28 +426,28 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 	}
 
 	// Get wave form count - 1 byte
-	g_cSound3WaveForms = *pSongData;
+	pSong->cSound3WaveForms = *pSongData;
 	pSongData++;
 
 	// If there are wave forms
-	if(g_cSound3WaveForms > 0)
+	if(pSong->cSound3WaveForms > 0)
 	{
 		
 		// WM - adjust pointer to waveform for alignment
  
 		// Set pointers to wave form data
 		pSongData = (unsigned char*)(((unsigned int)pSongData +3) & -4);
-		g_pSound3WaveForms = (unsigned int *)pSongData;
+		pSong->pSound3WaveForms = (unsigned int *)pSongData;
 
 		// copy bytes
 		//int i;
-		//unsigned char *src = (unsigned char *)pSongData, *dst = (unsigned char *)g_pSound3WaveForms;
-		//for (i = 0; i < (g_cSound3WaveForms * 16); i++) {
+		//unsigned char *src = (unsigned char *)pSongData, *dst = (unsigned char *)pSong->pSound3WaveForms;
+		//for (i = 0; i < (pSong->cSound3WaveForms * 16); i++) {
 
 		//	*(dst++) = *(src++);
 		//}
 		// Move past wave form data - 16 bytes per wave form data
-		pSongData += g_cSound3WaveForms*16;
+		pSongData += pSong->cSound3WaveForms*16;
 	}
 
 	// Get sequencer parameter data
@@ -504,14 +458,590 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 		pSongData += 2;
 
 		// Set pointer to parameter compressed data
-		g_apSequencerParams[i] = (unsigned char *)pSongData;
+		pSong->apSequencerParams[i] = (unsigned char *)pSongData;
 
 		// Move past compressed data
 		pSongData += wCompressedSize;
 	}
+
+	return(1);
+}
+// End of BoyScoutLoadSong
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutMemoryAreaArena                           //
+//                                                             //
+// Description: Sets up an arena over the memory area of a     //
+//              player, past the memory already in use.        //
+//                                                             //
+// Parameters: The player, bytes in use and the arena.         //
+//                                                             //
+static void BoyScoutMemoryAreaArena(SBoyScoutPlayer *pPlayer, unsigned int nUsed, SBoyScoutArena *pArena)
+{
+	if(pPlayer->nMemorySize)
+		BoyScoutArenaInit(pArena, pPlayer->nMemoryArea, pPlayer->nMemorySize);
+	else
+	{
+		// Without a size the area runs to the end of memory
+		pArena->nAddress = (pPlayer->nMemoryArea + BOYSCOUT_MEMORY_ALIGN-1) & ~(BOYSCOUT_MEMORY_ALIGN-1);
+		pArena->nEnd = 0xFFFFFFFF;
+	}
+
+	// Skip what is in use
+	if(BoyScoutArenaAlloc(pArena, nUsed) == 0)
+		pArena->nAddress = pArena->nEnd;
+}
+// End of BoyScoutMemoryAreaArena
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutOpenSong                                  //
+//                                                             //
+// Description: Setup the neccessary structures and parameters //
+//				to allow music playback of song                //
+//                                                             //
+// Parameters: Pointer to exported song data.                  //
+//                                                             //
+// Returns: 0 if the song doesn't fit in the memory area set   //
+//          with BoyScoutSetMemoryAreaSize.                    //
+//                                                             //
+int BoyScoutOpenSong(const unsigned char *pSongData) ////////////
+{
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+	SBoyScoutArena Arena;
+	unsigned int nStart;
+
+	// Pattern tables from the beginning of the memory area
+	BoyScoutMemoryAreaArena(pPlayer, 0, &Arena);
+	nStart = Arena.nAddress;
+
+	if(!BoyScoutLoadSong(&pPlayer->Song, pSongData, &Arena))
+		return(0);
+
+	// Memory used so far, compiled rows go after this
+	pPlayer->nMemoryUsed = Arena.nAddress - nStart;
+
+	BoyScoutSetSong(&pPlayer->Song);
+
+	return(1);
 }
 // End of BoyScoutOpenSong
 
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutSetSong                                   //
+//                                                             //
+// Description: Switches the selected player to a loaded song, //
+//              stopping any playback.                         //
+//                                                             //
+// Parameters: The song.                                       //
+//                                                             //
+void BoyScoutSetSong(SBoyScoutSong *pSong) //////////////////////
+{
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+	// Loop variable
+	int i;
+
+	// The play positions belong to the old song
+	pPlayer->nPlayState = PLAYSTATE_STOP;
+
+	pPlayer->pSong = pSong;
+
+	pPlayer->nPlaySpeed = pSong->nBeatLength;
+	pPlayer->nPlaySpeedFixed = pSong->nBeatLength<<16;
+
+	for(i = 0; i < SOUND_CHANNEL_COUNT; i++)
+		pPlayer->apPlayRows[i] = 0;
+}
+// End of BoyScoutSetSong
+
+//////////////////////////////////////////////////////////////////
+// Function: BoyScoutCompilePattern                             //
+//                                                              //
+// Description: Converts the parameter streams of one pattern   //
+//              to row records, or only counts their size.      //
+//                                                              //
+// Parameters: Parameter streams and count, pattern length and  //
+//             destination, 0 to only count.                    //
+//                                                              //
+// Returns: Size of the records in halfwords.                   //
+//                                                              //
+static unsigned int BoyScoutCompilePattern(unsigned char **apParams, int nParams, int nLength, unsigned short *pDst)
+{
+	// Loop variables
+	int i, iRow;
+
+	// Iterators for each parameter
+	SRLEIterator aRLE[SOUND1_PARAMETER_COUNT];
+
+	unsigned int nSize = 0;
+	unsigned short nMask, nCount;
+
+	for(i = 0; i < nParams; i++)
+		RLEISet(apParams[i], &aRLE[i]);
+
+	for(iRow = 0; iRow < nLength; iRow++)
+	{
+		nMask = 0;
+		nCount = 0;
+
+		// Store only the parameters set on this row
+		for(i = 0; i < nParams; i++)
+		{
+			if(aRLE[i].nValue != PATTERN_PARAMETER_EMPTY)
+			{
+				nMask |= 1<<i;
+				nCount++;
+				if(pDst)
+					pDst[nSize + nCount] = aRLE[i].nValue;
+			}
+		}
+
+		if(pDst)
+			pDst[nSize] = nMask | (nCount<<8);
+		nSize += 1 + nCount;
+
+		// Playback doesn't step past the last row
+		if(iRow < nLength-1)
+		{
+			for(i = 0; i < nParams; i++)
+				RLEINext(&aRLE[i]);
+		}
+	}
+
+	return(nSize);
+}
+// End of BoyScoutCompilePattern
+
+//////////////////////////////////////////////////////////////////
+// Function: BoyScoutCompilePatterns                            //
+//                                                              //
+// Description: Compiles or counts all patterns of the song.    //
+//                                                              //
+// Parameters: Destination, 0 to only count.                    //
+//                                                              //
+// Returns: Size of the records in halfwords.                   //
+//                                                              //
+static unsigned int BoyScoutCompilePatterns(SBoyScoutSong *pSong, unsigned short *pDst)
+{
+	// Loop variable
+	int i;
+
+	unsigned int nSize = 0;
+
+	for(i = 0; i < pSong->cSound1Patterns; i++)
+	{
+		if(pDst)
+			pSong->pSound1Patterns[i].pRows = pDst + nSize;
+		nSize += BoyScoutCompilePattern(pSong->pSound1Patterns[i].apParams, SOUND1_PARAMETER_COUNT, pSong->pSound1Patterns[i].nLength, pDst ? pDst + nSize : 0);
+	}
+
+	for(i = 0; i < pSong->cSound2Patterns; i++)
+	{
+		if(pDst)
+			pSong->pSound2Patterns[i].pRows = pDst + nSize;
+		nSize += BoyScoutCompilePattern(pSong->pSound2Patterns[i].apParams, SOUND2_PARAMETER_COUNT, pSong->pSound2Patterns[i].nLength, pDst ? pDst + nSize : 0);
+	}
+
+	for(i = 0; i < pSong->cSound3Patterns; i++)
+	{
+		if(pDst)
+			pSong->pSound3Patterns[i].pRows = pDst + nSize;
+		nSize += BoyScoutCompilePattern(pSong->pSound3Patterns[i].apParams, SOUND3_PARAMETER_COUNT, pSong->pSound3Patterns[i].nLength, pDst ? pDst + nSize : 0);
+	}
+
+	for(i = 0; i < pSong->cSound4Patterns; i++)
+	{
+		if(pDst)
+			pSong->pSound4Patterns[i].pRows = pDst + nSize;
+		nSize += BoyScoutCompilePattern(pSong->pSound4Patterns[i].apParams, SOUND4_PARAMETER_COUNT, pSong->pSound4Patterns[i].nLength, pDst ? pDst + nSize : 0);
+	}
+
+	return(nSize);
+}
+// End of BoyScoutCompilePatterns
+
+//////////////////////////////////////////////////////////////////
+// Function: BoyScoutGetNeededLoadedCompiledMemory              //
+//                                                              //
+// Description: Calculates the memory needed to compile a song. //
+//                                                              //
+// Parameters: The loaded song.                                 //
+//                                                              //
+// Returns: The needed size in bytes.                           //
+//                                                              //
+unsigned int BoyScoutGetNeededLoadedCompiledMemory(const SBoyScoutSong *pSong)
+{
+	unsigned int nSize;
+
+	nSize = BoyScoutCompilePatterns((SBoyScoutSong *)pSong, 0) * 2;
+
+	return((nSize + BOYSCOUT_MEMORY_ALIGN-1) & ~(BOYSCOUT_MEMORY_ALIGN-1));
+}
+// End of BoyScoutGetNeededLoadedCompiledMemory
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutSongPlaying                        //
+//                                                      //
+// Description: Checks if any player is playing a song. //
+//                                                      //
+// Parameters: The song.                                //
+//                                                      //
+// Returns: Non zero if the song is playing.            //
+//                                                      //
+static int BoyScoutSongPlaying(const SBoyScoutSong *pSong)
+{
+	// Loop variable
+	int i;
+
+	for(i = 0; i < g_cBoyScoutPlayers; i++)
+	{
+		if(g_apBoyScoutPlayers[i]->pSong == pSong && (g_apBoyScoutPlayers[i]->nPlayState & PLAYSTATE_PLAY))
+			return(1);
+	}
+
+	return(0);
+}
+// End of BoyScoutSongPlaying
+
+//////////////////////////////////////////////////////////////////
+// Function: BoyScoutCompileLoadedSong                          //
+//                                                              //
+// Description: Compiles the patterns of a loaded song to row   //
+//              records taken from an arena. A song being       //
+//              played can't be compiled, as the player would   //
+//              switch format in the middle of its patterns.    //
+//                                                              //
+// Parameters: The loaded song and the arena.                   //
+//                                                              //
+// Returns: 0 if the arena doesn't have room for the records,   //
+//          or the song is playing.                             //
+//                                                              //
+int BoyScoutCompileLoadedSong(SBoyScoutSong *pSong, SBoyScoutArena *pArena)
+{
+	unsigned short *pDst;
+	unsigned int nSize;
+
+	if(BoyScoutSongPlaying(pSong))
+		return(0);
+
+	nSize = BoyScoutGetNeededLoadedCompiledMemory(pSong);
+	if(nSize > BoyScoutArenaGetFree(pArena))
+		return(0);
+
+	pDst = (unsigned short *)BoyScoutArenaAlloc(pArena, nSize);
+
+	BoyScoutCompilePatterns(pSong, pDst);
+	pSong->nSongCompiled = 1;
+
+	return(1);
+}
+// End of BoyScoutCompileLoadedSong
+
+/////////////////////////////////////////////////////////////////////
+// Function: BoyScoutGetNeededCompiledMemory                       //
+//                                                                 //
+// Description: Calculates the extra memory needed in the BoyScout //
+//              memory area to compile the currently open song.    //
+//                                                                 //
+// Returns: The needed size in bytes.                              //
+//                                                                 //
+unsigned int BoyScoutGetNeededCompiledMemory() //////////////////////
+{
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+	return(BoyScoutGetNeededLoadedCompiledMemory(pPlayer->pSong));
+}
+// End of BoyScoutGetNeededCompiledMemory
+
+//////////////////////////////////////////////////////////////////////
+// Function: BoyScoutCompileSong                                    //
+//                                                                  //
+// Description: Compiles the patterns of the currently open song to //
+//              row records, placed in the BoyScout memory area     //
+//              after the pattern structures. Call before playback. //
+//                                                                  //
+// Returns: The memory used by the records in bytes, 0 if they      //
+//          don't fit in the memory area or the song is playing.    //
+//                                                                  //
+unsigned int BoyScoutCompileSong() ///////////////////////////////////
+{
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+	SBoyScoutArena Arena;
+
+	// Records go after the pattern tables
+	BoyScoutMemoryAreaArena(pPlayer, pPlayer->nMemoryUsed, &Arena);
+
+	if(!BoyScoutCompileLoadedSong(pPlayer->pSong, &Arena))
+		return(0);
+
+	return(BoyScoutGetNeededLoadedCompiledMemory(pPlayer->pSong));
+}
+// End of BoyScoutCompileSong
+
+/////////////////////////////////////////////////////////
+// Function: BoyScoutRowStruck                         //
+//                                                     //
+// Description: Checks the current row of a channel.   //
+//                                                     //
+// Parameters: Channel, its iterators and parameter    //
+//             count.                                  //
+//                                                     //
+// Returns: Non zero if a note is struck on the row.   //
+//                                                     //
+static inline int BoyScoutRowStruck(SBoyScoutPlayer *pPlayer, int nChannel, SRLEIterator *aRLE, int nParams)
+{
+	if(pPlayer->pSong->nSongCompiled)
+		return(pPlayer->apPlayRows[nChannel][0] & (1<<(nParams-1)));
+
+	return(aRLE[nParams-1].nValue != PATTERN_PARAMETER_EMPTY);
+}
+// End of BoyScoutRowStruck
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutRowParams                          //
+//                                                      //
+// Description: Gets the parameters set on the current  //
+//              row of a channel.                       //
+//                                                      //
+// Parameters: Channel, its iterators, parameter count  //
+//             and the channel parameters to update.    //
+//                                                      //
+static inline void BoyScoutRowParams(SBoyScoutPlayer *pPlayer, int nChannel, SRLEIterator *aRLE, int nParams, short *anParams)
+{
+	// Loop variable
+	int i;
+
+	unsigned short nMask, *pValue;
+
+	if(pPlayer->pSong->nSongCompiled)
+	{
+		nMask = pPlayer->apPlayRows[nChannel][0];
+		pValue = &pPlayer->apPlayRows[nChannel][1];
+		for(i = 0; i < nParams; i++)
+		{
+			if(nMask & (1<<i))
+				anParams[i] = *pValue++;
+		}
+	}
+	else
+	{
+		for(i = 0; i < nParams; i++)
+		{
+			if(aRLE[i].nValue != PATTERN_PARAMETER_EMPTY)
+				anParams[i] = aRLE[i].nValue;
+		}
+	}
+}
+// End of BoyScoutRowParams
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutNextRow                            //
+//                                                      //
+// Description: Steps a channel to its next row.        //
+//                                                      //
+// Parameters: Channel, its iterators and parameter     //
+//             count.                                   //
+//                                                      //
+static inline void BoyScoutNextRow(SBoyScoutPlayer *pPlayer, int nChannel, SRLEIterator *aRLE, int nParams)
+{
+	// Loop variable
+	int i;
+
+	if(pPlayer->pSong->nSongCompiled)
+	{
+		pPlayer->apPlayRows[nChannel] += 1 + (pPlayer->apPlayRows[nChannel][0]>>8);
+	}
+	else
+	{
+		for(i = 0; i < nParams; i++)
+			RLEINext(&aRLE[i]);
+	}
+}
+// End of BoyScoutNextRow
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutSetPattern                         //
+//                                                      //
+// Description: Starts a channel at the first row of a  //
+//              pattern.                                //
+//                                                      //
+// Parameters: Channel, pattern parameter streams and   //
+//             rows, iterators and parameter count.     //
+//                                                      //
+static inline void BoyScoutSetPattern(SBoyScoutPlayer *pPlayer, int nChannel, unsigned char **apParams, unsigned short *pRows, SRLEIterator *aRLE, int nParams)
+{
+	// Loop variable
+	int i;
+
+	if(pPlayer->pSong->nSongCompiled)
+	{
+		pPlayer->apPlayRows[nChannel] = pRows;
+	}
+	else
+	{
+		for(i = 0; i < nParams; i++)
+			RLEISet(apParams[i], &aRLE[i]);
+	}
+}
+// End of BoyScoutSetPattern
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutSound3WaveForm                     //
+//                                                      //
+// Description: Gets the wave form set on the current   //
+//              row of sound 3.                         //
+//                                                      //
+// Returns: The wave form or PATTERN_PARAMETER_EMPTY.   //
+//                                                      //
+static inline short BoyScoutSound3WaveForm(SBoyScoutPlayer *pPlayer)
+{
+	unsigned short nMask;
+
+	if(pPlayer->pSong->nSongCompiled)
+	{
+		// No pattern played yet, the iterators start out at wave form 0
+		if(pPlayer->apPlayRows[2] == 0)
+			return(0);
+
+		nMask = pPlayer->apPlayRows[2][0];
+		if(!(nMask & 4))
+			return(PATTERN_PARAMETER_EMPTY);
+
+		// Skip the values of parameters 0 and 1
+		return(pPlayer->apPlayRows[2][1 + (nMask & 1) + ((nMask>>1) & 1)]);
+	}
+
+	return(pPlayer->aRLESound3[2].nValue);
+}
+// End of BoyScoutSound3WaveForm
+
+/////////////////////////////////////////////////////////////
+// Function: BoyScoutOwnedChannels                         //
+//                                                         //
+// Description: Finds the channels not taken by a playing  //
+//              player of higher priority.                 //
+//                                                         //
+// Parameters: The player.                                 //
+//                                                         //
+// Returns: Bit per free channel.                          //
+//                                                         //
+static unsigned char BoyScoutOwnedChannels(SBoyScoutPlayer *pPlayer)
+{
+	// Loop variables
+	int i, j;
+
+	SBoyScoutPlayer *pOther;
+	unsigned char nOwned = (1<<SOUND_CHANNEL_COUNT) - 1;
+
+	for(i = 0; i < g_cBoyScoutPlayers; i++)
+	{
+		pOther = g_apBoyScoutPlayers[i];
+
+		if(pOther->nPriority <= pPlayer->nPriority || (pOther->nPlayState & PLAYSTATE_STOP))
+			continue;
+
+		for(j = 0; j < SOUND_CHANNEL_COUNT; j++)
+		{
+			if(pOther->aiPlayPatterns[j] != PATTERN_PARAMETER_EMPTY)
+				nOwned &= ~(1<<j);
+		}
+	}
+
+	return(nOwned);
+}
+// End of BoyScoutOwnedChannels
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutAddPlayer                                 //
+//                                                             //
+// Description: Initializes a player and lets it share the     //
+//              sound channels. Select it and set its memory   //
+//              area before opening a song with it.            //
+//                                                             //
+// Parameters: The player and its priority, the default player //
+//             has priority 0.                                 //
+//                                                             //
+void BoyScoutAddPlayer(SBoyScoutPlayer *pPlayer, int nPriority) //
+{
+	// Interrupt state, the timer goes through the players
+	u16 nIME = REG_IME;
+	REG_IME = 0;
+
+	BoyScoutRemovePlayer(pPlayer);
+
+	if(g_cBoyScoutPlayers < BOYSCOUT_MAX_PLAYERS)
+	{
+		BoyScoutInitPlayer(pPlayer);
+		pPlayer->nPriority = nPriority;
+
+		g_apBoyScoutPlayers[g_cBoyScoutPlayers++] = pPlayer;
+	}
+
+	REG_IME = nIME;
+}
+// End of BoyScoutAddPlayer
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutRemovePlayer                              //
+//                                                             //
+// Description: Stops a player sharing the sound channels, the //
+//              default player is selected if it was selected. //
+//                                                             //
+// Parameters: The player.                                     //
+//                                                             //
+void BoyScoutRemovePlayer(SBoyScoutPlayer *pPlayer) /////////////
+{
+	// Loop variable
+	int i;
+
+	// Interrupt state, the timer goes through the players
+	u16 nIME = REG_IME;
+	REG_IME = 0;
+
+	for(i = 0; i < g_cBoyScoutPlayers; i++)
+	{
+		if(g_apBoyScoutPlayers[i] == pPlayer)
+		{
+			pPlayer->nPlayState = PLAYSTATE_STOP;
+
+			g_cBoyScoutPlayers--;
+			for(; i < g_cBoyScoutPlayers; i++)
+				g_apBoyScoutPlayers[i] = g_apBoyScoutPlayers[i+1];
+			break;
+		}
+	}
+
+	if(g_pBoyScoutPlayer == pPlayer)
+		g_pBoyScoutPlayer = &g_BoyScoutMusic;
+
+	REG_IME = nIME;
+}
+// End of BoyScoutRemovePlayer
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutSelectPlayer                              //
+//                                                             //
+// Description: Selects the player the song functions work on. //
+//                                                             //
+// Parameters: The player, 0 for the default player.           //
+//                                                             //
+void BoyScoutSelectPlayer(SBoyScoutPlayer *pPlayer) /////////////
+{
+	g_pBoyScoutPlayer = pPlayer ? pPlayer : &g_BoyScoutMusic;
+}
+// End of BoyScoutSelectPlayer
+
+SBoyScoutPlayer *BoyScoutGetPlayer()
+{
+	return g_pBoyScoutPlayer;
+}
+
 //////////////////////////////////////////////////////////////
 // Function: BoyScoutPlaySong                               //
 //                                                          //
@@ -521,102 +1051,99 @@ void BoyScoutOpenSong(const unsigned char *pSongData) ///////////
 //                                                          //
 void BoyScoutPlaySong(int nLoop) /////////////////////////////
 {
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
 	// Loop variable
 	int i;
 
-	// If playing - return
-	if(g_nPlayState & PLAYSTATE_PLAY)
-		return;
+	// Wave form of the first row
+	short nWaveForm;
 
-	// Set play state
-	g_nPlayState = PLAYSTATE_PLAY;
+	// Interrupt state
+	u16 nIME;
 
-	// If to loop
-	if(nLoop)
-		g_nPlayState |= PLAYSTATE_LOOP;
+	// If playing - return
+	if(pPlayer->nPlayState & PLAYSTATE_PLAY)
+		return;
 
 	// Reset play positions
-	g_iPlayPosition = 0;
-	g_iTickCounter = g_nBeatLength; // Make it start playback immediately next V-Blank
-	g_iBeatsPerRowCounter = 0;
+	pPlayer->iPlayPosition = 0;
+	pPlayer->iBeatsPerRowCounter = 0;
 
 	for(i = 0; i < SOUND_CHANNEL_COUNT; i++)
 	{
-		g_aiPlayPatternPositions[i] = 0;
+		pPlayer->aiPlayPatternPositions[i] = 0;
 
 		// Set sequencer iterators
-		RLEISet(g_apSequencerParams[i], &g_aRLESequencer[i]);
+		RLEISet(pPlayer->pSong->apSequencerParams[i], &pPlayer->aRLESequencer[i]);
 	}
 
 	// Get pattern indices from sequencer
 	for(i = 0; i < SOUND_CHANNEL_COUNT; i++)
-		g_aiPlayPatterns[i] = g_aRLESequencer[i].nValue;
+		pPlayer->aiPlayPatterns[i] = pPlayer->aRLESequencer[i].nValue;
 
 	// If a sound 1 pattern is set in sequencer
-	if(g_aiPlayPatterns[0] != PATTERN_PARAMETER_EMPTY)
+	if(pPlayer->aiPlayPatterns[0] != PATTERN_PARAMETER_EMPTY)
 	{
-		for(i = 0; i < SOUND1_PARAMETER_COUNT; i++)
-		{
-			RLEISet(g_pSound1Patterns[g_aiPlayPatterns[0]].apParams[i], &g_aRLESound1[i]);
-		}
+		BoyScoutSetPattern(pPlayer, 0, pPlayer->pSong->pSound1Patterns[pPlayer->aiPlayPatterns[0]].apParams, pPlayer->pSong->pSound1Patterns[pPlayer->aiPlayPatterns[0]].pRows, pPlayer->aRLESound1, SOUND1_PARAMETER_COUNT);
 	}
 
 	// If a sound 2 pattern is set in sequencer
-	if(g_aiPlayPatterns[1] != PATTERN_PARAMETER_EMPTY)
+	if(pPlayer->aiPlayPatterns[1] != PATTERN_PARAMETER_EMPTY)
 	{
-		for(i = 0; i < SOUND2_PARAMETER_COUNT; i++)
-		{
-			RLEISet(g_pSound2Patterns[g_aiPlayPatterns[1]].apParams[i], &g_aRLESound2[i]);
-		}
+		BoyScoutSetPattern(pPlayer, 1, pPlayer->pSong->pSound2Patterns[pPlayer->aiPlayPatterns[1]].apParams, pPlayer->pSong->pSound2Patterns[pPlayer->aiPlayPatterns[1]].pRows, pPlayer->aRLESound2, SOUND2_PARAMETER_COUNT);
 	}
 
 	// If a sound 3 pattern is set in sequencer
-	if(g_aiPlayPatterns[2] != PATTERN_PARAMETER_EMPTY)
+	if(pPlayer->aiPlayPatterns[2] != PATTERN_PARAMETER_EMPTY)
 	{
-		for(i = 0; i < SOUND3_PARAMETER_COUNT; i++)
-		{
-			RLEISet(g_pSound3Patterns[g_aiPlayPatterns[2]].apParams[i], &g_aRLESound3[i]);
-		}
+		BoyScoutSetPattern(pPlayer, 2, pPlayer->pSong->pSound3Patterns[pPlayer->aiPlayPatterns[2]].apParams, pPlayer->pSong->pSound3Patterns[pPlayer->aiPlayPatterns[2]].pRows, pPlayer->aRLESound3, SOUND3_PARAMETER_COUNT);
 	}
 
 	// If a sound 4 pattern is set in sequencer
-	if(g_aiPlayPatterns[3] != PATTERN_PARAMETER_EMPTY)
+	if(pPlayer->aiPlayPatterns[3] != PATTERN_PARAMETER_EMPTY)
 	{
-		for(i = 0; i < SOUND4_PARAMETER_COUNT; i++)
-		{
-			RLEISet(g_pSound4Patterns[g_aiPlayPatterns[3]].apParams[i], &g_aRLESound4[i]);
-		}
+		BoyScoutSetPattern(pPlayer, 3, pPlayer->pSong->pSound4Patterns[pPlayer->aiPlayPatterns[3]].apParams, pPlayer->pSong->pSound4Patterns[pPlayer->aiPlayPatterns[3]].pRows, pPlayer->aRLESound4, SOUND4_PARAMETER_COUNT);
 	}
 
 	// Reset sound channels' parameters
 	for(i = 0; i < SOUND1_PARAMETER_COUNT; i++)
-		g_anSound1Params[i] = 0;
+		pPlayer->anSound1Params[i] = 0;
 	for(i = 0; i < SOUND2_PARAMETER_COUNT; i++)
-		g_anSound2Params[i] = 0;
+		pPlayer->anSound2Params[i] = 0;
 	for(i = 0; i < SOUND3_PARAMETER_COUNT; i++)
-		g_anSound3Params[i] = 0;
+		pPlayer->anSound3Params[i] = 0;
 	for(i = 0; i < SOUND4_PARAMETER_COUNT; i++)
-		g_anSound4Params[i] = 0;
+		pPlayer->anSound4Params[i] = 0;
 
 	// Default envelopes
-	g_anSound1Params[0] = 15;
-	g_anSound2Params[0] = 15;
-	g_anSound3Params[0] = 4;
-	g_anSound4Params[0] = 15;
+	pPlayer->anSound1Params[0] = 15;
+	pPlayer->anSound2Params[0] = 15;
+	pPlayer->anSound3Params[0] = 4;
+	pPlayer->anSound4Params[0] = 15;
 
 	// Init wave buffers
-	g_iSound3PlayBank = 1;
-	g_nSound3PlayWaveForm = PATTERN_PARAMETER_EMPTY;
+	pPlayer->iSound3PlayBank = 1;
+	pPlayer->nSound3PlayWaveForm = PATTERN_PARAMETER_EMPTY;
+	pPlayer->nSound3WaveForm = PATTERN_PARAMETER_EMPTY;
 
-	// If a new waveform is set
-	if(g_aRLESound3[2].nValue != PATTERN_PARAMETER_EMPTY)
+	// Channels not taken by higher priority players
+	pPlayer->nOwnedChannels = BoyScoutOwnedChannels(pPlayer);
+	pPlayer->nStruckChannels = 0;
+
+	// If a valid waveform is set
+	nWaveForm = BoyScoutSound3WaveForm(pPlayer);
+	if(nWaveForm != PATTERN_PARAMETER_EMPTY && nWaveForm < pPlayer->pSong->cSound3WaveForms)
 	{
-		// If a valid wave form
-		if(g_aRLESound3[2].nValue < g_cSound3WaveForms)
+		pPlayer->nSound3WaveForm = nWaveForm;
+
+		// If channel 3 is ours, otherwise it is loaded once it is free
+		if(pPlayer->nOwnedChannels & 4)
 		{
 			
             // Set wave form
-			g_nSound3PlayWaveForm = g_aRLESound3[2].nValue;
+			pPlayer->nSound3PlayWaveForm = nWaveForm;
 
 			// Copy waveform to bank 0
 			SG30L = SG30LSTEP32	| SG30LSETBANK1;
@@ -625,12 +1152,12 @@ void BoyScoutPlaySong(int nLoop) /////////////////////////////
 
             #if(USE_DMA)
 
-            DMA3Copy32((unsigned int)&g_pSound3WaveForms[4*g_nSound3PlayWaveForm], (unsigned int)&SGWRAM, 4);
+            DMA3Copy32((unsigned int)&pPlayer->pSong->pSound3WaveForms[4*pPlayer->nSound3PlayWaveForm], (unsigned int)&SGWRAM, 4);
 
             #else
 
 			unsigned int *pDst, *pSrc;
-			pSrc = (unsigned int*)&g_pSound3WaveForms[4*g_nSound3PlayWaveForm];
+			pSrc = (unsigned int*)&pPlayer->pSong->pSound3WaveForms[4*pPlayer->nSound3PlayWaveForm];
 			pDst = (unsigned int*)&SGWRAM;
 			pDst[0] = pSrc[0];
 			pDst[1] = pSrc[1];
@@ -640,7 +1167,7 @@ void BoyScoutPlaySong(int nLoop) /////////////////////////////
             #endif
 
 				// Set to correct bank
-//			if(g_iSound3PlayBank == 1)
+//			if(pPlayer->iSound3PlayBank == 1)
 			SG30L = SG30LSTEP32 | SG30LSETBANK0;
 //				else
 //					SG30L = SG30LSTEP32 | SG30LSETBANK1;
@@ -648,6 +1175,21 @@ void BoyScoutPlaySong(int nLoop) /////////////////////////////
 
 		}
 	}
+
+	// Set play state last, so the timer interrupt never plays a half set up player
+	nIME = REG_IME;
+	REG_IME = 0;
+
+	pPlayer->iTickCounter = pPlayer->pSong->nBeatLength; // Make it start playback immediately next V-Blank
+	pPlayer->nTickAccumulator = pPlayer->nPlaySpeedFixed > (1<<16) ? pPlayer->nPlaySpeedFixed - (1<<16) : 0;	// And for the timer
+
+	pPlayer->nPlayState = PLAYSTATE_PLAY;
+
+	// If to loop
+	if(nLoop)
+		pPlayer->nPlayState |= PLAYSTATE_LOOP;
+
+	REG_IME = nIME;
 }
 // End of BoyScoutPlaySong
 
@@ -658,8 +1200,11 @@ void BoyScoutPlaySong(int nLoop) /////////////////////////////
 //                                                           //
 void BoyScoutStopSong() ///////////////////////////////////////
 {
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
 	// Set stop
-	g_nPlayState = PLAYSTATE_STOP;
+	pPlayer->nPlayState = PLAYSTATE_STOP;
 }
 // End of BoyScoutStopSong
 
@@ -676,20 +1221,24 @@ void BoyScoutStopSong() ///////////////////////////////////////
 //                                                                             //
 int BoyScoutUpdateSong() ////////////////////////////////////////////////////////
 {
-	// Loop variable
-	int i;
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
 
 	// If not playing
-	if(g_nPlayState & PLAYSTATE_STOP)
+	if(pPlayer->nPlayState & PLAYSTATE_STOP)
 		return(0);
 
+	// The timer plays the rows
+	if(g_nPlayTimer >= 0)
+		return(1);
+
 	// Update tick counter
-	g_iTickCounter++;
+	pPlayer->iTickCounter++;
 
     // WK add time influencing
 
 	// If song shouldn't be updated yet
-	if(g_iTickCounter < g_nPlaySpeed)
+	if(pPlayer->iTickCounter < pPlayer->nPlaySpeed)
 	{
 		return(1);
 	}
@@ -697,321 +1246,413 @@ int BoyScoutUpdateSong() ///////////////////////////////////////////////////////
 	else
 	{
 		// Reset tick counter
-		g_iTickCounter = 0;
+		pPlayer->iTickCounter = 0;
+	}
+
+	return(BoyScoutPlayRow(pPlayer));
+}
+// End of BoyScoutUpdateSong
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutUpdateAllSongs                            //
+//                                                             //
+// Description: Updates the song playback of every player, in  //
+//              place of BoyScoutUpdateSong.                   //
+//                                                             //
+// Returns: 0 when none of the players are playing.            //
+//                                                             //
+int BoyScoutUpdateAllSongs() /////////////////////////////////////
+{
+	// Loop variable
+	int i;
+
+	SBoyScoutPlayer *pSelected = g_pBoyScoutPlayer;
+	int nPlaying = 0;
+
+	for(i = 0; i < g_cBoyScoutPlayers; i++)
+	{
+		g_pBoyScoutPlayer = g_apBoyScoutPlayers[i];
+		nPlaying |= BoyScoutUpdateSong();
+	}
+
+	g_pBoyScoutPlayer = pSelected;
+
+	return(nPlaying);
+}
+// End of BoyScoutUpdateAllSongs
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutWriteSound1                        //
+//                                                      //
+// Description: Writes the sound 1 registers from the   //
+//              current parameters.                     //
+//                                                      //
+// Parameters: The player and SG11INIT to strike the    //
+//             note, 0 to only set the registers.       //
+//                                                      //
+static void BoyScoutWriteSound1(SBoyScoutPlayer *pPlayer, unsigned short nInit)
+{
+	// Restart the channel before changing it
+	if(nInit)
+		SG11 |= SG11INIT;
+
+	// If envelope steps is negative
+	if(pPlayer->anSound1Params[1] <= 0)
+	{
+		SG10H = SG10HSNDLENGTH(pPlayer->anSound1Params[2]) | SG10HWAVEDUTYCYCLE(pPlayer->anSound1Params[3]) | SG10HENVELOPESTEPS(-pPlayer->anSound1Params[1]) | 
+				SG10HENVELOPEDEC | SG10HENVELOPEINIT(pPlayer->anSound1Params[0]);
+	}
+	else
+	{
+		SG10H = SG10HSNDLENGTH(pPlayer->anSound1Params[2]) | SG10HWAVEDUTYCYCLE(pPlayer->anSound1Params[3]) | SG10HENVELOPESTEPS(pPlayer->anSound1Params[1]) | 
+				SG10HENVELOPEINC | SG10HENVELOPEINIT(pPlayer->anSound1Params[0]);
 	}
 
+	// If sweep shifts is negative
+	if(pPlayer->anSound1Params[4] <= 0)
+	{
+		SG10L = SG10LSWEEPSHIFTS(-pPlayer->anSound1Params[4]) | SG10LSWEEPSHIFTDEC | SG10LSWEEPTIME(pPlayer->anSound1Params[5]);
+	}
+	else
+	{
+		SG10L = SG10LSWEEPSHIFTS(pPlayer->anSound1Params[4]) | SG10LSWEEPSHIFTINC | SG10LSWEEPTIME(pPlayer->anSound1Params[5]);
+	}
+
+	SG11  = SG11FREQUENCY(canNoteFrequencies[pPlayer->anSound1Params[6]-36]) | SG11PLAYONCE;	
+	if(nInit)
+		SG11 |= nInit;
+}
+// End of BoyScoutWriteSound1
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutWriteSound2                        //
+//                                                      //
+// Description: Writes the sound 2 registers from the   //
+//              current parameters.                     //
+//                                                      //
+// Parameters: The player and SG21INIT to strike the    //
+//             note, 0 to only set the registers.       //
+//                                                      //
+static void BoyScoutWriteSound2(SBoyScoutPlayer *pPlayer, unsigned short nInit)
+{
+	// If envelope steps is negative
+	if(pPlayer->anSound2Params[1] <= 0)
+	{
+		SG20 = SG20SNDLENGTH(pPlayer->anSound2Params[2]) | SG20WAVEDUTYCYCLE(pPlayer->anSound2Params[3]) | SG20ENVELOPESTEPS(-pPlayer->anSound2Params[1]) | 
+				SG20ENVELOPEDEC | SG20ENVELOPEINIT(pPlayer->anSound2Params[0]);
+	}
+	else
+	{
+		SG20 = SG20SNDLENGTH(pPlayer->anSound2Params[2]) | SG20WAVEDUTYCYCLE(pPlayer->anSound2Params[3]) | SG20ENVELOPESTEPS(pPlayer->anSound2Params[1]) | 
+				SG20ENVELOPEINC | SG20ENVELOPEINIT(pPlayer->anSound2Params[0]);
+	}
+
+	SG21  = SG21FREQUENCY(canNoteFrequencies[pPlayer->anSound2Params[4]-36]) | SG21PLAYONCE | nInit;
+}
+// End of BoyScoutWriteSound2
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutWriteSound3                        //
+//                                                      //
+// Description: Writes the sound 3 registers from the   //
+//              current parameters, selecting the bank  //
+//              with the loaded wave form.              //
+//                                                      //
+// Parameters: The player and SG31INIT to strike the    //
+//             note, 0 to only set the registers.       //
+//                                                      //
+static void BoyScoutWriteSound3(SBoyScoutPlayer *pPlayer, unsigned short nInit)
+{
+	// Set to correct bank
+	if(pPlayer->iSound3PlayBank == 1)
+		SG30L = SG30LSTEP32 | SG30LSETBANK0;
+	else
+		SG30L = SG30LSTEP32 | SG30LSETBANK1;
+
+	// WM reordered to work on hardware
+	SG30L	|=	SG30LPLAY;
+
+	SG30H = SG30HSNDLENGTH(pPlayer->anSound3Params[1]);
+
+	// Envelope
+	switch(pPlayer->anSound3Params[0])
+	{
+	case 0:
+		{
+			SG30H |= SG30HOUTPUTMUTE;
+		}break;
+	case 1:
+		{
+			SG30H |= SG30HOUTPUT14;
+		}break;
+	case 2:
+		{
+			SG30H |= SG30HOUTPUT12;
+		}break;
+	case 3:
+		{
+			SG30H |= SG30HOUTPUT34;
+		}break;
+	case 4:
+		{
+			SG30H |= SG30HOUTPUT1;
+		}break;
+	default:break;
+	}
+
+	SG31  = SG31FREQUENCY(canNoteFrequencies[pPlayer->anSound3Params[3]-36]) | SG31PLAYONCE | nInit;
+}
+// End of BoyScoutWriteSound3
+
+//////////////////////////////////////////////////////////
+// Function: BoyScoutWriteSound4                        //
+//                                                      //
+// Description: Writes the sound 4 registers from the   //
+//              current parameters.                     //
+//                                                      //
+// Parameters: The player and SG41INIT to strike the    //
+//             note, 0 to only set the registers.       //
+//                                                      //
+static void BoyScoutWriteSound4(SBoyScoutPlayer *pPlayer, unsigned short nInit)
+{
+	// Envelope steps
+	if(pPlayer->anSound4Params[1] <= 0)
+	{
+		SG40 = SG40SNDLENGTH(pPlayer->anSound4Params[2]) | SG40ENVELOPESTEPS(-pPlayer->anSound4Params[1]) | SG40ENVELOPEDEC | SG40ENVELOPEINIT(pPlayer->anSound4Params[0]);
+	}
+	else
+	{
+		SG40 = SG40SNDLENGTH(pPlayer->anSound4Params[2]) | SG40ENVELOPESTEPS(pPlayer->anSound4Params[1]) | SG40ENVELOPEINC | SG40ENVELOPEINIT(pPlayer->anSound4Params[0]);
+	}
+
+	// Poly steps
+	if(pPlayer->anSound4Params[5])
+	{
+		SG41 = SG41DIVRATIOFREQSEL(pPlayer->anSound4Params[3]) | SG41STEPS7 | SG41SHIFTFREQ(pPlayer->anSound4Params[4]) | SG41PLAYONCE | nInit;
+	}
+	else
+	{
+		SG41 = SG41DIVRATIOFREQSEL(pPlayer->anSound4Params[3]) | SG41STEPS15 | SG41SHIFTFREQ(pPlayer->anSound4Params[4]) | SG41PLAYONCE | nInit;
+	}
+}
+// End of BoyScoutWriteSound4
+
+/////////////////////////////////////////////////////////////////
+// Function: BoyScoutPlayRow                                   //
+//                                                             //
+// Description: Plays the current row and steps to the next.   //
+//                                                             //
+// Returns: If not set to looping, returns 0 when finished     //
+//          playback of song.                                  //
+//                                                             //
+static int BoyScoutPlayRow(SBoyScoutPlayer *pPlayer) ////////////////////////////////////
+{
+	// Loop variable
+	int i;
+
+	// Wave form of the next row
+	short nWaveForm;
+
+	// Channels free now, handed back by a higher priority player and written on this row
+	unsigned char nOwned, nRegained, nWritten = 0;
+
+	// Channels handed back by a higher priority player have to get our
+	// waveform and registers back
+	nOwned = BoyScoutOwnedChannels(pPlayer);
+	nRegained = nOwned & ~pPlayer->nOwnedChannels;
+	if(nRegained & 4)
+		pPlayer->nSound3PlayWaveForm = PATTERN_PARAMETER_EMPTY;
+	pPlayer->nOwnedChannels = nOwned;
+
 	// PLAY SONG FROM CURRENT STEP ////
 
 	// If a sound 1 pattern is playing
-	if( g_aiPlayPatterns[0] != PATTERN_PARAMETER_EMPTY )
+	if( pPlayer->aiPlayPatterns[0] != PATTERN_PARAMETER_EMPTY )
 	{
 		// If a note is struck
-		if(g_aRLESound1[SOUND1_PARAMETER_COUNT-1].nValue != PATTERN_PARAMETER_EMPTY )
+		if(BoyScoutRowStruck(pPlayer, 0, pPlayer->aRLESound1, SOUND1_PARAMETER_COUNT))
 		{
-			if(g_nMuteChannel1 == 0)
+			// Get parameters
+			if(pPlayer->nMuteChannel1 == 0)
 			{
-				// Set sound channel 1 to ON
-//				SGCNT1 |= SGCNT1SND1OPERATE;
-				SG11 |= SG11INIT;
-
-				// Get parameters
-				for(i = 0; i < SOUND1_PARAMETER_COUNT; i++)
-				{
-					if(g_aRLESound1[i].nValue != PATTERN_PARAMETER_EMPTY)
-						g_anSound1Params[i] = g_aRLESound1[i].nValue;
-				}
-
-				// If envelope steps is negative
-				if(g_anSound1Params[1] <= 0)
-				{
-					SG10H = SG10HSNDLENGTH(g_anSound1Params[2]) | SG10HWAVEDUTYCYCLE(g_anSound1Params[3]) | SG10HENVELOPESTEPS(-g_anSound1Params[1]) | 
-							SG10HENVELOPEDEC | SG10HENVELOPEINIT(g_anSound1Params[0]);
-				}
-				else
-				{
-					SG10H = SG10HSNDLENGTH(g_anSound1Params[2]) | SG10HWAVEDUTYCYCLE(g_anSound1Params[3]) | SG10HENVELOPESTEPS(g_anSound1Params[1]) | 
-							SG10HENVELOPEINC | SG10HENVELOPEINIT(g_anSound1Params[0]);
-				}
-		
-				// If sweep shifts is negative
-				if(g_anSound1Params[4] <= 0)
-				{
-					SG10L = SG10LSWEEPSHIFTS(-g_anSound1Params[4]) | SG10LSWEEPSHIFTDEC | SG10LSWEEPTIME(g_anSound1Params[5]);
-				}
-				else
-				{
-					SG10L = SG10LSWEEPSHIFTS(g_anSound1Params[4]) | SG10LSWEEPSHIFTINC | SG10LSWEEPTIME(g_anSound1Params[5]);
-				}
-
-				SG11  = SG11FREQUENCY(canNoteFrequencies[g_anSound1Params[6]-36]) | SG11PLAYONCE;	
-				SG11 |= SG11INIT;
+				BoyScoutRowParams(pPlayer, 0, pPlayer->aRLESound1, SOUND1_PARAMETER_COUNT, pPlayer->anSound1Params);
+				pPlayer->nStruckChannels |= 1;
 			}
-			else
+
+			// Leave the registers to a higher priority player
+			if(pPlayer->nMuteChannel1 == 0 && (pPlayer->nOwnedChannels & 1))
 			{
+				BoyScoutWriteSound1(pPlayer, SG11INIT);
+				nWritten |= 1;
 			}
 		}
 
 		// Increment pattern position
-		g_aiPlayPatternPositions[0]++;
+		pPlayer->aiPlayPatternPositions[0]++;
 
 		// If past end
-		if(g_aiPlayPatternPositions[0] >= g_pSound1Patterns[g_aiPlayPatterns[0]].nLength)
+		if(pPlayer->aiPlayPatternPositions[0] >= pPlayer->pSong->pSound1Patterns[pPlayer->aiPlayPatterns[0]].nLength)
 		{
 			// Set to no pattern
-			g_aiPlayPatterns[0] = PATTERN_PARAMETER_EMPTY;
+			pPlayer->aiPlayPatterns[0] = PATTERN_PARAMETER_EMPTY;
 		}
 		// If still in pattern
 		else
 		{
 			// Increment pattern parameter iterators
-			for(i = 0; i < SOUND1_PARAMETER_COUNT; i++)
-			{
-				RLEINext(&g_aRLESound1[i]);
-			}
+			BoyScoutNextRow(pPlayer, 0, pPlayer->aRLESound1, SOUND1_PARAMETER_COUNT);
 		}
 	}
 
 	// If a sound 2 pattern is playing
-	if( g_aiPlayPatterns[1] != PATTERN_PARAMETER_EMPTY )
+	if( pPlayer->aiPlayPatterns[1] != PATTERN_PARAMETER_EMPTY )
 	{
 		// If a note is struck
-		if(g_aRLESound2[SOUND2_PARAMETER_COUNT-1].nValue != PATTERN_PARAMETER_EMPTY)
+		if(BoyScoutRowStruck(pPlayer, 1, pPlayer->aRLESound2, SOUND2_PARAMETER_COUNT))
 		{
-			if(g_nMuteChannel2 == 0)
+			// Get parameters
+			if(pPlayer->nMuteChannel2 == 0)
 			{
-				// Set sound channel 2 to ON
-//				SGCNT1 |= SGCNT1SND2OPERATE;
-
-				// Get parameters
-				for(i = 0; i < SOUND2_PARAMETER_COUNT; i++)
-				{
-					if(g_aRLESound2[i].nValue != PATTERN_PARAMETER_EMPTY)
-						g_anSound2Params[i] = g_aRLESound2[i].nValue;
-				}
-			
-				// If envelope steps is negative
-				if(g_anSound2Params[1] <= 0)
-				{
-					SG20 = SG20SNDLENGTH(g_anSound2Params[2]) | SG20WAVEDUTYCYCLE(g_anSound2Params[3]) | SG20ENVELOPESTEPS(-g_anSound2Params[1]) | 
-							SG20ENVELOPEDEC | SG20ENVELOPEINIT(g_anSound2Params[0]);
-				}
-				else
-				{
-					SG20 = SG20SNDLENGTH(g_anSound2Params[2]) | SG20WAVEDUTYCYCLE(g_anSound2Params[3]) | SG20ENVELOPESTEPS(g_anSound2Params[1]) | 
-							SG20ENVELOPEINC | SG20ENVELOPEINIT(g_anSound2Params[0]);
-				}
-		
-				SG21  = SG21FREQUENCY(canNoteFrequencies[g_anSound2Params[4]-36]) | SG21PLAYONCE | SG21INIT;
-
-				if(canNoteFrequencies[g_anSound2Params[4]-36] == 1985)
-					*(unsigned int*)0x04000000 = 1;
+				BoyScoutRowParams(pPlayer, 1, pPlayer->aRLESound2, SOUND2_PARAMETER_COUNT, pPlayer->anSound2Params);
+				pPlayer->nStruckChannels |= 2;
 			}
-			else
+
+			// Leave the registers to a higher priority player
+			if(pPlayer->nMuteChannel2 == 0 && (pPlayer->nOwnedChannels & 2))
 			{
+				BoyScoutWriteSound2(pPlayer, SG21INIT);
+				nWritten |= 2;
 			}
 		}
 
 		// Increment pattern position
-		g_aiPlayPatternPositions[1]++;
+		pPlayer->aiPlayPatternPositions[1]++;
 
 		// If past end
-		if(g_aiPlayPatternPositions[1] >= g_pSound2Patterns[g_aiPlayPatterns[1]].nLength)
+		if(pPlayer->aiPlayPatternPositions[1] >= pPlayer->pSong->pSound2Patterns[pPlayer->aiPlayPatterns[1]].nLength)
 		{
 			// Set to no pattern
-			g_aiPlayPatterns[1] = PATTERN_PARAMETER_EMPTY;
+			pPlayer->aiPlayPatterns[1] = PATTERN_PARAMETER_EMPTY;
 		}
 		// If still in pattern
 		else
 		{
 			// Increment pattern parameter iterators
-			for(i = 0; i < SOUND2_PARAMETER_COUNT; i++)
-			{
-				RLEINext(&g_aRLESound2[i]);
-			}
+			BoyScoutNextRow(pPlayer, 1, pPlayer->aRLESound2, SOUND2_PARAMETER_COUNT);
 		}
 	}
 
 	// If a sound 3 pattern is playing
-	if( g_aiPlayPatterns[2] != PATTERN_PARAMETER_EMPTY )
+	if( pPlayer->aiPlayPatterns[2] != PATTERN_PARAMETER_EMPTY )
 	{
 		// If a note is struck
-		if(g_aRLESound3[SOUND3_PARAMETER_COUNT-1].nValue != PATTERN_PARAMETER_EMPTY)
+		if(BoyScoutRowStruck(pPlayer, 2, pPlayer->aRLESound3, SOUND3_PARAMETER_COUNT))
 		{
-			if(g_nMuteChannel3 == 0)
+			// Get parameters
+			if(pPlayer->nMuteChannel3 == 0)
 			{
-//				// Set sound channel 3 to ON
-//				SGCNT1 |= SGCNT1SND3OPERATE;
-
-				// Get parameters
-				for(i = 0; i < SOUND3_PARAMETER_COUNT; i++)
-				{
-					if(g_aRLESound3[i].nValue != PATTERN_PARAMETER_EMPTY)
-						g_anSound3Params[i] = g_aRLESound3[i].nValue;
-				}
-
-				// Set to correct bank
-				if(g_iSound3PlayBank == 1)
-					SG30L = SG30LSTEP32 | SG30LSETBANK0;
-				else
-					SG30L = SG30LSTEP32 | SG30LSETBANK1;
-		
-		// WM reordered to work on hardware
-				SG30L	|=	SG30LPLAY;
-
-				SG30H = SG30HSNDLENGTH(g_anSound3Params[1]);
-			
-
-				// Envelope
-				switch(g_anSound3Params[0])
-				{
-				case 0:
-					{
-						SG30H |= SG30HOUTPUTMUTE;
-					}break;
-				case 1:
-					{
-						SG30H |= SG30HOUTPUT14;
-					}break;
-				case 2:
-					{
-						SG30H |= SG30HOUTPUT12;
-					}break;
-				case 3:
-					{
-						SG30H |= SG30HOUTPUT34;
-					}break;
-				case 4:
-					{
-						SG30H |= SG30HOUTPUT1;
-					}break;
-				default:break;
-				}
-
-		
-				SG31  = SG31FREQUENCY(canNoteFrequencies[g_anSound3Params[3]-36]) | SG31PLAYONCE | SG31INIT;
+				BoyScoutRowParams(pPlayer, 2, pPlayer->aRLESound3, SOUND3_PARAMETER_COUNT, pPlayer->anSound3Params);
+				pPlayer->nStruckChannels |= 4;
 			}
-			else
+
+			// Leave the registers to a higher priority player
+			if(pPlayer->nMuteChannel3 == 0 && (pPlayer->nOwnedChannels & 4))
 			{
+				BoyScoutWriteSound3(pPlayer, SG31INIT);
+				nWritten |= 4;
 			}
 		}
 
 		// Increment pattern position
-		g_aiPlayPatternPositions[2]++;
+		pPlayer->aiPlayPatternPositions[2]++;
 
 		// If past end
-		if(g_aiPlayPatternPositions[2] >= g_pSound3Patterns[g_aiPlayPatterns[2]].nLength)
+		if(pPlayer->aiPlayPatternPositions[2] >= pPlayer->pSong->pSound3Patterns[pPlayer->aiPlayPatterns[2]].nLength)
 		{
 			// Set to no pattern
-			g_aiPlayPatterns[2] = PATTERN_PARAMETER_EMPTY;
+			pPlayer->aiPlayPatterns[2] = PATTERN_PARAMETER_EMPTY;
 		}
 		// If still in pattern
 		else
 		{
 			// Increment pattern parameter iterators
-			for(i = 0; i < SOUND3_PARAMETER_COUNT; i++)
-			{
-				RLEINext(&g_aRLESound3[i]);
-			}
+			BoyScoutNextRow(pPlayer, 2, pPlayer->aRLESound3, SOUND3_PARAMETER_COUNT);
 		}
 	}
 
 	// If a sound 4 pattern is playing
-	if( g_aiPlayPatterns[3] != PATTERN_PARAMETER_EMPTY )
+	if( pPlayer->aiPlayPatterns[3] != PATTERN_PARAMETER_EMPTY )
 	{
 		// If a note is struck
-		if(g_aRLESound4[SOUND4_PARAMETER_COUNT-1].nValue != PATTERN_PARAMETER_EMPTY)
+		if(BoyScoutRowStruck(pPlayer, 3, pPlayer->aRLESound4, SOUND4_PARAMETER_COUNT))
 		{
-			if(g_nMuteChannel4 == 0)
+			// Get parameters
+			if(pPlayer->nMuteChannel4 == 0)
 			{
-				// Set sound channel 4 to ON
-//				SGCNT1 |= SGCNT1SND4OPERATE;
-
-				// Get parameters
-				for(i = 0; i < SOUND4_PARAMETER_COUNT; i++)
-				{
-					if(g_aRLESound4[i].nValue != PATTERN_PARAMETER_EMPTY)
-						g_anSound4Params[i] = g_aRLESound4[i].nValue;
-				}
-		
-				// Envelope steps
-				if(g_anSound4Params[1] <= 0)
-				{
-					SG40 = SG40SNDLENGTH(g_anSound4Params[2]) | SG40ENVELOPESTEPS(-g_anSound4Params[1]) | SG40ENVELOPEDEC | SG40ENVELOPEINIT(g_anSound4Params[0]);
-				}
-				else
-				{
-					SG40 = SG40SNDLENGTH(g_anSound4Params[2]) | SG40ENVELOPESTEPS(g_anSound4Params[1]) | SG40ENVELOPEINC | SG40ENVELOPEINIT(g_anSound4Params[0]);
-				}
-		
-				// Poly steps
-				if(g_anSound4Params[5])
-				{
-					SG41 = SG41DIVRATIOFREQSEL(g_anSound4Params[3]) | SG41STEPS7 | SG41SHIFTFREQ(g_anSound4Params[4]) | SG41PLAYONCE | SG41INIT;
-				}
-				else
-				{
-					SG41 = SG41DIVRATIOFREQSEL(g_anSound4Params[3]) | SG41STEPS15 | SG41SHIFTFREQ(g_anSound4Params[4]) | SG41PLAYONCE | SG41INIT;
-				}
+				BoyScoutRowParams(pPlayer, 3, pPlayer->aRLESound4, SOUND4_PARAMETER_COUNT, pPlayer->anSound4Params);
+				pPlayer->nStruckChannels |= 8;
 			}
-			else
+
+			// Leave the registers to a higher priority player
+			if(pPlayer->nMuteChannel4 == 0 && (pPlayer->nOwnedChannels & 8))
 			{
+				BoyScoutWriteSound4(pPlayer, SG41INIT);
+				nWritten |= 8;
 			}
 		}
 
 		// Increment pattern position
-		g_aiPlayPatternPositions[3]++;
+		pPlayer->aiPlayPatternPositions[3]++;
 
 		// If past end
-		if(g_aiPlayPatternPositions[3] >= g_pSound4Patterns[g_aiPlayPatterns[3]].nLength)
+		if(pPlayer->aiPlayPatternPositions[3] >= pPlayer->pSong->pSound4Patterns[pPlayer->aiPlayPatterns[3]].nLength)
 		{
 			// Set to no pattern
-			g_aiPlayPatterns[3] = PATTERN_PARAMETER_EMPTY;
+			pPlayer->aiPlayPatterns[3] = PATTERN_PARAMETER_EMPTY;
 		}
 		// If still in pattern
 		else
 		{
 			// Increment pattern parameter iterators
-			for(i = 0; i < SOUND4_PARAMETER_COUNT; i++)
-			{
-				RLEINext(&g_aRLESound4[i]);
-			}
+			BoyScoutNextRow(pPlayer, 3, pPlayer->aRLESound4, SOUND4_PARAMETER_COUNT);
 		}
 	}
 
 	// UPDATE SONG POSITION ///////////
 
 	// Update beats per row counter
-	g_iBeatsPerRowCounter++;
+	pPlayer->iBeatsPerRowCounter++;
 
 	// Update play position
-	g_iPlayPosition++;
+	pPlayer->iPlayPosition++;
 
 	// If past end
-	if(g_iPlayPosition >= g_nSongLength)
+	if(pPlayer->iPlayPosition >= pPlayer->pSong->nSongLength)
 	{
 		// If to loop
-		if(g_nPlayState & PLAYSTATE_LOOP)
+		if(pPlayer->nPlayState & PLAYSTATE_LOOP)
 		{
 			// Reset to beginning
-			g_iPlayPosition = 0;
+			pPlayer->iPlayPosition = 0;
 
 			// Set beats per row counter to update pattern
-			g_iBeatsPerRowCounter = g_nSequencerBeatsPerRow;
+			pPlayer->iBeatsPerRowCounter = pPlayer->pSong->nSequencerBeatsPerRow;
 
 			// Reset sequencer iterators
 			for(i = 0; i < SOUND_CHANNEL_COUNT; i++)
 			{
-				g_aiPlayPatternPositions[i] = 0;
-				g_aiPlayPatterns[i] = PATTERN_PARAMETER_EMPTY;
+				pPlayer->aiPlayPatternPositions[i] = 0;
+				pPlayer->aiPlayPatterns[i] = PATTERN_PARAMETER_EMPTY;
 
 				// Set sequencer iterators
-				RLEISet(g_apSequencerParams[i], &g_aRLESequencer[i]);
+				RLEISet(pPlayer->pSong->apSequencerParams[i], &pPlayer->aRLESequencer[i]);
 			}
 		}
 		// If to stop
 		else
 		{
-			BoyScoutStopSong();
+			// This player, which in timer mode needn't be the selected one
+			pPlayer->nPlayState = PLAYSTATE_STOP;
 			return(0);
 		}
 	}
@@ -1019,78 +1660,71 @@ int BoyScoutUpdateSong() ///////////////////////////////////////////////////////
 	else
 	{
 		// If sequencer parameters should be updated
-		if(g_iBeatsPerRowCounter >= g_nSequencerBeatsPerRow)
+		if(pPlayer->iBeatsPerRowCounter >= pPlayer->pSong->nSequencerBeatsPerRow)
 		{
 			// Increment sequencer parameter iterators
 			for(i = 0; i < SOUND_CHANNEL_COUNT; i++)
 			{
 				// Get next sequencer step
-				RLEINext(&g_aRLESequencer[i]);
+				RLEINext(&pPlayer->aRLESequencer[i]);
 			}
 		}
 	}
 
 	// If to update patterns
-	if(g_iBeatsPerRowCounter >= g_nSequencerBeatsPerRow)
+	if(pPlayer->iBeatsPerRowCounter >= pPlayer->pSong->nSequencerBeatsPerRow)
 	{
 		// Reset counter
-		g_iBeatsPerRowCounter = 0;
+		pPlayer->iBeatsPerRowCounter = 0;
 
 		// If a sound 1 pattern is set in sequencer
-		if(g_aRLESequencer[0].nValue != PATTERN_PARAMETER_EMPTY)
+		if(pPlayer->aRLESequencer[0].nValue != PATTERN_PARAMETER_EMPTY)
 		{
-			g_aiPlayPatternPositions[0] = 0;
-			g_aiPlayPatterns[0] = g_aRLESequencer[0].nValue;
-			for(i = 0; i < SOUND1_PARAMETER_COUNT; i++)
-			{
-				RLEISet(g_pSound1Patterns[g_aiPlayPatterns[0]].apParams[i], &g_aRLESound1[i]);
-			}
+			pPlayer->aiPlayPatternPositions[0] = 0;
+			pPlayer->aiPlayPatterns[0] = pPlayer->aRLESequencer[0].nValue;
+			BoyScoutSetPattern(pPlayer, 0, pPlayer->pSong->pSound1Patterns[pPlayer->aiPlayPatterns[0]].apParams, pPlayer->pSong->pSound1Patterns[pPlayer->aiPlayPatterns[0]].pRows, pPlayer->aRLESound1, SOUND1_PARAMETER_COUNT);
 		}
 	
 		// If a sound 2 pattern is set in sequencer
-		if(g_aRLESequencer[1].nValue != PATTERN_PARAMETER_EMPTY)
+		if(pPlayer->aRLESequencer[1].nValue != PATTERN_PARAMETER_EMPTY)
 		{
-			g_aiPlayPatternPositions[1] = 0;
-			g_aiPlayPatterns[1] = g_aRLESequencer[1].nValue;
-			for(i = 0; i < SOUND2_PARAMETER_COUNT; i++)
-			{
-				RLEISet(g_pSound2Patterns[g_aiPlayPatterns[1]].apParams[i], &g_aRLESound2[i]);
-			}
+			pPlayer->aiPlayPatternPositions[1] = 0;
+			pPlayer->aiPlayPatterns[1] = pPlayer->aRLESequencer[1].nValue;
+			BoyScoutSetPattern(pPlayer, 1, pPlayer->pSong->pSound2Patterns[pPlayer->aiPlayPatterns[1]].apParams, pPlayer->pSong->pSound2Patterns[pPlayer->aiPlayPatterns[1]].pRows, pPlayer->aRLESound2, SOUND2_PARAMETER_COUNT);
 		}
 
 		// If a sound 3 pattern is set in sequencer
-		if(g_aRLESequencer[2].nValue != PATTERN_PARAMETER_EMPTY)
+		if(pPlayer->aRLESequencer[2].nValue != PATTERN_PARAMETER_EMPTY)
 		{
-			g_aiPlayPatternPositions[2] = 0;
-			g_aiPlayPatterns[2] = g_aRLESequencer[2].nValue;
-			for(i = 0; i < SOUND3_PARAMETER_COUNT; i++)
-			{
-				RLEISet(g_pSound3Patterns[g_aiPlayPatterns[2]].apParams[i], &g_aRLESound3[i]);
-			}
+			pPlayer->aiPlayPatternPositions[2] = 0;
+			pPlayer->aiPlayPatterns[2] = pPlayer->aRLESequencer[2].nValue;
+			BoyScoutSetPattern(pPlayer, 2, pPlayer->pSong->pSound3Patterns[pPlayer->aiPlayPatterns[2]].apParams, pPlayer->pSong->pSound3Patterns[pPlayer->aiPlayPatterns[2]].pRows, pPlayer->aRLESound3, SOUND3_PARAMETER_COUNT);
 		}
 
 		// If a sound 4 pattern is set in sequencer
-		if(g_aRLESequencer[3].nValue != PATTERN_PARAMETER_EMPTY)
+		if(pPlayer->aRLESequencer[3].nValue != PATTERN_PARAMETER_EMPTY)
 		{
-			g_aiPlayPatternPositions[3] = 0;
-			g_aiPlayPatterns[3] = g_aRLESequencer[3].nValue;
-			for(i = 0; i < SOUND4_PARAMETER_COUNT; i++)
-			{
-				RLEISet(g_pSound4Patterns[g_aiPlayPatterns[3]].apParams[i], &g_aRLESound4[i]);
-			}
+			pPlayer->aiPlayPatternPositions[3] = 0;
+			pPlayer->aiPlayPatterns[3] = pPlayer->aRLESequencer[3].nValue;
+			BoyScoutSetPattern(pPlayer, 3, pPlayer->pSong->pSound4Patterns[pPlayer->aiPlayPatterns[3]].apParams, pPlayer->pSong->pSound4Patterns[pPlayer->aiPlayPatterns[3]].pRows, pPlayer->aRLESound4, SOUND4_PARAMETER_COUNT);
 		}
 	}
 
 	// UPDATE SOUND3 WAVE FORM DATA //
 
-	// If a new waveform is set
-	if(g_aRLESound3[2].nValue != g_nSound3PlayWaveForm && g_aRLESound3[2].nValue != PATTERN_PARAMETER_EMPTY)
+	// If a valid waveform is set
+	nWaveForm = BoyScoutSound3WaveForm(pPlayer);
+	if(nWaveForm != PATTERN_PARAMETER_EMPTY && nWaveForm < pPlayer->pSong->cSound3WaveForms)
+		pPlayer->nSound3WaveForm = nWaveForm;
+
+	// If the wanted waveform isn't loaded
+	if(pPlayer->nSound3WaveForm != pPlayer->nSound3PlayWaveForm && pPlayer->nSound3WaveForm != PATTERN_PARAMETER_EMPTY)
 	{
-		// If a valid wave form
-		if(g_aRLESound3[2].nValue < g_cSound3WaveForms)
+		// If channel 3 is ours
+		if(pPlayer->nOwnedChannels & 4)
 		{
 			// Set wave form
-			g_nSound3PlayWaveForm = g_aRLESound3[2].nValue;
+			pPlayer->nSound3PlayWaveForm = pPlayer->nSound3WaveForm;
 
 
             // WK add conditional define, and fix software copy
@@ -1098,12 +1732,12 @@ int BoyScoutUpdateSong() ///////////////////////////////////////////////////////
 			// Copy wave form to WRAM
             #if(USE_DMA)
             
-			DMA3Copy32((unsigned int)&g_pSound3WaveForms[4*g_nSound3PlayWaveForm], (unsigned int)&SGWRAM, 4);
+			DMA3Copy32((unsigned int)&pPlayer->pSong->pSound3WaveForms[4*pPlayer->nSound3PlayWaveForm], (unsigned int)&SGWRAM, 4);
 
             #else
 
 			unsigned int *pDst, *pSrc;
-			pSrc = (unsigned int*)&g_pSound3WaveForms[4*g_nSound3PlayWaveForm];
+			pSrc = (unsigned int*)&pPlayer->pSong->pSound3WaveForms[4*pPlayer->nSound3PlayWaveForm];
 			pDst = (unsigned int*)&SGWRAM;
 			pDst[0] = pSrc[0];
 			pDst[1] = pSrc[1];
@@ -1112,9 +1746,9 @@ int BoyScoutUpdateSong() ///////////////////////////////////////////////////////
 
             #endif
 
-			g_iSound3PlayBank ^= 1;
+			pPlayer->iSound3PlayBank ^= 1;
 /*			// Set to correct bank
-			if(g_iSound3PlayBank == 1)
+			if(pPlayer->iSound3PlayBank == 1)
 				SG30L = SG30LSTEP32 | SG30LSETBANK0;
 			else
 				SG30L = SG30LSTEP32 | SG30LSETBANK1;
@@ -1122,16 +1756,122 @@ int BoyScoutUpdateSong() ///////////////////////////////////////////////////////
 		}
 	}
 
+	// RESTORE REGAINED CHANNELS //////
+
+	// The higher priority player left its settings in the registers, put
+	// back those of our last note, without striking it again
+	nRegained &= pPlayer->nStruckChannels & ~nWritten;
+
+	if((nRegained & 1) && pPlayer->nMuteChannel1 == 0)
+		BoyScoutWriteSound1(pPlayer, 0);
+	if((nRegained & 2) && pPlayer->nMuteChannel2 == 0)
+		BoyScoutWriteSound2(pPlayer, 0);
+	if((nRegained & 4) && pPlayer->nMuteChannel3 == 0)
+		BoyScoutWriteSound3(pPlayer, 0);
+	if((nRegained & 8) && pPlayer->nMuteChannel4 == 0)
+		BoyScoutWriteSound4(pPlayer, 0);
+
 	// Success
 	return(1);
 }
-// End of BoyScoutUpdateSong
+// End of BoyScoutPlayRow
+
+//////////////////////////////////////////////////////////////////
+// Function: BoyScoutTimerTick                                  //
+//                                                              //
+// Description: Timer interrupt handler, called once a frame.   //
+//              Adds a frame to the 16.16 accumulator of each   //
+//              player and plays a row whenever a whole row's   //
+//              worth has passed, so fractional speeds keep     //
+//              exact time.                                     //
+//                                                              //
+IWRAM_CODE static void BoyScoutTimerTick() ///////////////////////
+{
+	// Loop variable
+	int i;
+
+	SBoyScoutPlayer *pPlayer;
+
+	for(i = 0; i < g_cBoyScoutPlayers; i++)
+	{
+		pPlayer = g_apBoyScoutPlayers[i];
+
+		if(pPlayer->nPlayState & PLAYSTATE_STOP)
+			continue;
+
+		pPlayer->nTickAccumulator += 1<<16;
+
+		while(pPlayer->nTickAccumulator >= pPlayer->nPlaySpeedFixed)
+		{
+			pPlayer->nTickAccumulator -= pPlayer->nPlaySpeedFixed;
+
+			if(!BoyScoutPlayRow(pPlayer))
+				break;
+
+			// A zero speed plays a row each tick
+			if(pPlayer->nPlaySpeedFixed == 0)
+				break;
+		}
+	}
+}
+// End of BoyScoutTimerTick
+
+///////////////////////////////////////////////////////////////////
+// Function: BoyScoutStartTimer                                  //
+//                                                               //
+// Description: Lets a timer interrupt drive playback instead of //
+//              BoyScoutUpdateSong, so the tempo doesn't depend  //
+//              on the frame rate of the main loop. The timer    //
+//              fires at exactly the frame rate.                 //
+//                                                               //
+// Parameters: The timer to use, 0 to 3.                         //
+//                                                               //
+// Returns: 0 if the timer number is invalid.                    //
+//                                                               //
+int BoyScoutStartTimer(int nTimer) ////////////////////////////////
+{
+	if(nTimer < 0 || nTimer > 3)
+		return(0);
+
+	BoyScoutStopTimer();
+
+	REG_TMCNT_L(nTimer) = 0x10000 - TIMER_TICKS_PER_FRAME;
+	REG_TMCNT_H(nTimer) = TIMER_START | TIMER_IRQ | TIMER_FREQ_64;
+
+	g_nPlayTimer = nTimer;
+
+	irqSet(IRQ_TIMER0<<nTimer, BoyScoutTimerTick);
+	irqEnable(IRQ_TIMER0<<nTimer);
+
+	return(1);
+}
+// End of BoyScoutStartTimer
+
+/////////////////////////////////////////////////////////
+// Function: BoyScoutStopTimer                         //
+//                                                     //
+// Description: Stops the playback timer, playback is  //
+//              driven by BoyScoutUpdateSong again.    //
+//                                                     //
+void BoyScoutStopTimer() ////////////////////////////////
+{
+	if(g_nPlayTimer < 0)
+		return;
+
+	irqDisable(IRQ_TIMER0<<g_nPlayTimer);
+	REG_TMCNT_H(g_nPlayTimer) = 0;
+
+	g_nPlayTimer = -1;
+}
+// End of BoyScoutStopTimer
 
 //////////////////////////////////////////////////////////////////////
 // Function: BoyScoutGetNeededSongMemory                            //
 //                                                                  //
 // Description: Calculates the needed memory area size needed by a  //
-//              certain BoyScout song.                              //
+//              certain BoyScout song. Exact for an area starting   //
+//              on BOYSCOUT_MEMORY_ALIGN, as the table sizes are    //
+//              multiples of it.                                    //
 //                                                                  //
 // Parameters: Pointer to song data.                                //
 //                                                                  //
@@ -1172,8 +1912,11 @@ unsigned short BoyScoutGetNeededSongMemory(const unsigned char *pSongData)//
 //                                                                   //
 void BoyScoutSetMemoryArea(unsigned int nMemoryAddress) ///////////////
 {
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
 	// Set it
-	g_nBoyScoutMemoryArea = nMemoryAddress;
+	pPlayer->nMemoryArea = nMemoryAddress;
 }
 // End of BoyScoutSetMemoryArea
 
@@ -1186,57 +1929,210 @@ void BoyScoutSetMemoryArea(unsigned int nMemoryAddress) ///////////////
 //                                                                   //
 unsigned int BoyScoutGetMemoryArea() //////////////////////////////////
 {
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
 	// Return it
-	return(g_nBoyScoutMemoryArea);
+	return(pPlayer->nMemoryArea);
 }
 // End of BoyScoutGetMemoryArea
 
+///////////////////////////////////////////////////////////////////////
+// Function: BoyScoutSetMemoryAreaSize                               //
+//                                                                   //
+// Description: Sets the size of the BoyScout memory area, so songs  //
+//				that don't fit are refused instead of running past   //
+//				its end.                                             //
+//                                                                   //
+// Parameters: Size in bytes, 0 to not check.                        //
+//                                                                   //
+void BoyScoutSetMemoryAreaSize(unsigned int nSize) ////////////////////
+{
+	// Player to work on
+	SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+	pPlayer->nMemorySize = nSize;
+}
+// End of BoyScoutSetMemoryAreaSize
+
+///////////////////////////////////////////////////////////////////////
+// Function: BoyScoutArenaInit                                       //
+//                                                                   //
+// Description: Sets up an arena to hand out a pool of memory.       //
+//                                                                   //
+// Parameters: The arena, address and size of the pool.              //
+//                                                                   //
+void BoyScoutArenaInit(SBoyScoutArena *pArena, unsigned int nAddress, unsigned int nSize)
+{
+	pArena->nEnd = nAddress + nSize;
+
+	// Everything is handed out aligned
+	pArena->nAddress = (nAddress + BOYSCOUT_MEMORY_ALIGN-1) & ~(BOYSCOUT_MEMORY_ALIGN-1);
+	if(pArena->nAddress > pArena->nEnd)
+		pArena->nAddress = pArena->nEnd;
+}
+// End of BoyScoutArenaInit
+
+///////////////////////////////////////////////////////////////////////
+// Function: BoyScoutArenaAlloc                                      //
+//                                                                   //
+// Description: Takes memory from an arena.                          //
+//                                                                   //
+// Parameters: The arena and the size in bytes.                      //
+//                                                                   //
+// Returns: Address of the memory, 0 if there isn't enough left.     //
+//                                                                   //
+unsigned int BoyScoutArenaAlloc(SBoyScoutArena *pArena, unsigned int nSize)
+{
+	unsigned int nAddress = pArena->nAddress;
+
+	// Keep the next allocation aligned
+	nSize = (nSize + BOYSCOUT_MEMORY_ALIGN-1) & ~(BOYSCOUT_MEMORY_ALIGN-1);
+
+	if(nSize > pArena->nEnd - nAddress)
+		return(0);
+
+	pArena->nAddress += nSize;
+
+	return(nAddress);
+}
+// End of BoyScoutArenaAlloc
+
+///////////////////////////////////////////////////////////////////////
+// Function: BoyScoutArenaGetFree                                    //
+//                                                                   //
+// Returns: Bytes left in an arena.                                  //
+//                                                                   //
+unsigned int BoyScoutArenaGetFree(const SBoyScoutArena *pArena) ///////
+{
+	return(pArena->nEnd - pArena->nAddress);
+}
+// End of BoyScoutArenaGetFree
+
 // WK increase the speed by a value, on overflow, do nothing
 void BoyScoutIncSpeed(unsigned char speed)
 {
-    BoyScoutSetSpeed( g_nPlaySpeed - speed);
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    BoyScoutSetSpeed( pPlayer->nPlaySpeed - speed);
 }
 
 void BoyScoutDecSpeed(unsigned char speed)
 {
-    BoyScoutSetSpeed( g_nPlaySpeed + speed);
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    BoyScoutSetSpeed( pPlayer->nPlaySpeed + speed);
 }
 
 void BoyScoutSetSpeed(unsigned char speed)
 {
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    // Interrupt state
+    u16 nIME;
+
     if(speed < 30)
-        g_nPlaySpeed = speed;
+    {
+        // The timer interrupt uses the speed and accumulator
+        nIME = REG_IME;
+        REG_IME = 0;
+
+        pPlayer->nPlaySpeed = speed;
+        pPlayer->nPlaySpeedFixed = speed<<16;
+
+        // Don't catch up on rows when speeding up
+        if(pPlayer->nTickAccumulator > pPlayer->nPlaySpeedFixed)
+            pPlayer->nTickAccumulator = pPlayer->nPlaySpeedFixed;
+
+        REG_IME = nIME;
+    }
+}
+
+// Set the speed in 16.16 fixed point frames per row, fractions are only
+// kept when a timer drives playback
+void BoyScoutSetFixedSpeed(unsigned int speed)
+{
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    // Interrupt state
+    u16 nIME;
+
+    if(speed < (30<<16))
+    {
+        // The timer interrupt uses the speed and accumulator
+        nIME = REG_IME;
+        REG_IME = 0;
+
+        pPlayer->nPlaySpeed = speed>>16;
+        pPlayer->nPlaySpeedFixed = speed;
+
+        // Don't catch up on rows when speeding up
+        if(pPlayer->nTickAccumulator > pPlayer->nPlaySpeedFixed)
+            pPlayer->nTickAccumulator = pPlayer->nPlaySpeedFixed;
+
+        REG_IME = nIME;
+    }
+}
+
+unsigned int BoyScoutGetFixedSpeed()
+{
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    return pPlayer->nPlaySpeedFixed;
 }
 
 unsigned char BoyScoutGetNormalSpeed()
 {
-    return g_nBeatLength;
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    return pPlayer->pSong->nBeatLength;
 }
 
 unsigned char BoyScoutGetSpeed()
 {
-    return g_nPlaySpeed;
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    return pPlayer->nPlaySpeed;
 }
 
 
 // WK mute seprate channels
 void BoyScoutMuteChannel1(int mute)
 {
-    g_nMuteChannel1 = mute;
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    pPlayer->nMuteChannel1 = mute;
 }
 
 void BoyScoutMuteChannel2(int mute)
 {
-    g_nMuteChannel2 = mute;
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    pPlayer->nMuteChannel2 = mute;
 }
 
 void BoyScoutMuteChannel3(int mute)
 {
-    g_nMuteChannel3 = mute;
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    pPlayer->nMuteChannel3 = mute;
 }
 
 void BoyScoutMuteChannel4(int mute)
 {
-    g_nMuteChannel4 = mute;
+    // Player to work on
+    SBoyScoutPlayer *pPlayer = g_pBoyScoutPlayer;
+
+    pPlayer->nMuteChannel4 = mute;
 }
 
@@ -10,15 +10,22 @@
 
 // Make sure this header is only included once
 #ifndef HEADER_GBASOUNDREGS_H
-#define HEADER_GBASOUNDREG_H
+#define HEADER_GBASOUNDREGS_H
+
+// Base address of the IO registers. Can be defined before including to
+// point the player at a copy of the registers, eg to run it on a PC
+// against a model of the sound hardware.
+#ifndef BOYSCOUT_REG_BASE
+#define BOYSCOUT_REG_BASE	0x04000000
+#endif
 
 ///////////////////////
 // CONTROL REGISTERS //
 ///////////////////////
 
-#define SGCNT0L		*(unsigned short*)0x04000080	// Final sound control register addresses
-#define SGCNT0H		*(unsigned short*)0x04000082
-#define SGCNT1		*(unsigned short*)0x04000084
+#define SGCNT0L		*(unsigned short*)(BOYSCOUT_REG_BASE + 0x80)	// Final sound control register addresses
+#define SGCNT0H		*(unsigned short*)(BOYSCOUT_REG_BASE + 0x82)
+#define SGCNT1		*(unsigned short*)(BOYSCOUT_REG_BASE + 0x84)
 
 #define SGCNT0LROUT(n)		n			// Right speaker output level (0-7)
 #define SGCNT0LLOUT(n)		(n<<4)		// Left speaker output level (0-7)
@@ -64,9 +71,9 @@
 // SOUND 1 //
 /////////////
 
-#define SG10L	*(unsigned short*)0x04000060		// Addresses of sound 1 registers
-#define SG10H	*(unsigned short*)0x04000062
-#define SG11	*(unsigned short*)0x04000064
+#define SG10L	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x60)		// Addresses of sound 1 registers
+#define SG10H	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x62)
+#define SG11	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x64)
 
 #define SG10LSWEEPSHIFTS(n)		n		// Number of sweep shifts (0-7)
 #define SG10LSWEEPSHIFTINC		(0<<3)	// Number of sweep shifts (0-7)
@@ -89,8 +96,8 @@
 // SOUND 2 //
 /////////////
 
-#define SG20	*(unsigned short*)0x04000068
-#define SG21	*(unsigned short*)0x0400006C
+#define SG20	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x68)
+#define SG21	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x6C)
 
 #define SG20SNDLENGTH(n)		n		// Length of sound (0-63)
 #define SG20WAVEDUTYCYCLE(n)	(n<<6)	// Waveform proportions (0-3)
@@ -108,11 +115,11 @@
 // SOUND 3 //
 /////////////
 
-#define SG30L	*(volatile unsigned short* volatile)0x04000070	// Addresses to sound 3 registers
-#define SG30H	*(volatile unsigned short* volatile)0x04000072
-#define SG31	*(volatile unsigned short* volatile)0x04000074
+#define SG30L	*(volatile unsigned short* volatile)(BOYSCOUT_REG_BASE + 0x70)	// Addresses to sound 3 registers
+#define SG30H	*(volatile unsigned short* volatile)(BOYSCOUT_REG_BASE + 0x72)
+#define SG31	*(volatile unsigned short* volatile)(BOYSCOUT_REG_BASE + 0x74)
 
-#define SGWRAM	*(unsigned short*)0x04000090	// Address of sound 3 wave RAM (16 bytes 4bit/step)
+#define SGWRAM	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x90)	// Address of sound 3 wave RAM (16 bytes 4bit/step)
 
 #define SG30LSTEP32		(0<<5)	// Use two banks of 32 steps each
 #define SG30LSTEP64		(1<<5)	// Use one bank of 64 steps
@@ -137,8 +144,8 @@
 // SOUND 4 //
 /////////////
 
-#define SG40	*(unsigned short*)0x04000078		// Addresses to sound 4 registers
-#define SG41	*(unsigned short*)0x0400007C
+#define SG40	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x78)		// Addresses to sound 4 registers
+#define SG41	*(unsigned short*)(BOYSCOUT_REG_BASE + 0x7C)
 
 #define SG40SNDLENGTH(n)		n		// Sound length (0-63)
 #define SG40ENVELOPESTEPS(n)	(n<<8)	// Envelope steps (0-7)
@@ -158,10 +165,10 @@
 // DMA3 Registers //
 ////////////////////
 
-#define DMA3SRC		*(volatile unsigned int*)0x040000D4   // Source address of transfer (27-bit)
-#define DMA3DST		*(volatile unsigned int*)0x040000D8   // Destination address of transfer (27-bit) 
-#define DMA3COUNT	*(volatile unsigned short*)0x040000DC // Count of characters that should be transferred (14-bit)
-#define DMA3CNT		*(volatile unsigned short*)0x040000DE // DMA3 transfer control register
+#define DMA3SRC		*(volatile unsigned int*)(BOYSCOUT_REG_BASE + 0xD4)   // Source address of transfer (27-bit)
+#define DMA3DST		*(volatile unsigned int*)(BOYSCOUT_REG_BASE + 0xD8)   // Destination address of transfer (27-bit) 
+#define DMA3COUNT	*(volatile unsigned short*)(BOYSCOUT_REG_BASE + 0xDC) // Count of characters that should be transferred (14-bit)
+#define DMA3CNT		*(volatile unsigned short*)(BOYSCOUT_REG_BASE + 0xDE) // DMA3 transfer control register
 
 // Control of destination address for transfer
 #define DMACNTDSTINC		(0<<5)	// Increment
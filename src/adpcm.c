@@ -0,0 +1,210 @@
+/*
+
+	libgba IMA ADPCM streaming
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	A disc stream keeps two blocks, the one being decoded and the next,
+	which adpcmPrefetch reads from the main loop. adpcmRead runs in the
+	mixer's interrupt, so it only ever switches to a block which is
+	already there and never touches the disc.
+
+---------------------------------------------------------------------------------*/
+#include "gba_adpcm.h"
+#include "gba_interrupt.h"
+
+//---------------------------------------------------------------------------------
+// the block after the current one, the first again when looping, -1 at
+// the end of the stream
+//---------------------------------------------------------------------------------
+static s32 adpcmNextBlock(AdpcmStream *stream)
+//---------------------------------------------------------------------------------
+{
+	u32 next = stream->block + 1;
+
+	if ( next * ADPCM_BLOCK_SAMPLES >= stream->samples) return stream->loop ? 0 : -1;
+
+	return next;
+}
+
+//---------------------------------------------------------------------------------
+// makes a block the current one, a disc block has to be in a buffer already
+//---------------------------------------------------------------------------------
+static bool adpcmStartBlock(AdpcmStream *stream, u32 block)
+//---------------------------------------------------------------------------------
+{
+	const u8 *p;
+
+	if ( stream->data) {
+		p = stream->data + block * ADPCM_BLOCK_SIZE;
+	} else {
+		if ( stream->loaded[stream->current] != (s32)block) {
+			if ( stream->loaded[stream->current ^ 1] != (s32)block) return false;
+			stream->current ^= 1;
+		}
+		p = stream->buffer[stream->current];
+	}
+
+	stream->state.predictor = (s16)(p[0] | (p[1] << 8));
+	stream->state.index = ( p[2] > 88) ? 88 : p[2];
+
+	stream->codes = p + ADPCM_HEADER_SIZE;
+	stream->block = block;
+	stream->offset = 0;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+static bool adpcmReadBlock(AdpcmStream *stream, int n, u32 block)
+//---------------------------------------------------------------------------------
+{
+	stream->loaded[n] = -1;
+
+	if ( !stream->disc->readSectors(stream->sector + block, 1, stream->buffer[n])) return false;
+
+	stream->loaded[n] = block;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+void adpcmOpen(AdpcmStream *stream, const u8 *data, u32 samples, bool loop)
+//---------------------------------------------------------------------------------
+{
+	stream->data = data;
+	stream->disc = NULL;
+	stream->samples = samples;
+	stream->loop = loop;
+
+	adpcmRewind(stream);
+}
+
+//---------------------------------------------------------------------------------
+bool adpcmOpenDisc(AdpcmStream *stream, const DISC_INTERFACE *disc, sec_t sector, u32 samples, bool loop)
+//---------------------------------------------------------------------------------
+{
+	stream->data = NULL;
+	stream->disc = disc;
+	stream->sector = sector;
+	stream->samples = samples;
+	stream->loop = loop;
+
+	return adpcmRewind(stream);
+}
+
+//---------------------------------------------------------------------------------
+bool adpcmRewind(AdpcmStream *stream)
+//---------------------------------------------------------------------------------
+{
+	stream->position = 0;
+
+	if ( !stream->data) {
+		stream->current = 0;
+		stream->loaded[1] = -1;
+
+		if ( !adpcmReadBlock(stream, 0, 0)) {
+			// nothing more can be read
+			stream->samples = 0;
+			return false;
+		}
+	}
+
+	adpcmStartBlock(stream, 0);
+
+	// a failed read of the second block is tried again by the next prefetch
+	adpcmPrefetch(stream);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+bool adpcmPrefetch(AdpcmStream *stream)
+//---------------------------------------------------------------------------------
+{
+	s32 next;
+	int n;
+	u16 ime;
+
+	if ( stream->data) return true;
+
+	// the buffer is picked with interrupts off, so adpcmRead can't switch
+	// to it in between
+	ime = REG_IME;
+	REG_IME = 0;
+
+	next = adpcmNextBlock(stream);
+	n = stream->current ^ 1;
+
+	if ( next < 0 || stream->loaded[stream->current] == next || stream->loaded[n] == next) {
+		n = -1;
+	} else {
+		stream->loaded[n] = -1;
+	}
+
+	REG_IME = ime;
+
+	if ( n < 0) return true;
+
+	return adpcmReadBlock(stream, n, next);
+}
+
+//---------------------------------------------------------------------------------
+int adpcmRead(AdpcmStream *stream, s8 *buffer, int samples)
+//---------------------------------------------------------------------------------
+{
+	int done = 0, count;
+
+	while ( done < samples) {
+		if ( stream->position >= stream->samples) {
+			if ( !stream->loop || stream->samples == 0 || !adpcmStartBlock(stream, 0)) break;
+			stream->position = 0;
+		}
+
+		if ( stream->offset == ADPCM_BLOCK_SAMPLES) {
+			if ( !adpcmStartBlock(stream, stream->block + 1)) break;
+		}
+
+		// as far as the end of the block or the stream
+		count = samples - done;
+		if ( count > ADPCM_BLOCK_SAMPLES - stream->offset) count = ADPCM_BLOCK_SAMPLES - stream->offset;
+		if ( count > stream->samples - stream->position) count = stream->samples - stream->position;
+
+		adpcmDecode(&stream->state, stream->codes, stream->offset, buffer + done, count);
+
+		stream->offset += count;
+		stream->position += count;
+		done += count;
+	}
+
+	return done;
+}
+
+//---------------------------------------------------------------------------------
+int adpcmMixerStream(void *stream, s8 *buffer, int samples)
+//---------------------------------------------------------------------------------
+{
+	return adpcmRead((AdpcmStream *)stream, buffer, samples);
+}
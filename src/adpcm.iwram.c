@@ -0,0 +1,95 @@
+/*
+
+	libgba IMA ADPCM decoding kernel
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	Built as ARM code and placed in IWRAM. The tables are not const so
+	they are copied to IWRAM along with the other initialised data, which
+	leaves one code byte per two samples from ROM as the only slow access.
+
+---------------------------------------------------------------------------------*/
+#include "gba_adpcm.h"
+
+//---------------------------------------------------------------------------------
+s16 adpcmStepTable[89] = {
+	7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+	19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+	50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+	130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+	337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+	876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+	2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+	5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+s8 adpcmIndexTable[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+//---------------------------------------------------------------------------------
+IWRAM_CODE void adpcmDecode(AdpcmState *state, const u8 *codes, int offset, s8 *out, int count)
+//---------------------------------------------------------------------------------
+{
+	s32 predictor = state->predictor, index = state->index;
+	s32 step, diff, code;
+
+	codes += offset >> 1;
+
+	while ( count--) {
+		// low nibble first
+		if ( offset & 1) {
+			code = *codes++ >> 4;
+		} else {
+			code = *codes & 15;
+		}
+		offset++;
+
+		step = adpcmStepTable[index];
+
+		diff = step >> 3;
+		if ( code & 4) diff += step;
+		if ( code & 2) diff += step >> 1;
+		if ( code & 1) diff += step >> 2;
+
+		if ( code & 8) {
+			predictor -= diff;
+			if ( predictor < -32768) predictor = -32768;
+		} else {
+			predictor += diff;
+			if ( predictor > 32767) predictor = 32767;
+		}
+
+		index += adpcmIndexTable[code];
+		if ( index < 0) index = 0; else if ( index > 88) index = 88;
+
+		*out++ = predictor >> 8;
+	}
+
+	state->predictor = predictor;
+	state->index = index;
+}
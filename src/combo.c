@@ -0,0 +1,260 @@
+/*
+
+	libgba keypad combo matching
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	All registered combos are compiled into a single automaton, with the
+	fallback transitions filled in ahead of time, so each input symbol costs
+	one table lookup no matter how many combos there are.
+
+	Every state remembers the longest combo ending there and links to the
+	next shorter one, the frame each symbol arrived on is kept in a small
+	history so the time taken by a combo is known from its length.
+
+---------------------------------------------------------------------------------*/
+#include "gba_input.h"
+
+//---------------------------------------------------------------------------------
+#define COMBO_HISTORY	16	// power of 2, at least COMBO_MAX_STEPS
+
+static const u8 *comboSteps[COMBO_MAX_COMBOS];
+static u8 comboLength[COMBO_MAX_COMBOS];
+static u16 comboFrames[COMBO_MAX_COMBOS];
+static int comboCount = 0;
+
+static u8 comboNext[COMBO_MAX_STATES][COMBO_SYMBOLS];
+static s8 comboOutput[COMBO_MAX_STATES];
+static u8 comboOutputLink[COMBO_MAX_STATES];
+static int comboStates = 0;
+
+static u32 comboHistory[COMBO_HISTORY];
+static u32 comboFrame = 0, comboPosition = 0;
+static int comboState = 0, comboMatch = -1;
+static u16 comboLastHeld = 0;
+static int comboLastDir = -1;
+static bool comboFacingLeft = false;
+
+//---------------------------------------------------------------------------------
+// direction symbol from up, down, forward & back, opposite directions cancel
+//---------------------------------------------------------------------------------
+static const u8 comboDirections[16] = {
+	COMBO_NEUTRAL,		COMBO_UP,			COMBO_DOWN,			COMBO_NEUTRAL,
+	COMBO_FORWARD,		COMBO_UP_FORWARD,	COMBO_DOWN_FORWARD,	COMBO_FORWARD,
+	COMBO_BACK,			COMBO_UP_BACK,		COMBO_DOWN_BACK,	COMBO_BACK,
+	COMBO_NEUTRAL,		COMBO_UP,			COMBO_DOWN,			COMBO_NEUTRAL
+};
+
+static const u16 comboButtons[COMBO_SYMBOLS - COMBO_A] = {
+	KEY_A, KEY_B, KEY_L, KEY_R, KEY_START, KEY_SELECT
+};
+
+//---------------------------------------------------------------------------------
+int comboAdd(const u8 *steps, int length, int frames)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	if ( comboCount >= COMBO_MAX_COMBOS || length < 1 || length > COMBO_MAX_STEPS || frames < 0) return -1;
+
+	for ( i = 0; i < length; i++) {
+		if ( steps[i] >= COMBO_SYMBOLS) return -1;
+	}
+
+	comboSteps[comboCount] = steps;
+	comboLength[comboCount] = length;
+	comboFrames[comboCount] = ( frames > 0xffff) ? 0xffff : frames;
+
+	return comboCount++;
+}
+
+//---------------------------------------------------------------------------------
+void comboClear(void)
+//---------------------------------------------------------------------------------
+{
+	comboCount = 0;
+	comboStates = 0;
+	comboReset();
+}
+
+//---------------------------------------------------------------------------------
+bool comboCompile(void)
+//---------------------------------------------------------------------------------
+{
+	u8 fail[COMBO_MAX_STATES];
+	u8 queue[COMBO_MAX_STATES];
+	int head, tail, state, next, symbol, i, j;
+
+	comboStates = 1;
+
+	for ( i = 0; i < COMBO_MAX_STATES; i++) {
+		for ( symbol = 0; symbol < COMBO_SYMBOLS; symbol++) comboNext[i][symbol] = 0xff;
+		comboOutput[i] = -1;
+		comboOutputLink[i] = 0;
+		fail[i] = 0;
+	}
+
+	// build the trie of all the combos
+	for ( i = 0; i < comboCount; i++) {
+		state = 0;
+
+		for ( j = 0; j < comboLength[i]; j++) {
+			symbol = comboSteps[i][j];
+
+			if ( comboNext[state][symbol] == 0xff) {
+				if ( comboStates >= COMBO_MAX_STATES) {
+					comboStates = 0;
+					return false;
+				}
+				comboNext[state][symbol] = comboStates++;
+			}
+			state = comboNext[state][symbol];
+		}
+
+		// the same steps twice, only one of them could ever be reported
+		if ( comboOutput[state] >= 0) {
+			comboStates = 0;
+			return false;
+		}
+		comboOutput[state] = i;
+	}
+
+	// breadth first, fill in the missing transitions from the fallback state
+	head = tail = 0;
+
+	for ( symbol = 0; symbol < COMBO_SYMBOLS; symbol++) {
+		next = comboNext[0][symbol];
+		if ( next == 0xff) {
+			comboNext[0][symbol] = 0;
+		} else {
+			fail[next] = 0;
+			queue[tail++] = next;
+		}
+	}
+
+	while ( head < tail) {
+		state = queue[head++];
+
+		for ( symbol = 0; symbol < COMBO_SYMBOLS; symbol++) {
+			next = comboNext[state][symbol];
+
+			if ( next == 0xff) {
+				comboNext[state][symbol] = comboNext[fail[state]][symbol];
+			} else {
+				fail[next] = comboNext[fail[state]][symbol];
+
+				if ( comboOutput[fail[next]] >= 0) {
+					comboOutputLink[next] = fail[next];
+				} else {
+					comboOutputLink[next] = comboOutputLink[fail[next]];
+				}
+
+				queue[tail++] = next;
+			}
+		}
+	}
+
+	comboReset();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+void comboReset(void)
+//---------------------------------------------------------------------------------
+{
+	comboState = 0;
+	comboMatch = -1;
+	comboLastDir = -1;
+	comboLastHeld = keysHeld();
+}
+
+//---------------------------------------------------------------------------------
+void comboSetFacing(bool left)
+//---------------------------------------------------------------------------------
+{
+	comboFacingLeft = left;
+}
+
+//---------------------------------------------------------------------------------
+static void comboFeed(int symbol)
+//---------------------------------------------------------------------------------
+{
+	int state, id;
+
+	comboHistory[comboPosition++ & (COMBO_HISTORY - 1)] = comboFrame;
+
+	comboState = comboNext[comboState][symbol];
+
+	state = ( comboOutput[comboState] >= 0) ? comboState : comboOutputLink[comboState];
+
+	// longest combo first, shorter ones only if it took too long
+	while ( state) {
+		id = comboOutput[state];
+
+		if ( comboFrame - comboHistory[(comboPosition - comboLength[id]) & (COMBO_HISTORY - 1)] <= comboFrames[id]) {
+			comboMatch = id;
+			return;
+		}
+
+		state = comboOutputLink[state];
+	}
+}
+
+//---------------------------------------------------------------------------------
+int comboUpdate(void)
+//---------------------------------------------------------------------------------
+{
+	u16 held, pressed, fwd, back;
+	int dir, i;
+
+	comboMatch = -1;
+	if ( comboStates == 0) return -1;
+
+	comboFrame++;
+
+	held = keysHeld();
+	pressed = held & ~comboLastHeld;
+	comboLastHeld = held;
+
+	fwd = comboFacingLeft ? KEY_LEFT : KEY_RIGHT;
+	back = comboFacingLeft ? KEY_RIGHT : KEY_LEFT;
+
+	dir = comboDirections[	((held & KEY_UP) ? 1 : 0) | ((held & KEY_DOWN) ? 2 : 0) |
+							((held & fwd) ? 4 : 0) | ((held & back) ? 8 : 0) ];
+
+	if ( dir != comboLastDir) {
+		comboLastDir = dir;
+		comboFeed(dir);
+	}
+
+	if ( pressed & (KEY_A | KEY_B | KEY_L | KEY_R | KEY_START | KEY_SELECT)) {
+		for ( i = 0; i < COMBO_SYMBOLS - COMBO_A; i++) {
+			if ( pressed & comboButtons[i]) comboFeed(COMBO_A + i);
+		}
+	}
+
+	return comboMatch;
+}
@@ -31,7 +31,12 @@
  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <disc_io.h>
+#include <disc.h>
+#include <string.h>
+#include <gba_base.h>
+#include <gba_timers.h>
+#include <malloc.h>
+#include "disc_segment.h"
 
 // Include known io-interfaces:
 #include "io_mpcf.h"
@@ -39,20 +44,371 @@
 #include "io_sccf.h"
 #include "io_scsd.h"
 #include "io_m3sd.h"
+#include "io_cf_common.h"
 
-static const DISC_INTERFACE* discInterfaces[] = {
-	&_io_mpcf, &_io_m3cf, &_io_sccf, &_io_scsd, &_io_m3sd
+typedef struct {
+	const DISC_INTERFACE* disc;
+	FN_MEDIUM_PROBE probe;		// quick check run before startup, NULL if startup is already quick
+	FN_MEDIUM_READSECTORSV readSectorsV;	// scatter/gather read straight from the card, NULL if none
+	u32 speed;					// measured read speed in bytes per second, 0 if not measured
+} DISC_INTERFACE_ENTRY;
+
+// The CF startups only test a register, the SD ones are probed first.
+// Kept in the order they are tried, fastest first once measured.
+static DISC_INTERFACE_ENTRY discInterfaces[DISC_MAX_INTERFACES] = {
+	{ &_io_mpcf, NULL, _CF_readSectorsV, 0 },
+	{ &_io_m3cf, NULL, _CF_readSectorsV, 0 },
+	{ &_io_sccf, NULL, _CF_readSectorsV, 0 },
+	{ &_io_scsd, _SCSD_probe, _SCSD_readSectorsV, 0 },
+	{ &_io_m3sd, _M3SD_probe, _M3SD_readSectorsV, 0 }
 };
 
+static int discNumInterfaces = 5;
+
+#define DISC_SECTOR_SIZE 512
+
+// Last interface found, tried first next time
+static const DISC_INTERFACE* discLastInterface = NULL;
+
+// Optional hint kept in SRAM, accessed a byte at a time
+static vu8* discHint = NULL;
+#define DISC_HINT_MAGIC 0x544E4844	// 'DHNT'
+
+static u32 _disc_hintRead (int offset) {
+	return discHint[offset] | (discHint[offset+1] << 8) | (discHint[offset+2] << 16) | (discHint[offset+3] << 24);
+}
+
+static void _disc_hintWrite (int offset, u32 value) {
+	discHint[offset] = value;
+	discHint[offset+1] = value >> 8;
+	discHint[offset+2] = value >> 16;
+	discHint[offset+3] = value >> 24;
+}
+
+/*-----------------------------------------------------------------
+discSetHintLocation
+Lets discGetInterface remember the type of interface it found in
+8 bytes of SRAM at hint and try that type first on the next boot.
+Pass NULL to stop using SRAM. Off by default since the SRAM belongs
+to the game's saves.
+-----------------------------------------------------------------*/
+void discSetHintLocation (vu8* hint) {
+	discHint = hint;
+}
+
+static void _disc_remember (const DISC_INTERFACE* disc) {
+	discLastInterface = disc;
+
+	// Only write the SRAM when the hint actually changes
+	if (discHint != NULL &&
+		(_disc_hintRead (0) != DISC_HINT_MAGIC || _disc_hintRead (4) != disc->ioType))
+	{
+		_disc_hintWrite (0, DISC_HINT_MAGIC);
+		_disc_hintWrite (4, disc->ioType);
+	}
+}
+
+/*-----------------------------------------------------------------
+discRegisterInterface
+Adds an interface, such as a loaded DLDI, to the ones tried by
+discGetInterface. New interfaces are tried after the built in ones
+until discMeasureInterfaces has ranked them. Interfaces that can't
+read and ones already registered are refused.
+-----------------------------------------------------------------*/
+bool discRegisterInterface (const DISC_INTERFACE* disc, FN_MEDIUM_PROBE probe) {
+	int i;
+
+	if (disc == NULL || !(disc->features & FEATURE_MEDIUM_CANREAD) || discNumInterfaces >= DISC_MAX_INTERFACES) {
+		return false;
+	}
+	for (i = 0; i < discNumInterfaces; i++) {
+		if (discInterfaces[i].disc == disc) {
+			return false;
+		}
+	}
+
+	discInterfaces[discNumInterfaces].disc = disc;
+	discInterfaces[discNumInterfaces].probe = probe;
+	discInterfaces[discNumInterfaces].readSectorsV = NULL;
+	discInterfaces[discNumInterfaces].speed = 0;
+	discNumInterfaces++;
+	return true;
+}
+
+/*-----------------------------------------------------------------
+discUnregisterInterface
+Removes a registered interface, eg before freeing a loaded DLDI
+-----------------------------------------------------------------*/
+void discUnregisterInterface (const DISC_INTERFACE* disc) {
+	int i;
+
+	for (i = 0; i < discNumInterfaces; i++) {
+		if (discInterfaces[i].disc == disc) {
+			discNumInterfaces--;
+			for (; i < discNumInterfaces; i++) {
+				discInterfaces[i] = discInterfaces[i + 1];
+			}
+			break;
+		}
+	}
+	if (discLastInterface == disc) {
+		discLastInterface = NULL;
+	}
+}
+
+/*-----------------------------------------------------------------
+discMeasureInterfaces
+Starts every registered interface that is present and times a read
+of DISC_MEASURE_SECTORS sectors from the start of the card, using the
+cascaded timers timer and timer+1. The interfaces are then tried by
+discGetInterface fastest first, and the fastest is left started up.
+Returns the number of interfaces that work, or -1 if the timer number
+is invalid or out of memory.
+-----------------------------------------------------------------*/
+int discMeasureInterfaces (int timer) {
+	DISC_INTERFACE_ENTRY entry;
+	u8* buffer;
+	u32 ticks;
+	int i, j, working = 0;
+
+	if (timer < 0 || timer > 2) {
+		return -1;
+	}
+	if ((buffer = malloc (DISC_MEASURE_SECTORS * DISC_SECTOR_SIZE)) == NULL) {
+		return -1;
+	}
+
+	for (i = 0; i < discNumInterfaces; i++) {
+		discInterfaces[i].speed = 0;
+
+		if (discInterfaces[i].probe != NULL && !discInterfaces[i].probe()) {
+			continue;
+		}
+		if (!discInterfaces[i].disc->startup()) {
+			continue;
+		}
+
+		// The high timer counts overflows of the low one
+		timerStartCascaded (timer, TIMER_FREQ_64);
+
+		if (discInterfaces[i].disc->readSectors (0, DISC_MEASURE_SECTORS, buffer)) {
+			REG_TMCNT_H(timer) = 0;
+			ticks = timerReadCascaded (timer);
+			if (ticks == 0) {
+				ticks = 1;
+			}
+			// 262144 ticks per second
+			discInterfaces[i].speed = ((unsigned long long)(DISC_MEASURE_SECTORS * DISC_SECTOR_SIZE) << 18) / ticks;
+			working++;
+		}
+
+		REG_TMCNT_H(timer) = 0;
+		REG_TMCNT_H(timer + 1) = 0;
+	}
+
+	free (buffer);
+
+	// Fastest first, keeping the existing order for equal speeds
+	for (i = 1; i < discNumInterfaces; i++) {
+		entry = discInterfaces[i];
+		for (j = i; j > 0 && discInterfaces[j - 1].speed < entry.speed; j--) {
+			discInterfaces[j] = discInterfaces[j - 1];
+		}
+		discInterfaces[j] = entry;
+	}
+
+	// Let the fastest win over whatever was found before. The hardware
+	// was left in the mode of the last interface measured, so start the
+	// fastest again
+	if (working > 0 && discInterfaces[0].disc->startup()) {
+		_disc_remember (discInterfaces[0].disc);
+	} else {
+		discLastInterface = NULL;
+	}
+
+	return working;
+}
+
+/*-----------------------------------------------------------------
+discGetSpeed
+Read speed in bytes per second found by discMeasureInterfaces,
+0 if not measured or not working
+-----------------------------------------------------------------*/
+u32 discGetSpeed (const DISC_INTERFACE* disc) {
+	int i;
+
+	for (i = 0; i < discNumInterfaces; i++) {
+		if (discInterfaces[i].disc == disc) {
+			return discInterfaces[i].speed;
+		}
+	}
+	return 0;
+}
+
 const DISC_INTERFACE* discGetInterface (void)
 {
+	const DISC_INTERFACE* hinted = NULL;
+	u32 hintType;
 	int i;
 
-	for (i = 0; i < (sizeof(discInterfaces) / sizeof(DISC_INTERFACE*)); i++) {
-		if (discInterfaces[i]->startup()) {
-			return discInterfaces[i];
+	// Whatever worked last time is the most likely
+	if (discLastInterface != NULL && discLastInterface->startup()) {
+		return discLastInterface;
+	}
+
+	if (discHint != NULL && _disc_hintRead (0) == DISC_HINT_MAGIC) {
+		hintType = _disc_hintRead (4);
+		for (i = 0; i < discNumInterfaces; i++) {
+			if (discInterfaces[i].disc->ioType == hintType) {
+				hinted = discInterfaces[i].disc;
+				if (hinted != discLastInterface && hinted->startup()) {
+					_disc_remember (hinted);
+					return hinted;
+				}
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < discNumInterfaces; i++) {
+		if (discInterfaces[i].disc == hinted || discInterfaces[i].disc == discLastInterface) {
+			// Already tried above
+			continue;
+		}
+		if (discInterfaces[i].probe != NULL && !discInterfaces[i].probe()) {
+			continue;
+		}
+		if (discInterfaces[i].disc->startup()) {
+			_disc_remember (discInterfaces[i].disc);
+			return discInterfaces[i].disc;
 		}
 	}
 	return NULL;
 }
 
+// For sectors split across segments by the generic transfers
+static u8 discBounceBuffer[DISC_SECTOR_SIZE] ALIGN(4);
+
+/*
+Segments can be in VRAM, where a byte write stores the byte to both
+halves of its halfword, and memcpy writes bytes for mismatched
+alignments and odd tails. The volatile keeps the compiler from turning
+the loop back into a memcpy call.
+*/
+static void _disc_copyHalfwords (void* dest, const void* src, u32 length) {
+	vu16* d = (vu16*)dest;
+	const u16* s = (const u16*)src;
+
+	for (length >>= 1; length > 0; length--) {
+		*d++ = *s++;
+	}
+}
+
+static bool _disc_segmentsValid (const DISC_SEGMENT* segments, int numSegments, u32* numSectors) {
+	u32 total = 0;
+	int i;
+
+	for (i = 0; i < numSegments; i++) {
+		if ((segments[i].length | (uintptr_t)segments[i].buffer) & 0x01) {
+			return false;
+		}
+		total += segments[i].length;
+	}
+	if (total & (DISC_SECTOR_SIZE - 1)) {
+		return false;
+	}
+	*numSectors = total / DISC_SECTOR_SIZE;
+	return true;
+}
+
+/*-----------------------------------------------------------------
+discReadSectorsV
+Reads whole sectors into a list of segments. The built in drivers
+transfer straight into each segment without going through a bounce
+buffer, any other interface reads runs of whole sectors in place and
+only bounces the sectors that are split across segments.
+-----------------------------------------------------------------*/
+bool discReadSectorsV (const DISC_INTERFACE* disc, sec_t sector, const DISC_SEGMENT* segments, int numSegments) {
+	DISC_SEGMENT_CURSOR cursor;
+	u32 numSectors, run, span;
+	int i;
+
+	if (!_disc_segmentsValid (segments, numSegments, &numSectors)) {
+		return false;
+	}
+	if (numSectors == 0) {
+		return true;
+	}
+
+	for (i = 0; i < discNumInterfaces; i++) {
+		if (discInterfaces[i].readSectorsV != NULL && discInterfaces[i].disc->readSectors == disc->readSectors) {
+			return discInterfaces[i].readSectorsV (sector, segments, numSegments);
+		}
+	}
+
+	_segment_start (&cursor, segments, numSegments);
+	while (numSectors > 0) {
+		run = _segment_span (&cursor, numSectors * DISC_SECTOR_SIZE) / DISC_SECTOR_SIZE;
+		if (run > 0) {
+			if (!disc->readSectors (sector, run, cursor.data)) {
+				return false;
+			}
+			_segment_advance (&cursor, run * DISC_SECTOR_SIZE);
+		} else {
+			// The next sector is split across segments
+			run = 1;
+			if (!disc->readSectors (sector, 1, discBounceBuffer)) {
+				return false;
+			}
+			for (i = 0; i < DISC_SECTOR_SIZE; i += span) {
+				span = _segment_span (&cursor, DISC_SECTOR_SIZE - i);
+				_disc_copyHalfwords (cursor.data, discBounceBuffer + i, span);
+				_segment_advance (&cursor, span);
+			}
+		}
+		sector += run;
+		numSectors -= run;
+	}
+	return true;
+}
+
+/*-----------------------------------------------------------------
+discWriteSectorsV
+Writes whole sectors from a list of segments. Runs of whole sectors
+are written in place and sectors split across segments are gathered
+into a bounce buffer first, for every interface, since the SD drivers
+need each sector contiguous to calculate its CRC.
+-----------------------------------------------------------------*/
+bool discWriteSectorsV (const DISC_INTERFACE* disc, sec_t sector, const DISC_SEGMENT* segments, int numSegments) {
+	DISC_SEGMENT_CURSOR cursor;
+	u32 numSectors, run, span;
+	int i;
+
+	if (!_disc_segmentsValid (segments, numSegments, &numSectors)) {
+		return false;
+	}
+
+	_segment_start (&cursor, segments, numSegments);
+	while (numSectors > 0) {
+		run = _segment_span (&cursor, numSectors * DISC_SECTOR_SIZE) / DISC_SECTOR_SIZE;
+		if (run > 0) {
+			if (!disc->writeSectors (sector, run, cursor.data)) {
+				return false;
+			}
+			_segment_advance (&cursor, run * DISC_SECTOR_SIZE);
+		} else {
+			run = 1;
+			for (i = 0; i < DISC_SECTOR_SIZE; i += span) {
+				span = _segment_span (&cursor, DISC_SECTOR_SIZE - i);
+				_disc_copyHalfwords (discBounceBuffer + i, cursor.data, span);
+				_segment_advance (&cursor, span);
+			}
+			if (!disc->writeSectors (sector, 1, discBounceBuffer)) {
+				return false;
+			}
+		}
+		sector += run;
+		numSectors -= run;
+	}
+	return true;
+}
@@ -0,0 +1,215 @@
+/*
+ disc_async.c
+ Interrupt driven sector transfers
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <disc_async.h>
+#include <gba_interrupt.h>
+#include <gba_timers.h>
+#include <gba_systemcalls.h>
+#include "io_cf_common.h"
+
+#define BYTES_PER_SECTOR 512
+
+typedef enum {
+	STEP_COMMAND,		// waiting to send the command for the next run of up to 256 sectors
+	STEP_DATA,			// waiting to move the next sector
+	STEP_FINISH			// waiting for the card to finish the command
+} ASYNC_STEP;
+
+static const DISC_INTERFACE* asyncDisc = NULL;
+static int asyncTimer = -1;
+static bool asyncInterruptDriven = false;
+
+static volatile DISC_ASYNC_STATUS asyncStatus = DISC_ASYNC_IDLE;
+static ASYNC_STEP asyncStep;
+static sec_t asyncSector;
+static sec_t asyncRemaining;		// sectors still to transfer
+static sec_t asyncRun;				// sectors left in the current command
+static u8* asyncBuffer;
+static bool asyncWriting;
+static u32 asyncIdleTicks;
+static DISC_ASYNC_CALLBACK asyncCallback;
+static void* asyncUserData;
+
+static void _async_timerStop (void) {
+	REG_TMCNT_H(asyncTimer) = 0;
+	irqDisable (IRQ_TIMER0 << asyncTimer);
+}
+
+static void _async_complete (bool result) {
+	if (asyncInterruptDriven) {
+		_async_timerStop();
+	}
+	asyncStatus = result ? DISC_ASYNC_DONE : DISC_ASYNC_FAILED;
+	if (asyncCallback != NULL) {
+		asyncCallback (result, asyncUserData);
+	}
+}
+
+/*-----------------------------------------------------------------
+_async_tick
+Timer interrupt, moves the CF transfer on as far as the card allows
+without waiting, DISC_ASYNC_SECTORS_PER_TICK sectors at most
+-----------------------------------------------------------------*/
+static void _async_tick (void) {
+	int sectors = DISC_ASYNC_SECTORS_PER_TICK;
+	bool progress = false;
+
+	if (asyncStatus != DISC_ASYNC_BUSY) {
+		return;
+	}
+
+	while (sectors > 0) {
+		if (asyncStep == STEP_COMMAND) {
+			if (!_CF_readyForCommand()) {
+				break;
+			}
+			asyncRun = asyncRemaining < 256 ? asyncRemaining : 256;
+			_CF_sendCommand (asyncSector, asyncRun, asyncWriting ? CF_CMD_WRITE : CF_CMD_READ);
+			asyncStep = STEP_DATA;
+		} else if (asyncStep == STEP_DATA) {
+			if (!_CF_readyForData()) {
+				break;
+			}
+			if (asyncWriting) {
+				_CF_writeSector (asyncBuffer);
+			} else {
+				_CF_readSector (asyncBuffer);
+			}
+			asyncBuffer += BYTES_PER_SECTOR;
+			asyncSector++;
+			asyncRemaining--;
+			sectors--;
+			if (--asyncRun == 0) {
+				asyncStep = asyncRemaining ? STEP_COMMAND : STEP_FINISH;
+			}
+		} else {
+			// A write isn't finished until the card has programmed the last sector
+			if (asyncWriting && !_CF_readyForCommand()) {
+				break;
+			}
+			_async_complete (true);
+			return;
+		}
+		progress = true;
+	}
+
+	if (progress) {
+		asyncIdleTicks = 0;
+	} else if (++asyncIdleTicks > DISC_ASYNC_TIMEOUT_TICKS) {
+		_async_complete (false);
+	}
+}
+
+static bool _async_submit (sec_t sector, sec_t numSectors, u8* buffer, bool writing, DISC_ASYNC_CALLBACK callback, void* userData) {
+	bool result;
+
+	if (asyncDisc == NULL || asyncStatus == DISC_ASYNC_BUSY) {
+		return false;
+	}
+
+	asyncCallback = callback;
+	asyncUserData = userData;
+	asyncStatus = DISC_ASYNC_BUSY;
+
+	if (!asyncInterruptDriven) {
+		if (writing) {
+			result = asyncDisc->writeSectors (sector, numSectors, buffer);
+		} else {
+			result = asyncDisc->readSectors (sector, numSectors, buffer);
+		}
+		_async_complete (result);
+		return true;
+	}
+
+	asyncSector = sector;
+	asyncRemaining = numSectors;
+	asyncBuffer = buffer;
+	asyncWriting = writing;
+	asyncIdleTicks = 0;
+	asyncStep = numSectors ? STEP_COMMAND : STEP_FINISH;
+
+	REG_TMCNT_H(asyncTimer) = 0;
+	REG_TMCNT_L(asyncTimer) = 65536 - (262144 / DISC_ASYNC_TICKS_PER_SECOND);
+	irqEnable (IRQ_TIMER0 << asyncTimer);
+	REG_TMCNT_H(asyncTimer) = TIMER_START | TIMER_IRQ | TIMER_FREQ_64;
+
+	return true;
+}
+
+bool discAsyncRead (sec_t sector, sec_t numSectors, void* buffer, DISC_ASYNC_CALLBACK callback, void* userData) {
+	return _async_submit (sector, numSectors, (u8*)buffer, false, callback, userData);
+}
+
+bool discAsyncWrite (sec_t sector, sec_t numSectors, const void* buffer, DISC_ASYNC_CALLBACK callback, void* userData) {
+	return _async_submit (sector, numSectors, (u8*)buffer, true, callback, userData);
+}
+
+DISC_ASYNC_STATUS discAsyncPoll (void) {
+	return asyncStatus;
+}
+
+bool discAsyncWait (void) {
+	// A tick which lands between the check and the wait has already
+	// set its flag, so IntrWait returns straight away
+	while (asyncStatus == DISC_ASYNC_BUSY) {
+		IntrWait (0, IRQ_TIMER0 << asyncTimer);
+	}
+	return asyncStatus == DISC_ASYNC_DONE;
+}
+
+void discAsyncStop (void) {
+	if (asyncInterruptDriven) {
+		_async_timerStop();
+		irqSet (IRQ_TIMER0 << asyncTimer, NULL);
+	}
+	if (asyncStatus == DISC_ASYNC_BUSY) {
+		asyncStatus = DISC_ASYNC_FAILED;
+	}
+	asyncDisc = NULL;
+	asyncInterruptDriven = false;
+}
+
+bool discAsyncInit (const DISC_INTERFACE* disc, int timer) {
+	if (disc == NULL || timer < 0 || timer > 3) {
+		return false;
+	}
+
+	discAsyncStop();
+
+	asyncDisc = disc;
+	asyncTimer = timer;
+	asyncStatus = DISC_ASYNC_IDLE;
+
+	// All the CF interfaces share the common CF code, which can be stepped
+	asyncInterruptDriven = (disc->readSectors == (FN_MEDIUM_READSECTORS)&_CF_readSectors);
+	if (asyncInterruptDriven) {
+		irqSet (IRQ_TIMER0 << timer, _async_tick);
+	}
+
+	return true;
+}
@@ -0,0 +1,387 @@
+/*
+ disc_cache.c
+ Write-back sector cache for any DISC_INTERFACE
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <disc_cache.h>
+#include <string.h>
+#include <malloc.h>
+
+#define BYTES_PER_SECTOR DISC_CACHE_SECTOR_SIZE
+
+typedef struct {
+	sec_t	sector;
+	u32		lastAccess;
+	u8		valid;
+	u8		dirty;
+} CACHE_ENTRY;
+
+static const DISC_INTERFACE* cacheDisc = NULL;
+static CACHE_ENTRY* cacheEntries = NULL;
+static u8* cacheData = NULL;		// numEntries sectors followed by one spare for swapping
+static u16* cacheDirtyList = NULL;
+static int cacheNumEntries = 0;
+static u32 cacheAccessCount = 0;
+static DISC_CACHE_STATS cacheStats;
+
+#define CACHE_SECTOR_DATA(i) (cacheData + (i) * BYTES_PER_SECTOR)
+
+/*-----------------------------------------------------------------
+_cache_find
+Returns the entry holding sector, or -1 if it isn't cached
+-----------------------------------------------------------------*/
+static int _cache_find (sec_t sector) {
+	int i;
+
+	for (i = 0; i < cacheNumEntries; i++) {
+		if (cacheEntries[i].valid && cacheEntries[i].sector == sector) {
+			cacheEntries[i].lastAccess = ++cacheAccessCount;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*-----------------------------------------------------------------
+_cache_swap
+Exchanges the contents of two entries, used to make runs of dirty
+sectors contiguous in memory before writing them back
+-----------------------------------------------------------------*/
+static void _cache_swap (int a, int b) {
+	CACHE_ENTRY entry;
+	u8* spare = CACHE_SECTOR_DATA(cacheNumEntries);
+
+	entry = cacheEntries[a];
+	cacheEntries[a] = cacheEntries[b];
+	cacheEntries[b] = entry;
+
+	memcpy (spare, CACHE_SECTOR_DATA(a), BYTES_PER_SECTOR);
+	memcpy (CACHE_SECTOR_DATA(a), CACHE_SECTOR_DATA(b), BYTES_PER_SECTOR);
+	memcpy (CACHE_SECTOR_DATA(b), spare, BYTES_PER_SECTOR);
+}
+
+/*-----------------------------------------------------------------
+discCacheFlush
+Writes all dirty sectors to the disc. The dirty entries are sorted
+by sector, each run of adjacent sectors is moved into adjacent
+entries and written with one command
+-----------------------------------------------------------------*/
+bool discCacheFlush (void) {
+	int numDirty = 0;
+	int i, j, k, runStart, runLength, base, slot;
+
+	if (cacheDisc == NULL) {
+		return false;
+	}
+
+	for (i = 0; i < cacheNumEntries; i++) {
+		if (cacheEntries[i].valid && cacheEntries[i].dirty) {
+			// insertion sort by sector number
+			for (j = numDirty; j > 0 && cacheEntries[cacheDirtyList[j-1]].sector > cacheEntries[i].sector; j--) {
+				cacheDirtyList[j] = cacheDirtyList[j-1];
+			}
+			cacheDirtyList[j] = i;
+			numDirty++;
+		}
+	}
+
+	for (runStart = 0; runStart < numDirty; runStart += runLength) {
+		runLength = 1;
+		while (runStart + runLength < numDirty &&
+			cacheEntries[cacheDirtyList[runStart + runLength]].sector ==
+			cacheEntries[cacheDirtyList[runStart]].sector + runLength)
+		{
+			runLength++;
+		}
+
+		base = cacheDirtyList[runStart];
+		if (base > cacheNumEntries - runLength) {
+			base = cacheNumEntries - runLength;
+		}
+
+		for (k = 0; k < runLength; k++) {
+			slot = cacheDirtyList[runStart + k];
+			if (slot != base + k) {
+				// Keep the list pointing at the right entries once swapped
+				for (j = runStart + k + 1; j < numDirty; j++) {
+					if (cacheDirtyList[j] == base + k) {
+						cacheDirtyList[j] = slot;
+						break;
+					}
+				}
+				_cache_swap (slot, base + k);
+				cacheDirtyList[runStart + k] = base + k;
+			}
+		}
+
+		if (!cacheDisc->writeSectors (cacheEntries[base].sector, runLength, CACHE_SECTOR_DATA(base))) {
+			return false;
+		}
+
+		for (k = 0; k < runLength; k++) {
+			cacheEntries[base + k].dirty = false;
+		}
+		cacheStats.writeBacks++;
+		cacheStats.sectorsFlushed += runLength;
+	}
+
+	return true;
+}
+
+/*-----------------------------------------------------------------
+_cache_victim
+Finds a free entry, or the least recently used one. A dirty victim
+causes a flush so its write is combined with any neighbours.
+Returns -1 if the flush failed
+-----------------------------------------------------------------*/
+static int _cache_victim (void) {
+	int i, victim = 0;
+
+	for (i = 0; i < cacheNumEntries; i++) {
+		if (!cacheEntries[i].valid) {
+			return i;
+		}
+		if (cacheEntries[i].lastAccess < cacheEntries[victim].lastAccess) {
+			victim = i;
+		}
+	}
+
+	if (cacheEntries[victim].dirty && !discCacheFlush()) {
+		return -1;
+	}
+
+	return victim;
+}
+
+/*-----------------------------------------------------------------
+_cache_readSectors
+Cached sectors are copied from the cache. A single missing sector
+is read into the cache, a run of several missing sectors is read
+straight into the buffer without disturbing the cache
+-----------------------------------------------------------------*/
+static bool _cache_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	u8* dest = (u8*)buffer;
+	sec_t run;
+	int i;
+
+	while (numSectors > 0) {
+		i = _cache_find (sector);
+		if (i >= 0) {
+			memcpy (dest, CACHE_SECTOR_DATA(i), BYTES_PER_SECTOR);
+			cacheStats.readHits++;
+			run = 1;
+		} else {
+			for (run = 1; run < numSectors && _cache_find (sector + run) < 0; run++);
+
+			if (run == 1) {
+				if ((i = _cache_victim()) < 0) {
+					return false;
+				}
+				cacheEntries[i].valid = false;
+				if (!cacheDisc->readSectors (sector, 1, CACHE_SECTOR_DATA(i))) {
+					return false;
+				}
+				cacheEntries[i].sector = sector;
+				cacheEntries[i].lastAccess = ++cacheAccessCount;
+				cacheEntries[i].valid = true;
+				cacheEntries[i].dirty = false;
+				memcpy (dest, CACHE_SECTOR_DATA(i), BYTES_PER_SECTOR);
+			} else if (!cacheDisc->readSectors (sector, run, dest)) {
+				return false;
+			}
+			cacheStats.readMisses += run;
+		}
+
+		sector += run;
+		numSectors -= run;
+		dest += run * BYTES_PER_SECTOR;
+	}
+
+	return true;
+}
+
+/*-----------------------------------------------------------------
+_cache_writeSectors
+Small writes go into the cache and are written back later, writes
+as large as the cache go straight to the disc. Copies already cached
+are refreshed once the disc write has succeeded. If it fails the
+clean copies are dropped, as the disc may be partly written, and
+dirty ones are kept to be written back later
+-----------------------------------------------------------------*/
+static bool _cache_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	const u8* src = (const u8*)buffer;
+	sec_t count;
+	bool ok;
+	int i;
+
+	if (numSectors >= (sec_t)cacheNumEntries) {
+		ok = cacheDisc->writeSectors (sector, numSectors, buffer);
+
+		for (i = 0; i < cacheNumEntries; i++) {
+			if (cacheEntries[i].valid && cacheEntries[i].sector - sector < numSectors) {
+				if (ok) {
+					memcpy (CACHE_SECTOR_DATA(i), src + (cacheEntries[i].sector - sector) * BYTES_PER_SECTOR, BYTES_PER_SECTOR);
+					cacheEntries[i].dirty = false;
+				} else if (!cacheEntries[i].dirty) {
+					cacheEntries[i].valid = false;
+				}
+			}
+		}
+		if (ok) {
+			cacheStats.writeThrough += numSectors;
+		}
+		return ok;
+	}
+
+	for (count = 0; count < numSectors; count++, sector++, src += BYTES_PER_SECTOR) {
+		i = _cache_find (sector);
+		if (i >= 0) {
+			cacheStats.writeHits++;
+		} else {
+			if ((i = _cache_victim()) < 0) {
+				return false;
+			}
+			cacheEntries[i].sector = sector;
+			cacheEntries[i].lastAccess = ++cacheAccessCount;
+			cacheEntries[i].valid = true;
+			cacheStats.writeMisses++;
+		}
+		memcpy (CACHE_SECTOR_DATA(i), src, BYTES_PER_SECTOR);
+		cacheEntries[i].dirty = true;
+	}
+
+	return true;
+}
+
+/*-----------------------------------------------------------------
+discCacheInvalidate
+Flushes then forgets every cached sector
+-----------------------------------------------------------------*/
+bool discCacheInvalidate (void) {
+	int i;
+	bool ok = discCacheFlush();
+
+	for (i = 0; i < cacheNumEntries; i++) {
+		cacheEntries[i].valid = false;
+		cacheEntries[i].dirty = false;
+	}
+	return ok;
+}
+
+static bool _cache_startup (void) {
+	discCacheInvalidate();
+	return cacheDisc->startup();
+}
+
+static bool _cache_isInserted (void) {
+	return cacheDisc->isInserted();
+}
+
+static bool _cache_clearStatus (void) {
+	bool ok = discCacheFlush();
+	return cacheDisc->clearStatus() && ok;
+}
+
+static bool _cache_shutdown (void) {
+	bool ok = discCacheInvalidate();
+	return cacheDisc->shutdown() && ok;
+}
+
+/*-----------------------------------------------------------------
+the wrapper interface structure, the type and features are
+copied from the wrapped interface
+-----------------------------------------------------------------*/
+static DISC_INTERFACE _io_cache = {
+	0,
+	FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE,
+	(FN_MEDIUM_STARTUP)&_cache_startup,
+	(FN_MEDIUM_ISINSERTED)&_cache_isInserted,
+	(FN_MEDIUM_READSECTORS)&_cache_readSectors,
+	(FN_MEDIUM_WRITESECTORS)&_cache_writeSectors,
+	(FN_MEDIUM_CLEARSTATUS)&_cache_clearStatus,
+	(FN_MEDIUM_SHUTDOWN)&_cache_shutdown
+} ;
+
+/*-----------------------------------------------------------------
+discCacheFree
+Flushes and releases the cache
+-----------------------------------------------------------------*/
+bool discCacheFree (void) {
+	bool ok = discCacheFlush();
+
+	free (cacheEntries);
+	cacheEntries = NULL;
+	cacheData = NULL;
+	cacheDirtyList = NULL;
+	cacheNumEntries = 0;
+	cacheDisc = NULL;
+
+	return ok;
+}
+
+/*-----------------------------------------------------------------
+discCacheInit
+Wraps disc in a write-back cache of numSectors sectors. The entries,
+sector data, spare swap sector and dirty list share one allocation
+-----------------------------------------------------------------*/
+const DISC_INTERFACE* discCacheInit (const DISC_INTERFACE* disc, int numSectors) {
+	u8* block;
+
+	if (cacheDisc != NULL) {
+		discCacheFree();
+	}
+
+	if (disc == NULL || numSectors < 1 || numSectors > 0xffff) {
+		return NULL;
+	}
+
+	block = malloc (numSectors * sizeof(CACHE_ENTRY) + (numSectors + 1) * BYTES_PER_SECTOR + numSectors * sizeof(u16));
+	if (block == NULL) {
+		return NULL;
+	}
+
+	cacheEntries = (CACHE_ENTRY*)block;
+	cacheData = block + numSectors * sizeof(CACHE_ENTRY);
+	cacheDirtyList = (u16*)(cacheData + (numSectors + 1) * BYTES_PER_SECTOR);
+	cacheNumEntries = numSectors;
+	cacheAccessCount = 0;
+	memset (cacheEntries, 0, numSectors * sizeof(CACHE_ENTRY));
+
+	cacheDisc = disc;
+	_io_cache.ioType = disc->ioType;
+	_io_cache.features = disc->features;
+	discCacheResetStats();
+
+	return &_io_cache;
+}
+
+void discCacheGetStats (DISC_CACHE_STATS* stats) {
+	*stats = cacheStats;
+}
+
+void discCacheResetStats (void) {
+	memset (&cacheStats, 0, sizeof(cacheStats));
+}
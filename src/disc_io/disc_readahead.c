@@ -0,0 +1,224 @@
+/*
+ disc_readahead.c
+ Sequential readahead for any DISC_INTERFACE
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <disc_readahead.h>
+#include <string.h>
+#include <malloc.h>
+
+#define BYTES_PER_SECTOR 512
+
+static const DISC_INTERFACE* raDisc = NULL;
+static u8* raBuffer = NULL;
+static int raMaxSectors = 0;
+static sec_t raStart = 0;		// first sector held in the buffer
+static sec_t raCount = 0;		// number of sectors held in the buffer
+static sec_t raNext = 0;		// sector following the last read
+static sec_t raWindow = 0;		// sectors to read ahead, 0 while not sequential
+static DISC_READAHEAD_STATS raStats;
+
+/*-----------------------------------------------------------------
+_ra_fill
+Reads window sectors starting at sector into the buffer, on failure
+the buffer is left empty and false returned, which also happens
+when reading ahead past the end of the card
+-----------------------------------------------------------------*/
+static bool _ra_fill (sec_t sector, sec_t window) {
+	raCount = 0;
+	raStats.readCommands++;
+	if (!raDisc->readSectors (sector, window, raBuffer)) {
+		return false;
+	}
+	raStart = sector;
+	raCount = window;
+	raStats.sectorsPrefetched += window;
+	return true;
+}
+
+/*-----------------------------------------------------------------
+_ra_readSectors
+Sectors already in the buffer are copied out. When the read
+continues the previous one the rest is fetched along with the
+readahead, otherwise it is read directly
+-----------------------------------------------------------------*/
+static bool _ra_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	u8* dest = (u8*)buffer;
+	sec_t count;
+
+	if (sector == raNext) {
+		if (raWindow == 0) {
+			raWindow = DISC_READAHEAD_MIN_SECTORS;
+		}
+	} else {
+		raWindow = 0;
+	}
+	raNext = sector + numSectors;
+
+	while (numSectors > 0) {
+		if (sector - raStart < raCount) {
+			count = raStart + raCount - sector;
+			if (count > numSectors) {
+				count = numSectors;
+			}
+			memcpy (dest, raBuffer + (sector - raStart) * BYTES_PER_SECTOR, count * BYTES_PER_SECTOR);
+			raStats.sectorsBuffered += count;
+		} else if (raWindow > numSectors) {
+			if (!_ra_fill (sector, raWindow)) {
+				// Couldn't read ahead, get just what was asked for
+				raWindow = 0;
+				continue;
+			}
+			// Read further ahead next time the buffer runs out
+			raWindow <<= 1;
+			if (raWindow > (sec_t)raMaxSectors) {
+				raWindow = raMaxSectors;
+			}
+			continue;
+		} else {
+			count = numSectors;
+			raStats.readCommands++;
+			if (!raDisc->readSectors (sector, count, dest)) {
+				return false;
+			}
+			raStats.sectorsDirect += count;
+		}
+
+		sector += count;
+		numSectors -= count;
+		dest += count * BYTES_PER_SECTOR;
+	}
+
+	return true;
+}
+
+/*-----------------------------------------------------------------
+_ra_writeSectors
+Writes go straight to the disc, any buffered copies are updated once
+the write has succeeded. After a failed write part of it may be on the
+disc, so the buffer is dropped
+-----------------------------------------------------------------*/
+static bool _ra_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	sec_t first, last;
+
+	if (!raDisc->writeSectors (sector, numSectors, buffer)) {
+		discReadaheadInvalidate();
+		return false;
+	}
+
+	first = sector > raStart ? sector : raStart;
+	last = (sector + numSectors < raStart + raCount) ? sector + numSectors : raStart + raCount;
+	if (first < last) {
+		memcpy (raBuffer + (first - raStart) * BYTES_PER_SECTOR,
+			(const u8*)buffer + (first - sector) * BYTES_PER_SECTOR,
+			(last - first) * BYTES_PER_SECTOR);
+	}
+
+	return true;
+}
+
+void discReadaheadInvalidate (void) {
+	raCount = 0;
+	raWindow = 0;
+}
+
+static bool _ra_startup (void) {
+	discReadaheadInvalidate();
+	return raDisc->startup();
+}
+
+static bool _ra_isInserted (void) {
+	return raDisc->isInserted();
+}
+
+static bool _ra_clearStatus (void) {
+	discReadaheadInvalidate();
+	return raDisc->clearStatus();
+}
+
+static bool _ra_shutdown (void) {
+	discReadaheadInvalidate();
+	return raDisc->shutdown();
+}
+
+/*-----------------------------------------------------------------
+the wrapper interface structure, the type and features are
+copied from the wrapped interface
+-----------------------------------------------------------------*/
+static DISC_INTERFACE _io_readahead = {
+	0,
+	FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE,
+	(FN_MEDIUM_STARTUP)&_ra_startup,
+	(FN_MEDIUM_ISINSERTED)&_ra_isInserted,
+	(FN_MEDIUM_READSECTORS)&_ra_readSectors,
+	(FN_MEDIUM_WRITESECTORS)&_ra_writeSectors,
+	(FN_MEDIUM_CLEARSTATUS)&_ra_clearStatus,
+	(FN_MEDIUM_SHUTDOWN)&_ra_shutdown
+} ;
+
+void discReadaheadFree (void) {
+	free (raBuffer);
+	raBuffer = NULL;
+	raMaxSectors = 0;
+	raDisc = NULL;
+	discReadaheadInvalidate();
+}
+
+const DISC_INTERFACE* discReadaheadInit (const DISC_INTERFACE* disc, int maxSectors) {
+	if (raDisc != NULL) {
+		discReadaheadFree();
+	}
+
+	if (disc == NULL || maxSectors < DISC_READAHEAD_MIN_SECTORS) {
+		return NULL;
+	}
+	if (maxSectors > DISC_READAHEAD_MAX_SECTORS) {
+		maxSectors = DISC_READAHEAD_MAX_SECTORS;
+	}
+
+	if ((raBuffer = malloc (maxSectors * BYTES_PER_SECTOR)) == NULL) {
+		return NULL;
+	}
+
+	raDisc = disc;
+	raMaxSectors = maxSectors;
+	raNext = 0;
+	discReadaheadInvalidate();
+	discReadaheadResetStats();
+
+	_io_readahead.ioType = disc->ioType;
+	_io_readahead.features = disc->features;
+
+	return &_io_readahead;
+}
+
+void discReadaheadGetStats (DISC_READAHEAD_STATS* stats) {
+	*stats = raStats;
+}
+
+void discReadaheadResetStats (void) {
+	memset (&raStats, 0, sizeof(raStats));
+}
@@ -0,0 +1,78 @@
+/*
+ disc_segment.h
+ Walking a DISC_SEGMENT list a span at a time, shared by the drivers
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DISC_SEGMENT_H
+#define DISC_SEGMENT_H
+
+#include <disc_io.h>
+
+typedef struct {
+	const DISC_SEGMENT* segment;	// current segment
+	const DISC_SEGMENT* end;
+	u8* data;						// next byte of the current segment
+	u32 left;						// bytes left in the current segment
+} DISC_SEGMENT_CURSOR;
+
+/*
+Total length of the segments in bytes
+*/
+static inline u32 _segment_total (const DISC_SEGMENT* segments, int numSegments) {
+	u32 total = 0;
+
+	while (numSegments--) {
+		total += (segments++)->length;
+	}
+	return total;
+}
+
+static inline void _segment_start (DISC_SEGMENT_CURSOR* cursor, const DISC_SEGMENT* segments, int numSegments) {
+	cursor->segment = segments;
+	cursor->end = segments + numSegments;
+	cursor->data = numSegments > 0 ? (u8*)segments->buffer : NULL;
+	cursor->left = numSegments > 0 ? segments->length : 0;
+}
+
+/*
+Number of bytes, at most wanted, that can be transferred to or from
+cursor->data before the end of the current segment
+*/
+static inline u32 _segment_span (DISC_SEGMENT_CURSOR* cursor, u32 wanted) {
+	while (cursor->left == 0 && cursor->segment + 1 < cursor->end) {
+		cursor->segment++;
+		cursor->data = (u8*)cursor->segment->buffer;
+		cursor->left = cursor->segment->length;
+	}
+	return wanted < cursor->left ? wanted : cursor->left;
+}
+
+static inline void _segment_advance (DISC_SEGMENT_CURSOR* cursor, u32 length) {
+	cursor->data += length;
+	cursor->left -= length;
+}
+
+#endif // DISC_SEGMENT_H
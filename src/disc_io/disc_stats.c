@@ -0,0 +1,216 @@
+/*
+ disc_stats.c
+ I/O statistics and tracing for any DISC_INTERFACE
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <disc_stats.h>
+#include <gba_timers.h>
+#include <string.h>
+
+DISC_DRIVER_STATS discDriverStats;
+
+static const DISC_INTERFACE* statsDisc = NULL;
+static DISC_STATS stats;
+static int statsTimer = -1;
+
+static DISC_TRACE_ENTRY* traceBuffer = NULL;
+static u32 traceSize = 0;
+static u32 traceCount = 0;
+
+/*-----------------------------------------------------------------
+_stats_time
+Reads the cascaded timers, 0 if timing is off
+-----------------------------------------------------------------*/
+static u32 _stats_time (void) {
+	if (statsTimer < 0) {
+		return 0;
+	}
+
+	return timerReadCascaded (statsTimer);
+}
+
+static int _stats_bucket (sec_t numSectors) {
+	int bucket = 0;
+
+	while (numSectors > 1 && bucket < DISC_STATS_BATCH_BUCKETS - 1) {
+		numSectors >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static void _stats_trace (u8 op, sec_t sector, sec_t numSectors, u32 start, u32 ticks, bool result) {
+	DISC_TRACE_ENTRY* entry;
+
+	if (traceBuffer == NULL) {
+		return;
+	}
+
+	entry = &traceBuffer[traceCount % traceSize];
+	entry->time = start;
+	entry->sector = sector;
+	entry->ticks = ticks;
+	entry->numSectors = numSectors > 0xffff ? 0xffff : numSectors;
+	entry->op = op;
+	entry->result = result;
+	traceCount++;
+}
+
+static bool _stats_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	u32 start, ticks;
+	bool result;
+
+	start = _stats_time();
+	result = statsDisc->readSectors (sector, numSectors, buffer);
+	ticks = _stats_time() - start;
+
+	stats.reads++;
+	if (result) {
+		stats.sectorsRead += numSectors;
+	} else {
+		stats.readErrors++;
+	}
+	stats.readBatches[_stats_bucket (numSectors)]++;
+	stats.readTicks += ticks;
+	if (ticks > stats.maxReadTicks) {
+		stats.maxReadTicks = ticks;
+	}
+
+	_stats_trace (DISC_TRACE_READ, sector, numSectors, start, ticks, result);
+	return result;
+}
+
+static bool _stats_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	u32 start, ticks;
+	bool result;
+
+	start = _stats_time();
+	result = statsDisc->writeSectors (sector, numSectors, buffer);
+	ticks = _stats_time() - start;
+
+	stats.writes++;
+	if (result) {
+		stats.sectorsWritten += numSectors;
+	} else {
+		stats.writeErrors++;
+	}
+	stats.writeBatches[_stats_bucket (numSectors)]++;
+	stats.writeTicks += ticks;
+	if (ticks > stats.maxWriteTicks) {
+		stats.maxWriteTicks = ticks;
+	}
+
+	_stats_trace (DISC_TRACE_WRITE, sector, numSectors, start, ticks, result);
+	return result;
+}
+
+static bool _stats_call (u8 op, FN_MEDIUM_STARTUP function) {
+	u32 start = _stats_time();
+	bool result = function();
+
+	_stats_trace (op, 0, 0, start, _stats_time() - start, result);
+	return result;
+}
+
+static bool _stats_startup (void) {
+	return _stats_call (DISC_TRACE_STARTUP, statsDisc->startup);
+}
+
+static bool _stats_isInserted (void) {
+	return statsDisc->isInserted();
+}
+
+static bool _stats_clearStatus (void) {
+	return _stats_call (DISC_TRACE_CLEARSTATUS, statsDisc->clearStatus);
+}
+
+static bool _stats_shutdown (void) {
+	return _stats_call (DISC_TRACE_SHUTDOWN, statsDisc->shutdown);
+}
+
+/*-----------------------------------------------------------------
+the wrapper interface structure, the type and features are
+copied from the wrapped interface
+-----------------------------------------------------------------*/
+static DISC_INTERFACE _io_stats = {
+	0,
+	FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE,
+	(FN_MEDIUM_STARTUP)&_stats_startup,
+	(FN_MEDIUM_ISINSERTED)&_stats_isInserted,
+	(FN_MEDIUM_READSECTORS)&_stats_readSectors,
+	(FN_MEDIUM_WRITESECTORS)&_stats_writeSectors,
+	(FN_MEDIUM_CLEARSTATUS)&_stats_clearStatus,
+	(FN_MEDIUM_SHUTDOWN)&_stats_shutdown
+} ;
+
+void discStatsStop (void) {
+	if (statsTimer >= 0) {
+		REG_TMCNT_H(statsTimer) = 0;
+		REG_TMCNT_H(statsTimer + 1) = 0;
+		statsTimer = -1;
+	}
+}
+
+const DISC_INTERFACE* discStatsInit (const DISC_INTERFACE* disc, int timer) {
+	if (disc == NULL || timer < -1 || timer > 2) {
+		return NULL;
+	}
+
+	discStatsStop();
+
+	if (timer >= 0) {
+		// The high timer counts overflows of the low one
+		timerStartCascaded (timer, TIMER_FREQ_64);
+		statsTimer = timer;
+	}
+
+	statsDisc = disc;
+	_io_stats.ioType = disc->ioType;
+	_io_stats.features = disc->features;
+	discStatsReset();
+
+	return &_io_stats;
+}
+
+void discStatsGet (DISC_STATS* result) {
+	*result = stats;
+}
+
+void discStatsReset (void) {
+	memset (&stats, 0, sizeof(stats));
+	memset (&discDriverStats, 0, sizeof(discDriverStats));
+}
+
+void discStatsTraceStart (DISC_TRACE_ENTRY* buffer, int numEntries) {
+	traceCount = 0;
+	traceSize = numEntries;
+	traceBuffer = numEntries > 0 ? buffer : NULL;
+}
+
+u32 discStatsTraceStop (void) {
+	traceBuffer = NULL;
+	return traceCount;
+}
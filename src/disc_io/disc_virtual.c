@@ -0,0 +1,282 @@
+/*
+ disc_virtual.c
+ RAM and file backed DISC_INTERFACEs for testing and benchmarking
+
+ Copyright (c) 2008 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <disc_virtual.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define BYTES_PER_SECTOR 512
+
+typedef struct {
+	DISC_TIMING timing;
+	unsigned long long elapsed;
+	sec_t numSectors;
+	bool writable;
+} VIRTUAL_DISC;
+
+const DISC_TIMING discTimingCF = { 100, 2 * 1024 * 1024 };
+const DISC_TIMING discTimingSD = { 400, 512 * 1024 };
+
+static VIRTUAL_DISC ramDisc;
+static u8* ramImage = NULL;
+
+static VIRTUAL_DISC fileDisc;
+static const char* filePath = NULL;
+static int fileHandle = -1;
+
+/*-----------------------------------------------------------------
+_virtual_access
+Checks a request fits on the disc and charges its simulated time
+-----------------------------------------------------------------*/
+static bool _virtual_access (VIRTUAL_DISC* disc, sec_t sector, sec_t numSectors) {
+	if (sector >= disc->numSectors || numSectors > disc->numSectors - sector) {
+		return false;
+	}
+
+	disc->elapsed += disc->timing.commandLatency;
+	if (disc->timing.bytesPerSecond != 0) {
+		disc->elapsed += (unsigned long long)numSectors * BYTES_PER_SECTOR * 1000000 / disc->timing.bytesPerSecond;
+	}
+	return true;
+}
+
+static bool _virtual_none (void) {
+	return true;
+}
+
+//---------------------------------------------------------------
+// RAM disc
+
+static bool _ram_startup (void) {
+	return ramImage != NULL;
+}
+
+static bool _ram_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	if (!_virtual_access (&ramDisc, sector, numSectors)) {
+		return false;
+	}
+	memcpy (buffer, ramImage + sector * BYTES_PER_SECTOR, numSectors * BYTES_PER_SECTOR);
+	return true;
+}
+
+static bool _ram_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	if (!ramDisc.writable || !_virtual_access (&ramDisc, sector, numSectors)) {
+		return false;
+	}
+	memcpy (ramImage + sector * BYTES_PER_SECTOR, buffer, numSectors * BYTES_PER_SECTOR);
+	return true;
+}
+
+static DISC_INTERFACE _io_ramdisc = {
+	DEVICE_TYPE_RAMDISC,
+	FEATURE_MEDIUM_CANREAD,
+	(FN_MEDIUM_STARTUP)&_ram_startup,
+	(FN_MEDIUM_ISINSERTED)&_ram_startup,
+	(FN_MEDIUM_READSECTORS)&_ram_readSectors,
+	(FN_MEDIUM_WRITESECTORS)&_ram_writeSectors,
+	(FN_MEDIUM_CLEARSTATUS)&_virtual_none,
+	(FN_MEDIUM_SHUTDOWN)&_virtual_none
+} ;
+
+const DISC_INTERFACE* discRamInit (void* image, sec_t numSectors, bool writable) {
+	if (image == NULL || numSectors == 0) {
+		return NULL;
+	}
+
+	ramImage = (u8*)image;
+	memset (&ramDisc, 0, sizeof(ramDisc));
+	ramDisc.numSectors = numSectors;
+	ramDisc.writable = writable;
+
+	_io_ramdisc.features = FEATURE_MEDIUM_CANREAD | (writable ? FEATURE_MEDIUM_CANWRITE : 0);
+
+	return &_io_ramdisc;
+}
+
+//---------------------------------------------------------------
+// File disc
+
+static bool _file_shutdown (void) {
+	if (fileHandle >= 0) {
+		close (fileHandle);
+		fileHandle = -1;
+	}
+	return true;
+}
+
+static bool _file_startup (void) {
+	off_t size;
+
+	_file_shutdown();
+
+	if (filePath == NULL) {
+		return false;
+	}
+
+	if ((fileHandle = open (filePath, fileDisc.writable ? O_RDWR : O_RDONLY, 0)) < 0) {
+		return false;
+	}
+
+	size = lseek (fileHandle, 0, SEEK_END);
+	if (size < BYTES_PER_SECTOR) {
+		_file_shutdown();
+		return false;
+	}
+	fileDisc.numSectors = size / BYTES_PER_SECTOR;
+
+	return true;
+}
+
+static bool _file_isInserted (void) {
+	return fileHandle >= 0;
+}
+
+/*-----------------------------------------------------------------
+_file_read / _file_write
+Moves length bytes at offset, going on after short transfers and
+interrupted calls, until all of it is done or the file fails
+-----------------------------------------------------------------*/
+static bool _file_read (void* buffer, size_t length, off_t offset) {
+	ssize_t done;
+
+	while (length > 0) {
+		done = pread (fileHandle, buffer, length, offset);
+		if (done < 0 && errno == EINTR) {
+			continue;
+		}
+		if (done <= 0) {
+			return false;
+		}
+		buffer = (u8*)buffer + done;
+		length -= done;
+		offset += done;
+	}
+	return true;
+}
+
+static bool _file_write (const void* buffer, size_t length, off_t offset) {
+	ssize_t done;
+
+	while (length > 0) {
+		done = pwrite (fileHandle, buffer, length, offset);
+		if (done < 0 && errno == EINTR) {
+			continue;
+		}
+		if (done <= 0) {
+			return false;
+		}
+		buffer = (const u8*)buffer + done;
+		length -= done;
+		offset += done;
+	}
+	return true;
+}
+
+static bool _file_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	if (fileHandle < 0 || !_virtual_access (&fileDisc, sector, numSectors)) {
+		return false;
+	}
+	return _file_read (buffer, (size_t)numSectors * BYTES_PER_SECTOR, (off_t)sector * BYTES_PER_SECTOR);
+}
+
+static bool _file_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	if (fileHandle < 0 || !fileDisc.writable || !_virtual_access (&fileDisc, sector, numSectors)) {
+		return false;
+	}
+	return _file_write (buffer, (size_t)numSectors * BYTES_PER_SECTOR, (off_t)sector * BYTES_PER_SECTOR);
+}
+
+static DISC_INTERFACE _io_filedisc = {
+	DEVICE_TYPE_FILEDISC,
+	FEATURE_MEDIUM_CANREAD,
+	(FN_MEDIUM_STARTUP)&_file_startup,
+	(FN_MEDIUM_ISINSERTED)&_file_isInserted,
+	(FN_MEDIUM_READSECTORS)&_file_readSectors,
+	(FN_MEDIUM_WRITESECTORS)&_file_writeSectors,
+	(FN_MEDIUM_CLEARSTATUS)&_virtual_none,
+	(FN_MEDIUM_SHUTDOWN)&_file_shutdown
+} ;
+
+const DISC_INTERFACE* discFileInit (const char* path, bool writable) {
+	if (path == NULL) {
+		return NULL;
+	}
+
+	_file_shutdown();
+	filePath = path;
+	memset (&fileDisc, 0, sizeof(fileDisc));
+	fileDisc.writable = writable;
+
+	_io_filedisc.features = FEATURE_MEDIUM_CANREAD | (writable ? FEATURE_MEDIUM_CANWRITE : 0);
+
+	return &_io_filedisc;
+}
+
+//---------------------------------------------------------------
+// Simulated timing
+
+static VIRTUAL_DISC* _virtual_find (const DISC_INTERFACE* disc) {
+	if (disc == &_io_ramdisc) {
+		return &ramDisc;
+	}
+	if (disc == &_io_filedisc) {
+		return &fileDisc;
+	}
+	return NULL;
+}
+
+bool discVirtualSetTiming (const DISC_INTERFACE* disc, const DISC_TIMING* timing) {
+	VIRTUAL_DISC* virtualDisc = _virtual_find (disc);
+
+	if (virtualDisc == NULL) {
+		return false;
+	}
+
+	if (timing != NULL) {
+		virtualDisc->timing = *timing;
+	} else {
+		memset (&virtualDisc->timing, 0, sizeof(DISC_TIMING));
+	}
+	return true;
+}
+
+unsigned long long discVirtualElapsed (const DISC_INTERFACE* disc) {
+	VIRTUAL_DISC* virtualDisc = _virtual_find (disc);
+
+	return virtualDisc ? virtualDisc->elapsed : 0;
+}
+
+void discVirtualResetElapsed (const DISC_INTERFACE* disc) {
+	VIRTUAL_DISC* virtualDisc = _virtual_find (disc);
+
+	if (virtualDisc != NULL) {
+		virtualDisc->elapsed = 0;
+	}
+}
@@ -34,13 +34,6 @@
 #include <unistd.h>
 #include <sys/fcntl.h>
 
-const u32  DLDI_MAGIC_NUMBER = 
-	0xBF8DA5ED;	
-	
-// Stored backwards to prevent it being picked up by DLDI patchers
-const char DLDI_MAGIC_STRING_BACKWARDS [DLDI_MAGIC_STRING_LEN] =
-	{'\0', 'm', 'h', 's', 'i', 'h', 'C', ' '} ;
-
 // The only built in driver
 extern DLDI_INTERFACE _io_dldi_stub;
 
@@ -50,133 +43,110 @@ const DISC_INTERFACE* dldiGetInternal (void) {
 	return &_io_dldi_stub.ioInterface;
 }
 
+void dldiFixDriverAddresses (DLDI_INTERFACE* io) {
+	dldiRelocate (io, (u32)(uintptr_t)io);
+}
 
-bool dldiIsValid (const DLDI_INTERFACE* io) {
-	int i;
-	
-	if (io->magicNumber != DLDI_MAGIC_NUMBER) {
-		return false;
+// Reads the header of the DLDI at path onto the stack, the file is left open
+// at the end of the header
+static int _dldi_openHeader (const char* path, DLDI_INTERFACE* header) {
+	int fd;
+
+	if ((fd = open (path, O_RDONLY, 0)) < 0) {
+		return -1;
 	}
 	
-	for (i = 0; i < DLDI_MAGIC_STRING_LEN; i++) {
-		if (io->magicString[i] != DLDI_MAGIC_STRING_BACKWARDS [DLDI_MAGIC_STRING_LEN - 1 - i]) {
-			return false;
-		}
+	if (read (fd, header, sizeof(DLDI_INTERFACE)) < (int)sizeof(DLDI_INTERFACE) || !dldiIsValid (header)
+		|| dldiGetSize (header) < sizeof(DLDI_INTERFACE))
+	{
+		close (fd);
+		return -1;
 	}
-	
-	return true;
+
+	return fd;
 }
 
-void dldiFixDriverAddresses (DLDI_INTERFACE* io) {
-	u32 offset;
-	u8** address;
-	u8* oldStart;
-	u8* oldEnd;
-	
-	offset = (char*)io - (char*)(io->dldiStart);
+// Copies the header to its final place and streams the rest of the file after it
+static DLDI_INTERFACE* _dldi_loadBody (int fd, const DLDI_INTERFACE* header, void* buffer) {
+	DLDI_INTERFACE* device = (DLDI_INTERFACE*)buffer;
+	size_t dldiSize = dldiGetSize (header);
+	size_t fileSize = (char*)header->dldiEnd - (char*)header->dldiStart;
+	int bodySize;
 
-	oldStart = io->dldiStart;
-	oldEnd = io->dldiEnd;
-	
-	// Correct all pointers to the offsets from the location of this interface
-	io->dldiStart 		= (char*)io->dldiStart + offset;
-	io->dldiEnd 		= (char*)io->dldiEnd + offset;
-	io->interworkStart 	= (char*)io->interworkStart + offset;
-	io->interworkEnd 	= (char*)io->interworkEnd + offset;
-	io->gotStart 		= (char*)io->gotStart + offset;
-	io->gotEnd 			= (char*)io->gotEnd + offset;
-	io->bssStart 		= (char*)io->bssStart + offset;
-	io->bssEnd 			= (char*)io->bssEnd + offset;
-	
-	io->ioInterface.startup 		= (FN_MEDIUM_STARTUP)		((char*)io->ioInterface.startup + offset);
-	io->ioInterface.isInserted 		= (FN_MEDIUM_ISINSERTED)	((char*)io->ioInterface.isInserted + offset);
-	io->ioInterface.readSectors 	= (FN_MEDIUM_READSECTORS)	((char*)io->ioInterface.readSectors + offset);
-	io->ioInterface.writeSectors	= (FN_MEDIUM_WRITESECTORS)	((char*)io->ioInterface.writeSectors + offset);
-	io->ioInterface.clearStatus 	= (FN_MEDIUM_CLEARSTATUS)	((char*)io->ioInterface.clearStatus + offset);
-	io->ioInterface.shutdown 		= (FN_MEDIUM_SHUTDOWN)		((char*)io->ioInterface.shutdown + offset);
-
-	// Fix all addresses with in the DLDI
-	if (io->fixSectionsFlags & FIX_ALL) {
-		for (address = (u8**)io->dldiStart; address < (u8**)io->dldiEnd; address++) {
-			if (oldStart <= *address && *address < oldEnd) {
-				*address += offset;
-			}
-		}
-	}
-	
-	// Fix the interworking glue section
-	if (io->fixSectionsFlags & FIX_GLUE) {
-		for (address = (u8**)io->interworkStart; address < (u8**)io->interworkEnd; address++) {
-			if (oldStart <= *address && *address < oldEnd) {
-				*address += offset;
-			}
-		}
+	if (fileSize < sizeof(DLDI_INTERFACE)) {
+		fileSize = sizeof(DLDI_INTERFACE);
 	}
-	
-	// Fix the global offset table section
-	if (io->fixSectionsFlags & FIX_GOT) {
-		for (address = (u8**)io->gotStart; address < (u8**)io->gotEnd; address++) {
-			if (oldStart <= *address && *address < oldEnd) {
-				*address += offset;
-			}
-		}
+	if (fileSize > dldiSize) {
+		fileSize = dldiSize;
 	}
 	
-	// Initialise the BSS to 0
-	if (io->fixSectionsFlags & FIX_BSS) {
-		memset (io->bssStart, 0, (u8*)io->bssEnd - (u8*)io->bssStart);
+	memcpy (device, header, sizeof(DLDI_INTERFACE));
+	bodySize = read (fd, device + 1, fileSize - sizeof(DLDI_INTERFACE));
+	close (fd);
+	if (bodySize < 0) {
+		return NULL;
 	}
+
+	// Only the part not in the file needs clearing
+	memset ((u8*)(device + 1) + bodySize, 0, dldiSize - sizeof(DLDI_INTERFACE) - bodySize);
+
+	dldiFixDriverAddresses (device);
+
+	return device;
 }
 
 DLDI_INTERFACE* dldiLoadFromFile (const char* path) {
+	DLDI_INTERFACE header;
 	DLDI_INTERFACE* device;
 	int fd;
-	size_t dldiSize;
 
-	// Read in the DLDI header
-	if ((fd = open (path, O_RDONLY, 0)) < 0) {
+	if ((fd = _dldi_openHeader (path, &header)) < 0) {
 		return NULL;
 	}
-	
-	if ((device = malloc (sizeof(DLDI_INTERFACE))) == NULL) {
+
+	if ((device = malloc (dldiGetSize (&header))) == NULL) {
 		close (fd);
 		return NULL;
 	}
-	
-	if (read (fd, device, sizeof(DLDI_INTERFACE)) < sizeof(DLDI_INTERFACE)) {
+
+	if (_dldi_loadBody (fd, &header, device) == NULL) {
 		free (device);
-		close (fd);
 		return NULL;
 	}
-	
-	// Check that it is a valid DLDI
-	if (!dldiIsValid (device)) {
-		free (device);
-		close (fd);
+
+	return device;
+}
+
+DLDI_INTERFACE* dldiLoadFromFileInto (const char* path, void* buffer, size_t size) {
+	DLDI_INTERFACE header;
+	int fd;
+
+	if (((uintptr_t)buffer & 0x03) != 0) {
 		return NULL;
 	}
-	
-	// Calculate actual size of DLDI
-	// Although the file may only go to the dldiEnd, the BSS section can extend past that
-	if (device->dldiEnd > device->bssEnd) {
-		dldiSize = (char*)device->dldiEnd - (char*)device->dldiStart;
-	} else {
-		dldiSize = (char*)device->bssEnd - (char*)device->dldiStart;
+
+	if ((fd = _dldi_openHeader (path, &header)) < 0) {
+		return NULL;
 	}
-	dldiSize = (dldiSize + 0x03) & ~0x03; 		// Round up to nearest integer multiple
 
-	// Load entire DLDI
-	free (device);
-	if ((device = malloc (dldiSize)) == NULL) {
+	if (dldiGetSize (&header) > size) {
 		close (fd);
 		return NULL;
 	}
-	
-	memset (device, 0, dldiSize);
-	lseek (fd, 0, SEEK_SET);
-	read (fd, device, dldiSize);
-	close (fd);
-	
+
+	return _dldi_loadBody (fd, &header, buffer);
+}
+
+DLDI_INTERFACE* dldiCopyTo (const DLDI_INTERFACE* io, void* buffer, size_t size) {
+	DLDI_INTERFACE* device = (DLDI_INTERFACE*)buffer;
+
+	if (((uintptr_t)buffer & 0x03) != 0 || dldiGetSize (io) > size) {
+		return NULL;
+	}
+
+	// The copy still points at the old location, so relocating it uses
+	// the difference between the two
+	memcpy (device, io, (char*)io->dldiEnd - (char*)io->dldiStart);
 	dldiFixDriverAddresses (device);
 
 	return device;
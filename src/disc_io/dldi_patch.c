@@ -0,0 +1,218 @@
+/*
+ dldi_patch.c
+ Checking, relocating and patching DLDI drivers held in memory.
+ Nothing here depends on running on the GBA, so it also builds into
+ host tools such as tools/dldipatch. The driver's header is accessed
+ as 32 bit words rather than through the pointers in DLDI_INTERFACE,
+ which are the wrong size on a 64 bit host.
+
+ Copyright (c) 2006 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <dldi.h>
+#include <string.h>
+
+const u32  DLDI_MAGIC_NUMBER = 
+	0xBF8DA5ED;	
+	
+// Stored backwards to prevent it being picked up by DLDI patchers
+const char DLDI_MAGIC_STRING_BACKWARDS [DLDI_MAGIC_STRING_LEN] =
+	{'\0', 'm', 'h', 's', 'i', 'h', 'C', ' '} ;
+
+// Word offsets of the address fields in a driver's header
+enum {
+	DLDI_WORD_START = 16,
+	DLDI_WORD_END,
+	DLDI_WORD_INTERWORK_START,
+	DLDI_WORD_INTERWORK_END,
+	DLDI_WORD_GOT_START,
+	DLDI_WORD_GOT_END,
+	DLDI_WORD_BSS_START,
+	DLDI_WORD_BSS_END,
+	DLDI_WORD_IO_TYPE,
+	DLDI_WORD_FEATURES,
+	DLDI_WORD_STARTUP,
+	DLDI_WORD_SHUTDOWN = DLDI_WORD_STARTUP + 5
+};
+
+bool dldiIsValid (const DLDI_INTERFACE* io) {
+	int i;
+	
+	if (io->magicNumber != DLDI_MAGIC_NUMBER) {
+		return false;
+	}
+	
+	for (i = 0; i < DLDI_MAGIC_STRING_LEN; i++) {
+		if (io->magicString[i] != DLDI_MAGIC_STRING_BACKWARDS [DLDI_MAGIC_STRING_LEN - 1 - i]) {
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+// Adds offset to every word from byte start to end of the driver that
+// points into [oldStart, oldEnd)
+static void _dldi_relocate (u32* words, u32 start, u32 end, u32 oldStart, u32 oldEnd, u32 offset) {
+	u32 range = oldEnd - oldStart;
+	u32 i;
+
+	for (i = start >> 2; i < end >> 2; i++) {
+		if (words[i] - oldStart < range) {
+			words[i] += offset;
+		}
+	}
+}
+
+void dldiRelocate (DLDI_INTERFACE* io, u32 address) {
+	u32* words = (u32*)io;
+	u32 oldStart = words[DLDI_WORD_START];
+	u32 oldEnd = words[DLDI_WORD_END];
+	u32 offset = address - oldStart;		// how far the driver moves
+	int i;
+
+	// Fix all addresses within the DLDI in a single pass. FIX_ALL already
+	// covers the glue and GOT sections, otherwise each is walked once.
+	// The header is skipped here and corrected below, so no word is
+	// relocated twice. Sections are found by their offset from the start.
+	if (io->fixSectionsFlags & FIX_ALL) {
+		_dldi_relocate (words, DLDI_HEADER_SIZE, oldEnd - oldStart, oldStart, oldEnd, offset);
+	} else {
+		// Fix the interworking glue section
+		if (io->fixSectionsFlags & FIX_GLUE) {
+			_dldi_relocate (words, words[DLDI_WORD_INTERWORK_START] - oldStart, words[DLDI_WORD_INTERWORK_END] - oldStart, oldStart, oldEnd, offset);
+		}
+		// Fix the global offset table section
+		if (io->fixSectionsFlags & FIX_GOT) {
+			_dldi_relocate (words, words[DLDI_WORD_GOT_START] - oldStart, words[DLDI_WORD_GOT_END] - oldStart, oldStart, oldEnd, offset);
+		}
+	}
+
+	// Initialise the BSS to 0
+	if (io->fixSectionsFlags & FIX_BSS) {
+		memset ((u8*)io + (words[DLDI_WORD_BSS_START] - oldStart), 0, words[DLDI_WORD_BSS_END] - words[DLDI_WORD_BSS_START]);
+	}
+
+	// Correct the section addresses and the function pointers
+	for (i = DLDI_WORD_START; i <= DLDI_WORD_BSS_END; i++) {
+		words[i] += offset;
+	}
+	for (i = DLDI_WORD_STARTUP; i <= DLDI_WORD_SHUTDOWN; i++) {
+		words[i] += offset;
+	}
+}
+
+// true if [start, end) is empty or lies within [lower, upper)
+static bool _dldi_sectionWithin (u32 start, u32 end, u32 lower, u32 upper) {
+	if (start == end) {
+		return true;
+	}
+	return lower <= start && start <= end && end <= upper;
+}
+
+bool dldiValidate (const DLDI_INTERFACE* io, size_t size) {
+	const u32* words = (const u32*)io;
+	u32 start, end, bssStart, bssEnd;
+
+	if (((uintptr_t)io & 0x03) != 0 || size < DLDI_HEADER_SIZE || !dldiIsValid (io)) {
+		return false;
+	}
+
+	// The data must be in the buffer, and the header within the data
+	start = words[DLDI_WORD_START];
+	end = words[DLDI_WORD_END];
+	if (start > end || end - start < DLDI_HEADER_SIZE || end - start > size) {
+		return false;
+	}
+
+	// Sections to fix lie within the data, the BSS can run past its end
+	bssStart = words[DLDI_WORD_BSS_START];
+	bssEnd = words[DLDI_WORD_BSS_END];
+	if (!_dldi_sectionWithin (words[DLDI_WORD_INTERWORK_START], words[DLDI_WORD_INTERWORK_END], start, end)
+		|| !_dldi_sectionWithin (words[DLDI_WORD_GOT_START], words[DLDI_WORD_GOT_END], start, end)
+		|| bssStart > bssEnd
+		|| ((io->fixSectionsFlags & FIX_BSS) && bssStart != bssEnd && bssStart < start))
+	{
+		return false;
+	}
+
+	// The whole driver has to fit the size it claims
+	if (io->driverSize >= 32 || dldiGetSize (io) > (1u << io->driverSize)) {
+		return false;
+	}
+
+	return true;
+}
+
+bool dldiPatchImage (u8* image, size_t imageSize, const DLDI_INTERFACE* driver, size_t driverSize) {
+	DLDI_INTERFACE* stub;
+	size_t offset, dldiSize, dataSize;
+	u32 address;
+	u8 allocatedSize;
+
+	if (((uintptr_t)image & 0x03) != 0 || !dldiValidate (driver, driverSize)) {
+		return false;
+	}
+	dldiSize = dldiGetSize (driver);
+	dataSize = ((const u32*)driver)[DLDI_WORD_END] - ((const u32*)driver)[DLDI_WORD_START];
+
+	// Find the stub, it is word aligned
+	for (offset = 0; offset + DLDI_HEADER_SIZE <= imageSize; offset += 4) {
+		stub = (DLDI_INTERFACE*)(image + offset);
+		if (stub->magicNumber == DLDI_MAGIC_NUMBER && dldiIsValid (stub)) {
+			break;
+		}
+	}
+	if (offset + DLDI_HEADER_SIZE > imageSize) {
+		return false;
+	}
+
+	// The driver must fit in the space set aside for the stub
+	allocatedSize = stub->allocatedSize;
+	if (allocatedSize >= 32 || dldiSize > (1u << allocatedSize) || dldiSize > imageSize - offset) {
+		return false;
+	}
+
+	// The stub's own start is where the driver will run from
+	address = ((u32*)stub)[DLDI_WORD_START];
+	memmove (stub, driver, dataSize);
+	memset ((u8*)stub + dataSize, 0, dldiSize - dataSize);
+	stub->allocatedSize = allocatedSize;
+	dldiRelocate (stub, address);
+
+	return true;
+}
+
+size_t dldiGetSize (const DLDI_INTERFACE* io) {
+	const u32* words = (const u32*)io;
+	u32 dldiSize;
+
+	// Although the file may only go to the dldiEnd, the BSS section can extend past that
+	if (words[DLDI_WORD_END] > words[DLDI_WORD_BSS_END]) {
+		dldiSize = words[DLDI_WORD_END] - words[DLDI_WORD_START];
+	} else {
+		dldiSize = words[DLDI_WORD_BSS_END] - words[DLDI_WORD_START];
+	}
+	return (dldiSize + 0x03) & ~0x03; 		// Round up to nearest integer multiple
+}
@@ -36,12 +36,106 @@
 
 
 #include "io_cf_common.h"
+#include <disc_stats.h>
+#include "disc_segment.h"
+#include <string.h>
+
+// A host check replaces this to take the writes on a mock register
+#ifndef CF_WRITE_DATA
+#define CF_WRITE_DATA(reg, value) (*(reg) = (value))
+#endif
 
 //---------------------------------------------------------------
 // CF Addresses & Commands
 
 CF_REGISTERS cfRegisters = {0};
 
+// Sectors for buffers on odd addresses are read here first
+static u16 _CF_bounceBuffer[256] EWRAM_BSS;
+
+/*-----------------------------------------------------------------
+_CF_readData
+Reads an even number of bytes of the current sector into buffer,
+through the bounce buffer if it is on an odd address
+-----------------------------------------------------------------*/
+static void _CF_readData (void* buffer, u32 length) {
+	if ((u32)buffer & 0x01) {
+		_CF_readHalfwords (_CF_bounceBuffer, length >> 1);
+		memcpy (buffer, _CF_bounceBuffer, length);
+	} else {
+		_CF_readHalfwords ((u16*)buffer, length >> 1);
+	}
+}
+
+/*-----------------------------------------------------------------
+_CF_readyForCommand
+Returns true when the card has finished any previous command and
+will accept a new one, without waiting
+-----------------------------------------------------------------*/
+bool _CF_readyForCommand (void) {
+	return !(*(cfRegisters.command) & CF_STS_BUSY) && (*(cfRegisters.status) & CF_STS_INSERTED);
+}
+
+/*-----------------------------------------------------------------
+_CF_readyForData
+Returns true when the card is waiting for the next sector of the
+current command to be transferred, without waiting
+-----------------------------------------------------------------*/
+bool _CF_readyForData (void) {
+	return (*(cfRegisters.status) & 0xff) == CF_STS_READY;
+}
+
+/*-----------------------------------------------------------------
+_CF_sendCommand
+Starts reading or writing 1 to 256 sectors, 256 is sent as 0.
+The card must be ready for a command
+-----------------------------------------------------------------*/
+void _CF_sendCommand (u32 sector, u32 numSectors, u8 command) {
+	// Set number of sectors to transfer
+	*(cfRegisters.sectorCount) = (numSectors < 256 ? numSectors : 0);	// A maximum of 256 sectors, 0 means 256	
+	
+	// Set first sector
+	*(cfRegisters.lba1) = sector & 0xFF;						// 1st byte of sector number
+	*(cfRegisters.lba2) = (sector >> 8) & 0xFF;					// 2nd byte of sector number
+	*(cfRegisters.lba3) = (sector >> 16) & 0xFF;				// 3rd byte of sector number
+	*(cfRegisters.lba4) = ((sector >> 24) & 0x0F )| CF_CMD_LBA;	// last nibble of sector number
+	
+	*(cfRegisters.command) = command;
+}
+
+/*-----------------------------------------------------------------
+_CF_readSector
+Transfers the next sector of a read command into buffer, the card
+must be ready for data
+-----------------------------------------------------------------*/
+void _CF_readSector (void* buffer) {
+	_CF_readData (buffer, 512);
+}
+
+/*-----------------------------------------------------------------
+_CF_writeSector
+Transfers the next sector of a write command from buffer, the card
+must be ready for data
+-----------------------------------------------------------------*/
+void _CF_writeSector (const void* buffer) {
+	const u16 *buff = (const u16*)buffer;
+	const u8 *buff_u8 = (const u8*)buffer;
+	int i = 256;
+	int temp;
+
+	if ((u32)buff_u8 & 0x01) {
+		while(i--)
+		{
+			temp = *buff_u8++;
+			temp |= *buff_u8++ << 8;
+			CF_WRITE_DATA(cfRegisters.data, temp);
+		}
+	} else {
+		while(i--)
+			CF_WRITE_DATA(cfRegisters.data, *buff++);
+	}
+}
+
 
 /*-----------------------------------------------------------------
 _CF_isInserted
@@ -56,172 +150,158 @@ bool _CF_isInserted (void) {
 
 
 /*-----------------------------------------------------------------
-_CF_clearStatus
-Tries to make the CF card go back to idle mode
-bool return OUT:  true if a CF card is idle
+_CF_waitForCommand
+Waits until the card has finished any previous command and is
+ready for a new one
 -----------------------------------------------------------------*/
-bool _CF_clearStatus (void) {
+static bool _CF_waitForCommand (void) {
 	int i;
-	
+
 	// Wait until CF card is finished previous commands
 	i=0;
 	while ((*(cfRegisters.command) & CF_STS_BUSY) && (i < CF_CARD_TIMEOUT)) {
 		i++;
 	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
 	
 	// Wait until card is ready for commands
 	i = 0;
 	while ((!(*(cfRegisters.status) & CF_STS_INSERTED)) && (i < CF_CARD_TIMEOUT)) {
 		i++;
 	}
-	if (i >= CF_CARD_TIMEOUT)
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
+	if (i >= CF_CARD_TIMEOUT) {
+		DISC_DRIVER_COUNT(cardTimeouts, 1);
 		return false;
+	}
 
 	return true;
 }
 
+/*-----------------------------------------------------------------
+_CF_clearStatus
+Tries to make the CF card go back to idle mode
+bool return OUT:  true if a CF card is idle
+-----------------------------------------------------------------*/
+bool _CF_clearStatus (void) {
+	return _CF_waitForCommand();
+}
+
+
+/*-----------------------------------------------------------------
+_CF_waitForData
+Waits until the card is ready to transfer the next sector
+-----------------------------------------------------------------*/
+static bool _CF_waitForData (void) {
+	int i = 0;
+
+	while (((*(cfRegisters.status) & 0xff) != CF_STS_READY) && (i < CF_CARD_TIMEOUT)) {
+		i++;
+	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
+	if (i >= CF_CARD_TIMEOUT) {
+		DISC_DRIVER_COUNT(cardTimeouts, 1);
+		return false;
+	}
+
+	return true;
+}
 
 /*-----------------------------------------------------------------
 _CF_readSectors
 Read 512 byte sector numbered "sector" into "buffer"
 u32 sector IN: address of first 512 byte sector on CF card to read
 u32 numSectors IN: number of 512 byte sectors to read,
- 1 to 256 sectors can be read
+ more than 256 sectors are read with several commands
 void* buffer OUT: pointer to 512 byte buffer to store data in
 bool return OUT: true if successful
 -----------------------------------------------------------------*/
 bool _CF_readSectors (u32 sector, u32 numSectors, void* buffer) {
-	int i;
+	DISC_SEGMENT segment = { buffer, numSectors * 512 };
 
-	u16 *buff = (u16*)buffer;
-	u8 *buff_u8 = (u8*)buffer;
-	int temp;
+	return _CF_readSectorsV (sector, &segment, 1);
+}
 
-	// Wait until CF card is finished previous commands
-	i=0;
-	while ((*(cfRegisters.command) & CF_STS_BUSY) && (i < CF_CARD_TIMEOUT)) {
-		i++;
-	}
-	
-	// Wait until card is ready for commands
-	i = 0;
-	while ((!(*(cfRegisters.status) & CF_STS_INSERTED)) && (i < CF_CARD_TIMEOUT)) {
-		i++;
-	}
-	if (i >= CF_CARD_TIMEOUT)
-		return false;
-	
-	// Set number of sectors to read
-	*(cfRegisters.sectorCount) = (numSectors < 256 ? numSectors : 0);	// Read a maximum of 256 sectors, 0 means 256	
-	
-	// Set read sector
-	*(cfRegisters.lba1) = sector & 0xFF;						// 1st byte of sector number
-	*(cfRegisters.lba2) = (sector >> 8) & 0xFF;					// 2nd byte of sector number
-	*(cfRegisters.lba3) = (sector >> 16) & 0xFF;				// 3rd byte of sector number
-	*(cfRegisters.lba4) = ((sector >> 24) & 0x0F )| CF_CMD_LBA;	// last nibble of sector number
-	
-	// Set command to read
-	*(cfRegisters.command) = CF_CMD_READ;
-	
-	
-	while (numSectors--)
-	{
-		// Wait until card is ready for reading
-		i = 0;
-		while (((*(cfRegisters.status) & 0xff)!= CF_STS_READY) && (i < CF_CARD_TIMEOUT))
-		{
-			i++;
-		}
-		if (i >= CF_CARD_TIMEOUT)
+/*-----------------------------------------------------------------
+_CF_readSectorsV
+Read sectors starting at "sector" straight into a list of segments
+u32 sector IN: address of first 512 byte sector on CF card to read
+const DISC_SEGMENT* segments IN: where to put the data, even lengths
+ adding up to whole sectors
+int numSegments IN: number of segments
+bool return OUT: true if successful
+-----------------------------------------------------------------*/
+bool _CF_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments) {
+	DISC_SEGMENT_CURSOR cursor;
+	u32 numSectors = _segment_total (segments, numSegments) / 512;
+	u32 run, left, span;
+
+	_segment_start (&cursor, segments, numSegments);
+
+	while (numSectors > 0) {
+		// A single command transfers at most 256 sectors
+		run = numSectors < 256 ? numSectors : 256;
+		numSectors -= run;
+
+		if (!_CF_waitForCommand()) {
 			return false;
-		
-		// Read data
-		i=256;
-		if ((u32)buff_u8 & 0x01) {
-			while(i--)
-			{
-				temp = *(cfRegisters.data);
-				*buff_u8++ = temp & 0xFF;
-				*buff_u8++ = temp >> 8;
+		}
+
+		_CF_sendCommand (sector, run, CF_CMD_READ);
+		sector += run;
+
+		while (run--) {
+			// Wait until card is ready for reading
+			if (!_CF_waitForData()) {
+				return false;
+			}
+
+			// Read data, a piece of the sector for each segment it falls in
+			for (left = 512; left > 0; left -= span) {
+				span = _segment_span (&cursor, left);
+				_CF_readData (cursor.data, span);
+				_segment_advance (&cursor, span);
 			}
-		} else {
-			while(i--)
-				*buff++ = *(cfRegisters.data); 
 		}
 	}
 
 	return true;
 }
 
-
-
 /*-----------------------------------------------------------------
 _CF_writeSectors
 Write 512 byte sector numbered "sector" from "buffer"
 u32 sector IN: address of 512 byte sector on CF card to read
 u32 numSectors IN: number of 512 byte sectors to read,
- 1 to 256 sectors can be read
+ more than 256 sectors are written with several commands
 void* buffer IN: pointer to 512 byte buffer to read data from
 bool return OUT: true if successful
 -----------------------------------------------------------------*/
 bool _CF_writeSectors (u32 sector, u32 numSectors, void* buffer) {
-	int i;
-
-	u16 *buff = (u16*)buffer;
 	u8 *buff_u8 = (u8*)buffer;
-	int temp;
+	u32 run;
 
-	// Wait until CF card is finished previous commands
-	i=0;
-	while ((*(cfRegisters.command) & CF_STS_BUSY) && (i < CF_CARD_TIMEOUT))
-	{
-		i++;
-	}
-	
-	// Wait until card is ready for commands
-	i = 0;
-	while ((!(*(cfRegisters.status) & CF_STS_INSERTED)) && (i < CF_CARD_TIMEOUT))
-	{
-		i++;
-	}
-	if (i >= CF_CARD_TIMEOUT)
-		return false;
-	
-	// Set number of sectors to write
-	*(cfRegisters.sectorCount) = (numSectors < 256 ? numSectors : 0);	// Write a maximum of 256 sectors, 0 means 256	
-	
-	// Set write sector
-	*(cfRegisters.lba1) = sector & 0xFF;						// 1st byte of sector number
-	*(cfRegisters.lba2) = (sector >> 8) & 0xFF;					// 2nd byte of sector number
-	*(cfRegisters.lba3) = (sector >> 16) & 0xFF;				// 3rd byte of sector number
-	*(cfRegisters.lba4) = ((sector >> 24) & 0x0F )| CF_CMD_LBA;	// last nibble of sector number
-	
-	// Set command to write
-	*(cfRegisters.command) = CF_CMD_WRITE;
-	
-	while (numSectors--)
-	{
-		// Wait until card is ready for writing
-		i = 0;
-		while (((*(cfRegisters.status) & 0xff) != CF_STS_READY) && (i < CF_CARD_TIMEOUT))
-		{
-			i++;
-		}
-		if (i >= CF_CARD_TIMEOUT)
+	while (numSectors > 0) {
+		// A single command transfers at most 256 sectors
+		run = numSectors < 256 ? numSectors : 256;
+		numSectors -= run;
+
+		if (!_CF_waitForCommand()) {
 			return false;
-		
-		// Write data
-		i=256;
-		if ((u32)buff_u8 & 0x01) {
-			while(i--)
-			{
-				temp = *buff_u8++;
-				temp |= *buff_u8++ << 8;
-				*(cfRegisters.data) = temp;
+		}
+
+		_CF_sendCommand (sector, run, CF_CMD_WRITE);
+		sector += run;
+
+		while (run--) {
+			// Wait until card is ready for writing
+			if (!_CF_waitForData()) {
+				return false;
 			}
-		} else {
-		while(i--)
-			*(cfRegisters.data) = *buff++; 
+
+			// Write data
+			_CF_writeSector (buff_u8);
+			buff_u8 += 512;
 		}
 	}
 	
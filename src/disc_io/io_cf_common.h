@@ -33,6 +33,7 @@
 #define IO_CF_COMMON_H
 
 #include <disc_io.h>
+#include "gba_base.h"
 
 typedef struct {
 	vu16* data;
@@ -62,11 +63,24 @@ typedef struct {
 
 #define CF_CARD_TIMEOUT	10000000
 
+extern CF_REGISTERS cfRegisters;
+
 bool _CF_isInserted (void);
 bool _CF_clearStatus (void);
 bool _CF_readSectors (u32 sector, u32 numSectors, void* buffer);
+bool _CF_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments);
 bool _CF_writeSectors (u32 sector, u32 numSectors, void* buffer);
 bool _CF_shutdown(void);
 bool _CF_startup(const CF_REGISTERS *usableCfRegs);
 
+// Non-blocking steps of a transfer, for driving one from an interrupt
+bool _CF_readyForCommand (void);
+bool _CF_readyForData (void);
+void _CF_sendCommand (u32 sector, u32 numSectors, u8 command);
+void _CF_readSector (void* buffer);
+void _CF_writeSector (const void* buffer);
+
+// Reads count halfwords from the data register, runs from IWRAM
+extern IWRAM_CODE void _CF_readHalfwords (u16* buff, u32 count);
+
 #endif // define IO_CF_COMMON_H
@@ -0,0 +1,65 @@
+/*
+	io_cf_read.iwram.c
+
+	By chishm (Michael Chisholm)
+
+	Compact flash data register reads, built as ARM code and run from IWRAM
+
+ Copyright (c) 2006 Michael "Chishm" Chisholm
+	
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation and/or
+     other materials provided with the distribution.
+  3. The name of the author may not be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "io_cf_common.h"
+
+// A host check replaces this to feed the reads from a mock register
+#ifndef CF_READ_DATA
+#define CF_READ_DATA(reg) (*(reg))
+#endif
+
+/*-----------------------------------------------------------------
+_CF_readHalfwords
+Reads count halfwords from the data register into a halfword aligned
+buffer, eight to a loop. Every read is from the one register address:
+DMA can't be used, as a Game Pak source address always increments
+whatever the source control bits say.
+-----------------------------------------------------------------*/
+IWRAM_CODE void _CF_readHalfwords (u16* buff, u32 count) {
+	vu16* data = cfRegisters.data;
+
+	while (count >= 8) {
+		buff[0] = CF_READ_DATA(data);
+		buff[1] = CF_READ_DATA(data);
+		buff[2] = CF_READ_DATA(data);
+		buff[3] = CF_READ_DATA(data);
+		buff[4] = CF_READ_DATA(data);
+		buff[5] = CF_READ_DATA(data);
+		buff[6] = CF_READ_DATA(data);
+		buff[7] = CF_READ_DATA(data);
+		buff += 8;
+		count -= 8;
+	}
+
+	while (count--) {
+		*buff++ = CF_READ_DATA(data);
+	}
+}
@@ -34,16 +34,19 @@
 #include "io_m3sd.h"
 #include "io_sd_common.h"
 #include "io_m3_common.h"
+#include <disc_stats.h>
+#include "disc_segment.h"
 
 //---------------------------------------------------------------
-// M3SD register addresses
-
+// M3SD register addresses, unless a host check supplies its own
+#ifndef REG_M3SD_DIR
 #define REG_M3SD_DIR	(*(vu16*)0x08800000)	// direction control register
 #define REG_M3SD_DAT	(*(vu16*)0x09000000)	// SD data line, 8 bits at a time
 #define REG_M3SD_CMD	(*(vu16*)0x09200000)	// SD command byte
 #define REG_M3SD_ARGH	(*(vu16*)0x09400000)	// SD command argument, high halfword
 #define REG_M3SD_ARGL	(*(vu16*)0x09600000)	// SD command argument, low halfword
 #define REG_M3SD_STS	(*(vu16*)0x09800000)	// command and status register
+#endif
 
 //---------------------------------------------------------------
 // Send / receive timeouts, to stop infinite wait loops
@@ -51,6 +54,7 @@
 #define TRANSMIT_TIMEOUT 20000	// Time to wait for the M3 to respond to transmit or receive requests
 #define RESPONSE_TIMEOUT 256	// Number of clocks sent to the SD card before giving up
 #define WRITE_TIMEOUT	3000	// Time to wait for the card to finish writing
+#define BUSY_WAIT_TIMEOUT 500000	// Data line clocks to wait for the card to stop signalling busy
 
 #define BYTES_PER_READ 512
 
@@ -70,9 +74,11 @@ static inline bool _M3SD_waitOnBusy (void) {
 	while ( (REG_M3SD_STS & 0x01) == 0x00) {
 		i++;
 		if (i >= TRANSMIT_TIMEOUT) {
+			DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 			return false;
 		}
 	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
 	return true;
 }
 
@@ -81,9 +87,11 @@ static inline bool _M3SD_waitForDataReady (void) {
 	while ( (REG_M3SD_STS & 0x40) == 0x00) {
 		i++;
 		if (i >= TRANSMIT_TIMEOUT) {
+			DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 			return false;
 		}
 	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
 	return true;
 }
 
@@ -112,9 +120,11 @@ static bool _M3SD_sendByte (u8 byte) {
 	while ((REG_M3SD_STS & 0x04) == 0) {
 		i++;
 		if (i >= TRANSMIT_TIMEOUT) {
+			DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 			return false;
 		}
 	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
 	return true;
 }
 
@@ -128,18 +138,22 @@ static u8 _M3SD_getByte (void) {
 	while ((REG_M3SD_STS & 0x08) == 0) {
 		i++;
 		if (i >= TRANSMIT_TIMEOUT) {
+			DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 			// Return an empty byte if a timeout occurs
 			return 0xFF;
 		}
 	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
 	i = 0;
 	while ((REG_M3SD_STS & 0x08) != 0) {
 		i++;
 		if (i >= TRANSMIT_TIMEOUT) {
+			DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 			// Return an empty byte if a timeout occurs
 			return 0xFF;
 		}
 	}
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
 	// Return the data
 	return (REG_M3SD_DAT & 0xff);
 }
@@ -259,11 +273,13 @@ static bool _M3SD_initCard (void) {
 				&_M3SD_relativeCardAddress);
 }
 
-static bool _M3SD_readData (void* buffer) {
+// Reads one sector into the segments at cursor
+static bool _M3SD_readData (DISC_SEGMENT_CURSOR* cursor) {
 	u32 i;
-	u8* buff_u8 = (u8*)buffer;
-	u16* buff = (u16*)buffer;
+	u8* buff_u8;
+	u16* buff;
 	u16 temp;
+	u32 left, span;
 
 	REG_M3SD_DIR = 0x49;
 	if (!_M3SD_waitForDataReady()) {
@@ -277,17 +293,24 @@ static bool _M3SD_readData (void* buffer) {
 	
 	i = REG_M3SD_DIR;
 	// Read data
-	i=256;
-	if ((u32)buff_u8 & 0x01) {
-		while(i--)
-		{
-			temp = REG_M3SD_DIR;
-			*buff_u8++ = temp & 0xFF;
-			*buff_u8++ = temp >> 8;
+	for (left = BYTES_PER_READ; left > 0; left -= span) {
+		span = _segment_span (cursor, left);
+		buff_u8 = cursor->data;
+		buff = (u16*)buff_u8;
+		_segment_advance (cursor, span);
+
+		i = span >> 1;
+		if ((u32)buff_u8 & 0x01) {
+			while(i--)
+			{
+				temp = REG_M3SD_DIR;
+				*buff_u8++ = temp & 0xFF;
+				*buff_u8++ = temp >> 8;
+			}
+		} else {
+			while(i--)
+				*buff++ = REG_M3SD_DIR; 
 		}
-	} else {
-		while(i--)
-			*buff++ = REG_M3SD_DIR; 
 	}
 	// Read end checksum
 	i = REG_M3SD_DIR + REG_M3SD_DIR + REG_M3SD_DIR + REG_M3SD_DIR;
@@ -329,13 +352,27 @@ static void _M3SD_clkin (void) {
 	);*/
 }
 
+// Clock the data lines until the card stops holding them busy
+static bool _M3SD_waitOnDataBusy (void) {
+	int i = 0;
+	do {
+		if (i++ >= BUSY_WAIT_TIMEOUT) {
+			DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
+			return false;
+		}
+		_M3SD_clkin();
+	} while ((REG_M3SD_DAT & 0x100) == 0);
+	DISC_DRIVER_COUNT(busyWaitLoops, i);
+	return true;
+}
+
 static bool _M3SD_writeData (u8* data, u8* crc) {
 	int i;
 	u8 temp;
 
-	do {
-		_M3SD_clkin();
-	} while ((REG_M3SD_DAT & 0x100) == 0);
+	if (!_M3SD_waitOnDataBusy()) {
+		return false;
+	}
 	
 	REG_M3SD_DAT = 0;	// Start bit
 	
@@ -369,11 +406,7 @@ static bool _M3SD_writeData (u8* data, u8* crc) {
 		_M3SD_clkout();
 	}
 	
-	do {
-		_M3SD_clkin();
-	} while ((REG_M3SD_DAT & 0x100) == 0);
-	
-	return true;
+	return _M3SD_waitOnDataBusy();
 }
 
 //---------------------------------------------------------------
@@ -384,6 +417,30 @@ bool _M3SD_startUp (void) {
 	return _M3SD_initCard();
 }
 
+/*-----------------------------------------------------------------
+_M3SD_probe
+Quick check for an M3 SD which leaves the card alone. In ROM mode the
+register addresses read back cartridge memory, in media mode they
+read the M3's SD interface. Other hardware reads the same in both
+modes. The card is only reset and initialised by _M3SD_startUp.
+-----------------------------------------------------------------*/
+bool _M3SD_probe (void) {
+	u16 romDir, romSts;
+	bool found;
+
+	_M3_changeMode (M3_MODE_ROM);
+	romDir = REG_M3SD_DIR;
+	romSts = REG_M3SD_STS;
+
+	_M3SD_unlock();
+	found = (REG_M3SD_DIR != romDir) || (REG_M3SD_STS != romSts);
+
+	if (!found) {
+		_M3_changeMode (M3_MODE_ROM);
+	}
+	return found;
+}
+
 bool _M3SD_isInserted (void) {
 	u8 responseBuffer [6];
 	// Make sure the card receives the command
@@ -402,9 +459,18 @@ bool _M3SD_isInserted (void) {
 }
 
 bool _M3SD_readSectors (u32 sector, u32 numSectors, void* buffer) {
+	DISC_SEGMENT segment = { buffer, numSectors * BYTES_PER_READ };
+
+	return _M3SD_readSectorsV (sector, &segment, 1);
+}
+
+bool _M3SD_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments) {
+	DISC_SEGMENT_CURSOR cursor;
+	u32 numSectors = _segment_total (segments, numSegments) / BYTES_PER_READ;
 	u32 i;
-	u8* dest = (u8*) buffer;
 	u8 responseBuffer[6];
+
+	_segment_start (&cursor, segments, numSegments);
 	
 	if (numSectors == 1) {
 		// If it's only reading one sector, use the (slightly faster) READ_SINGLE_BLOCK
@@ -412,7 +478,7 @@ bool _M3SD_readSectors (u32 sector, u32 numSectors, void* buffer) {
 			return false;
 		}
 
-		if (!_M3SD_readData (buffer)) {
+		if (!_M3SD_readData (&cursor)) {
 			return false;
 		}
 
@@ -422,8 +488,8 @@ bool _M3SD_readSectors (u32 sector, u32 numSectors, void* buffer) {
 			return false;
 		}
 	
-		for(i=0; i < numSectors; i++, dest+=BYTES_PER_READ) {
-			if (!_M3SD_readData(dest)) {
+		for(i=0; i < numSectors; i++) {
+			if (!_M3SD_readData(&cursor)) {
 				return false;
 			}
 			REG_M3SD_STS = 0x8;
@@ -437,12 +503,81 @@ bool _M3SD_readSectors (u32 sector, u32 numSectors, void* buffer) {
 	return true;
 }
 
+// Wait for the card to be ready for the next transfer
+static bool _M3SD_waitForTransfer (void) {
+	u8 responseBuffer[6];
+	int i;
+
+	i = WRITE_TIMEOUT;
+	responseBuffer[3] = 0;
+	do {
+		_M3SD_sendCommand (SEND_STATUS, _M3SD_relativeCardAddress);
+		_M3SD_getResponse_R1 (responseBuffer);
+		i--;
+		if (i <= 0) {
+			DISC_DRIVER_COUNT(writeTimeouts, 1);
+			return false;
+		}
+	} while (((responseBuffer[3] & 0x1f) != ((SD_STATE_TRAN << 1) | READY_FOR_DATA)));
+	DISC_DRIVER_COUNT(statusPolls, WRITE_TIMEOUT - i);
+
+	return true;
+}
+
+// Stream several sectors with a single WRITE_MULTIPLE_BLOCK. The card is told
+// the length first so it can erase the whole run before programming.
+static bool _M3SD_writeMultipleSectors (u32 sector, u32 numSectors, u8* data) {
+	u8 crc[8];
+	u8 responseBuffer[6];
+	bool sent = true;
+
+	// Pre-erase is only a hint, carry on if the card doesn't support it
+	_M3SD_sendCommand (APP_CMD, _M3SD_relativeCardAddress);
+	if (_M3SD_getResponse_R1 (responseBuffer)) {
+		_M3SD_sendCommand (SET_WR_BLK_ERASE_COUNT, numSectors);
+		_M3SD_getResponse_R1 (responseBuffer);
+	}
+
+	_SD_CRC16 ( data, BYTES_PER_READ, crc);
+
+	_M3SD_sendCommand (WRITE_MULTIPLE_BLOCK, sector * BYTES_PER_READ);
+	if (!_M3SD_getResponse_R1 (responseBuffer)) {
+		return false;
+	}
+
+	while (numSectors--) {
+		REG_M3SD_DIR = 0x4;
+		REG_M3SD_STS = 0x0;
+
+		// Send the data, this waits for the card to accept the block
+		if (! _M3SD_writeData( data, crc)) {
+			sent = false;
+			break;
+		}
+
+		if (numSectors > 0) {
+			data += BYTES_PER_READ;
+			_SD_CRC16 ( data, BYTES_PER_READ, crc);
+		}
+	}
+
+	// Stop the streaming, even after a failure so the card returns to the transfer state
+	_M3SD_sendCommand (STOP_TRANSMISSION, 0);
+	_M3SD_getResponse_R1b (responseBuffer);
+
+	return _M3SD_waitForTransfer() && sent;
+}
+
 bool _M3SD_writeSectors (u32 sector, u32 numSectors, const void* buffer) {
 	u8 crc[8];
 	u8 responseBuffer[6];
 	u32 offset = sector * BYTES_PER_READ;
 	u8* data = (u8*) buffer;
-	int i;
+
+	if (numSectors > 1) {
+		return _M3SD_writeMultipleSectors (sector, numSectors, data);
+	}
+
 	// Precalculate the data CRC
 	_SD_CRC16 ( data, BYTES_PER_READ, crc);
 	
@@ -469,16 +604,9 @@ bool _M3SD_writeSectors (u32 sector, u32 numSectors, const void* buffer) {
 		}
 		
 		// Wait for the card to be ready for the next transfer
-		i = WRITE_TIMEOUT;
-		responseBuffer[3] = 0;
-		do {
-			_M3SD_sendCommand (SEND_STATUS, _M3SD_relativeCardAddress);
-			_M3SD_getResponse_R1 (responseBuffer);
-			i--;
-			if (i <= 0) {
-				return false;
-			}
-		} while (((responseBuffer[3] & 0x1f) != ((SD_STATE_TRAN << 1) | READY_FOR_DATA)));
+		if (!_M3SD_waitForTransfer()) {
+			return false;
+		}
 	}
 	
 	return true;
@@ -42,4 +42,10 @@
 // export interface
 extern const DISC_INTERFACE _io_m3sd ;
 
+// quick hardware check used by discGetInterface before a full startup
+extern bool _M3SD_probe (void);
+
+// scatter/gather read, used by discReadSectorsV
+extern bool _M3SD_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments);
+
 #endif	// define IO_M3SD_H
@@ -34,9 +34,12 @@
 #include "io_scsd.h"
 #include "io_sd_common.h"
 #include "io_sc_common.h"
+#include <disc_stats.h>
+#include "disc_segment.h"
 
 //---------------------------------------------------------------
-// SCSD register addresses
+// SCSD register addresses, unless a host check supplies its own
+#ifndef REG_SCSD_CMD
 #define REG_SCSD_CMD	(*(vu16*)(0x09800000))
 	/* bit 0: command bit to read  		*/
 	/* bit 7: command bit to write 		*/
@@ -49,6 +52,7 @@
 	/* bit 0: 1				*/
 	/* bit 1: enable IO interface (SD,CF)	*/
 	/* bit 2: enable R/W SDRAM access 	*/
+#endif
 
 //---------------------------------------------------------------
 // Responses
@@ -68,6 +72,7 @@
 //---------------------------------------------------------------
 // Variables required for tracking SD state
 static u32 _SCSD_relativeCardAddress = 0;	// Preshifted Relative Card Address
+static u8 _SCSD_statusPacket[6];			// SEND_STATUS for this card, polled while writing
 
 //---------------------------------------------------------------
 // Internal SC SD functions
@@ -82,33 +87,24 @@ static inline void _SCSD_enable_lite (void) {
 	REG_SCSD_LITE_ENABLE = 0;
 }
 
-static bool _SCSD_sendCommand (u8 command, u32 argument) {
-	u8 databuff[6];
-	u8 *tempDataPtr = databuff;
+static bool _SCSD_sendPacket (const u8* packet) {
 	int length = 6;
 	u16 dataByte;
 	int curBit;
 	int i;
 
-	*tempDataPtr++ = command | 0x40;
-	*tempDataPtr++ = argument>>24;
-	*tempDataPtr++ = argument>>16;
-	*tempDataPtr++ = argument>>8;
-	*tempDataPtr++ = argument;
-	*tempDataPtr = _SD_CRC7 (databuff, 5);
-
 	i = BUSY_WAIT_TIMEOUT;
 	while (((REG_SCSD_CMD & 0x01) == 0) && (--i));
+	DISC_DRIVER_COUNT(busyWaitLoops, BUSY_WAIT_TIMEOUT - i);
 	if (i == 0) {
+		DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 		return false;
 	}
 		
 	dataByte = REG_SCSD_CMD;
 
-	tempDataPtr = databuff;
-	
 	while (length--) {
-		dataByte = *tempDataPtr++;
+		dataByte = *packet++;
 		for (curBit = 7; curBit >=0; curBit--){
 			REG_SCSD_CMD = dataByte;
 			dataByte = dataByte << 1;
@@ -118,6 +114,22 @@ static bool _SCSD_sendCommand (u8 command, u32 argument) {
 	return true;
 }
 
+static void _SCSD_buildPacket (u8* packet, u8 command, u32 argument) {
+	packet[0] = command | 0x40;
+	packet[1] = argument>>24;
+	packet[2] = argument>>16;
+	packet[3] = argument>>8;
+	packet[4] = argument;
+	packet[5] = _SD_CRC7 (packet, 5);
+}
+
+static bool _SCSD_sendCommand (u8 command, u32 argument) {
+	u8 databuff[6];
+
+	_SCSD_buildPacket (databuff, command, argument);
+	return _SCSD_sendPacket (databuff);
+}
+
 // Returns the response from the SD card to a previous command.
 static bool _SCSD_getResponse (u8* dest, u32 length) {
 	u32 i;	
@@ -127,12 +139,14 @@ static bool _SCSD_getResponse (u8* dest, u32 length) {
 	// Wait for the card to be non-busy
 	i = BUSY_WAIT_TIMEOUT;
 	while (((REG_SCSD_CMD & 0x01) != 0) && (--i));
+	DISC_DRIVER_COUNT(busyWaitLoops, BUSY_WAIT_TIMEOUT - i);
 	if (dest == NULL) {
 		return true;
 	}
 	
 	if (i == 0) {
 		// Still busy after the timeout has passed
+		DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 		return false;
 	}
 	
@@ -213,37 +227,55 @@ static bool _SCSD_initCard (void) {
 	_SCSD_relativeCardAddress = 0;
 
 	// Init the card
-	return _SD_InitCard (_SCSD_cmd_6byte_response, 
+	if (!_SD_InitCard (_SCSD_cmd_6byte_response, 
 				_SCSD_cmd_17byte_response,
 				true,
-				&_SCSD_relativeCardAddress);
+				&_SCSD_relativeCardAddress))
+	{
+		return false;
+	}
+
+	// The card's address won't change now, so the status command never does either
+	_SCSD_buildPacket (_SCSD_statusPacket, SEND_STATUS, _SCSD_relativeCardAddress);
+	return true;
 }
 
-static bool _SCSD_readData (void* buffer) {
-	u8* buff_u8 = (u8*)buffer;
-	u16* buff = (u16*)buffer;
+// Reads one sector into the segments at cursor
+static bool _SCSD_readData (DISC_SEGMENT_CURSOR* cursor) {
+	u8* buff_u8;
+	u16* buff;
 	volatile register u32 temp;
 	int i;
+	u32 left, span;
 	
 	i = BUSY_WAIT_TIMEOUT;
 	while ((REG_SCSD_DATAREAD & SCSD_STS_BUSY) && (--i));
+	DISC_DRIVER_COUNT(busyWaitLoops, BUSY_WAIT_TIMEOUT - i);
 	if (i == 0) {
+		DISC_DRIVER_COUNT(busyWaitTimeouts, 1);
 		return false;
 	}
 
-	i=256;
-	if ((u32)buff_u8 & 0x01) {
-		while(i--) {
-			temp = REG_SCSD_DATAREAD_32;
-			temp = REG_SCSD_DATAREAD_32 >> 16;
-			*buff_u8++ = (u8)temp;
-			*buff_u8++ = (u8)(temp >> 8);
-		}
-	} else {
-		while(i--) {
-			temp = REG_SCSD_DATAREAD_32;
-			temp = REG_SCSD_DATAREAD_32 >> 16;
-			*buff++ = temp; 
+	for (left = BYTES_PER_READ; left > 0; left -= span) {
+		span = _segment_span (cursor, left);
+		buff_u8 = cursor->data;
+		buff = (u16*)buff_u8;
+		_segment_advance (cursor, span);
+
+		i = span >> 1;
+		if ((u32)buff_u8 & 0x01) {
+			while(i--) {
+				temp = REG_SCSD_DATAREAD_32;
+				temp = REG_SCSD_DATAREAD_32 >> 16;
+				*buff_u8++ = (u8)temp;
+				*buff_u8++ = (u8)(temp >> 8);
+			}
+		} else {
+			while(i--) {
+				temp = REG_SCSD_DATAREAD_32;
+				temp = REG_SCSD_DATAREAD_32 >> 16;
+				*buff++ = temp; 
+			}
 		}
 	}
 
@@ -265,6 +297,30 @@ bool _SCSD_startUp (void) {
 	return _SCSD_initCard();
 }
 
+/*-----------------------------------------------------------------
+_SCSD_probe
+Quick check for a SuperCard SD which leaves the card alone. Until the
+SuperCard is switched to media mode the command register address
+reads back cartridge memory, afterwards it reads the SD command line,
+which idles high. Other hardware reads the same in both modes. The
+card is only reset and initialised by _SCSD_startUp.
+-----------------------------------------------------------------*/
+bool _SCSD_probe (void) {
+	u16 rom;
+	bool found;
+
+	_SC_changeMode (SC_MODE_RAM_RO);
+	rom = REG_SCSD_CMD;
+
+	_SCSD_unlock();
+	found = (REG_SCSD_CMD != rom) && (REG_SCSD_CMD & 0x01);
+
+	if (!found) {
+		_SC_changeMode (SC_MODE_RAM_RO);
+	}
+	return found;
+}
+
 bool _SCSD_isInserted (void) {
 	u8 responseBuffer [6];
 
@@ -284,9 +340,18 @@ bool _SCSD_isInserted (void) {
 }
 
 bool _SCSD_readSectors (u32 sector, u32 numSectors, void* buffer) {
+	DISC_SEGMENT segment = { buffer, numSectors * BYTES_PER_READ };
+
+	return _SCSD_readSectorsV (sector, &segment, 1);
+}
+
+bool _SCSD_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments) {
+	DISC_SEGMENT_CURSOR cursor;
+	u32 numSectors = _segment_total (segments, numSegments) / BYTES_PER_READ;
 	u32 i;
-	u8* dest = (u8*) buffer;
 	u8 responseBuffer[6];
+
+	_segment_start (&cursor, segments, numSegments);
 	
 	if (numSectors == 1) {
 		// If it's only reading one sector, use the (slightly faster) READ_SINGLE_BLOCK
@@ -294,7 +359,7 @@ bool _SCSD_readSectors (u32 sector, u32 numSectors, void* buffer) {
 			return false;
 		}
 
-		if (!_SCSD_readData (buffer)) {
+		if (!_SCSD_readData (&cursor)) {
 			return false;
 		}
 
@@ -304,8 +369,8 @@ bool _SCSD_readSectors (u32 sector, u32 numSectors, void* buffer) {
 			return false;
 		}
 	
-		for(i=0; i < numSectors; i++, dest+=BYTES_PER_READ) {
-			if (!_SCSD_readData(dest)) {
+		for(i=0; i < numSectors; i++) {
+			if (!_SCSD_readData(&cursor)) {
 				return false;
 			}
 		}
@@ -319,12 +384,75 @@ bool _SCSD_readSectors (u32 sector, u32 numSectors, void* buffer) {
 	return true;
 }
 
+// Wait until card is finished programming and back in the transfer state
+static bool _SCSD_waitForTransfer (void) {
+	u8 responseBuffer[6];
+	int i;
+
+	i = WRITE_TIMEOUT;
+	responseBuffer[3] = 0;
+	do {
+		_SCSD_sendPacket (_SCSD_statusPacket);
+		_SCSD_getResponse_R1 (responseBuffer);
+		i--;
+		if (i <= 0) {
+			DISC_DRIVER_COUNT(writeTimeouts, 1);
+			return false;
+		}
+	} while (((responseBuffer[3] & 0x1f) != ((SD_STATE_TRAN << 1) | READY_FOR_DATA)));
+	DISC_DRIVER_COUNT(statusPolls, WRITE_TIMEOUT - i);
+
+	return true;
+}
+
+// Stream several sectors with a single WRITE_MULTIPLE_BLOCK. The card is told
+// the length first so it can erase the whole run before programming.
+static bool _SCSD_writeMultipleSectors (u32 sector, u32 numSectors, u8* data) {
+	u16 crc[4];	// One per data line
+	u8 responseBuffer[6];
+	bool sent = true;
+
+	// Pre-erase is only a hint, carry on if the card doesn't support it
+	_SCSD_sendCommand (APP_CMD, _SCSD_relativeCardAddress);
+	if (_SCSD_getResponse_R1 (responseBuffer)) {
+		_SCSD_sendCommand (SET_WR_BLK_ERASE_COUNT, numSectors);
+		_SCSD_getResponse_R1 (responseBuffer);
+	}
+
+	_SCSD_sendCommand (WRITE_MULTIPLE_BLOCK, sector * BYTES_PER_READ);
+	if (!_SCSD_getResponse_R1 (responseBuffer)) {
+		return false;
+	}
+
+	while (numSectors--) {
+		_SD_CRC16 ( data, BYTES_PER_READ, (u8*)crc);
+
+		// Send the data and CRC, this waits for the card to accept the block
+		if (! _SCSD_writeData_s (data, crc)) {
+			sent = false;
+			break;
+		}
+
+		data += BYTES_PER_READ;
+	}
+
+	// Stop the streaming, even after a failure so the card returns to the transfer state
+	_SCSD_sendCommand (STOP_TRANSMISSION, 0);
+	_SCSD_getResponse_R1b (responseBuffer);
+	_SCSD_sendClocks(0x10);
+
+	return _SCSD_waitForTransfer() && sent;
+}
+
 bool _SCSD_writeSectors (u32 sector, u32 numSectors, const void* buffer) {
 	u16 crc[4];	// One per data line
 	u8 responseBuffer[6];
 	u32 offset = sector * BYTES_PER_READ;
 	u8* data = (u8*) buffer;
-	int i;
+
+	if (numSectors > 1) {
+		return _SCSD_writeMultipleSectors (sector, numSectors, data);
+	}
 
 	while (numSectors--) {
 		// Calculate the CRC16
@@ -348,16 +476,9 @@ bool _SCSD_writeSectors (u32 sector, u32 numSectors, const void* buffer) {
 		data += BYTES_PER_READ;
 		
 		// Wait until card is finished programming
-		i = WRITE_TIMEOUT;
-		responseBuffer[3] = 0;
-		do {
-			_SCSD_sendCommand (SEND_STATUS, _SCSD_relativeCardAddress);
-			_SCSD_getResponse_R1 (responseBuffer);
-			i--;
-			if (i <= 0) {
-				return false;
-			}
-		} while (((responseBuffer[3] & 0x1f) != ((SD_STATE_TRAN << 1) | READY_FOR_DATA)));
+		if (!_SCSD_waitForTransfer()) {
+			return false;
+		}
 	}
 	
 	return true;
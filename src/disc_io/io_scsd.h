@@ -45,4 +45,10 @@
 // export interface
 extern const DISC_INTERFACE _io_scsd ;
 
+// quick hardware check used by discGetInterface before a full startup
+extern bool _SCSD_probe (void);
+
+// scatter/gather read, used by discReadSectorsV
+extern bool _SCSD_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments);
+
 #endif	// define IO_SCSD_H
@@ -35,6 +35,7 @@
 #define IO_SD_COMMON_H
 
 #include <disc_io.h>
+#include "gba_base.h"
 
 /* SD commands */
 #define GO_IDLE_STATE 0
@@ -54,6 +55,7 @@
 
 /* SD App commands */
 #define SET_BUS_WIDTH 6
+#define SET_WR_BLK_ERASE_COUNT 23
 #define SD_APP_OP_COND 41
 
 /* OCR (Operating Conditions Register) send value */
@@ -80,15 +82,15 @@
 
 /*
 Calculate the CRC7 of a command and return it preshifted with 
-an end bit added
+an end bit added. Runs from IWRAM.
 */
-extern u8 _SD_CRC7(u8* data, int size);
+extern IWRAM_CODE u8 _SD_CRC7(u8* data, int size);
 
 /*
 Calculate the CRC16 of a block of data, ready for transmission on
-four data lines at once
+four data lines at once. Runs from IWRAM.
 */
-extern void _SD_CRC16 (u8* buff, int buffLength, u8* crc16buff);
+extern IWRAM_CODE void _SD_CRC16 (u8* buff, int buffLength, u8* crc16buff);
 
 typedef bool (*_SD_FN_CMD_6BYTE_RESPONSE) (u8* responseBuffer, u8 command, u32 data);
 typedef bool (*_SD_FN_CMD_17BYTE_RESPONSE) (u8* responseBuffer, u8 command, u32 data);
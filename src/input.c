@@ -27,6 +27,8 @@
 
 //---------------------------------------------------------------------------------
 #include "gba_input.h"
+#include "gba_interrupt.h"
+#include "gba_timers.h"
 //---------------------------------------------------------------------------------
 typedef struct{
 	u16 Up,
@@ -43,6 +45,95 @@ static KeyInput Keys = { 0,0,0,0,0 };
 
 static u8 delay = 60, repeat = 30, count = 60;
 
+//---------------------------------------------------------------------------------
+// Keypad event queue, filled from the keypad irq and the vblank sample
+//---------------------------------------------------------------------------------
+#define KEYEVENT_QUEUE_SIZE	32	// must be a power of 2
+
+static KeyEvent eventQueue[KEYEVENT_QUEUE_SIZE];
+static volatile int eventHead = 0, eventTail = 0;
+static u16 eventKeys = 0;
+static int eventTimer = -1;
+
+//---------------------------------------------------------------------------------
+// Input recording and replay
+//---------------------------------------------------------------------------------
+static u8 *recordData = NULL;
+static int recordSize = 0, recordUsed = 0;
+static u16 recordKeys = 0, recordDelta = 0;
+static int recordRun = -1;
+
+static const u8 *replayData = NULL;
+static int replaySize = 0, replayPos = 0;
+static u16 replayKeys = 0;
+static int replayRun = 0;
+
+//---------------------------------------------------------------------------------
+static void keysResetState(void)
+//---------------------------------------------------------------------------------
+{
+	// start from a known state so the derived Down, Up & DownRepeat match too
+	Keys.Up = Keys.Down = Keys.Held = Keys.Last = Keys.DownRepeat = 0;
+	count = delay;
+}
+
+//---------------------------------------------------------------------------------
+static void keysRecordEntry(void)
+//---------------------------------------------------------------------------------
+{
+	u16 entry = recordDelta | (recordRun << 10);
+
+	if ( recordUsed + 2 > recordSize) {
+		// out of space, the recording ends here
+		recordData = NULL;
+		return;
+	}
+
+	// byte writes, the buffer may be in SRAM
+	recordData[recordUsed++] = entry & 0xff;
+	recordData[recordUsed++] = entry >> 8;
+}
+
+//---------------------------------------------------------------------------------
+static void keysRecordFrame(u16 keys)
+//---------------------------------------------------------------------------------
+{
+	if ( recordRun >= 0 && keys == recordKeys && recordRun < 63) {
+		recordRun++;
+		return;
+	}
+
+	if ( recordRun >= 0) keysRecordEntry();
+
+	recordDelta = keys ^ recordKeys;
+	recordKeys = keys;
+	recordRun = 0;
+}
+
+//---------------------------------------------------------------------------------
+static u16 keysReplayFrame(u16 keys)
+//---------------------------------------------------------------------------------
+{
+	if ( replayRun == 0) {
+		u16 entry;
+
+		if ( replayPos + 2 > replaySize) {
+			// end of the recording, hand back to the keypad
+			replayData = NULL;
+			return keys;
+		}
+
+		entry = replayData[replayPos] | (replayData[replayPos + 1] << 8);
+		replayPos += 2;
+
+		replayKeys ^= entry & 0x03ff;
+		replayRun = (entry >> 10) + 1;
+	}
+
+	replayRun--;
+	return replayKeys;
+}
+
 //---------------------------------------------------------------------------------
 void setRepeat( int SetDelay, int SetRepeat)
 //---------------------------------------------------------------------------------
@@ -55,9 +146,13 @@ void setRepeat( int SetDelay, int SetRepeat)
 void scanKeys(void)
 //---------------------------------------------------------------------------------
 {
-	Keys.Last = Keys.Held;
-	Keys.Held = (REG_KEYINPUT & 0x03ff) ^ 0x03ff; // upper 6 bits clear on hw not emulated
+	u16 keys = (REG_KEYINPUT & 0x03ff) ^ 0x03ff; // upper 6 bits clear on hw not emulated
+
+	if ( replayData) keys = keysReplayFrame(keys);
+	if ( recordData) keysRecordFrame(keys);
 
+	Keys.Last = Keys.Held;
+	Keys.Held = keys;
 
 	u16 pressed = Keys.Held & ( Keys.Last ^ 0x03ff);
 
@@ -125,3 +220,180 @@ u16 keysHeld(void)
 	return Keys.Held;
 }
 
+
+//---------------------------------------------------------------------------------
+void keysRecordStart(u8 *buffer, int size)
+//---------------------------------------------------------------------------------
+{
+	recordData = buffer;
+	recordSize = size;
+	recordUsed = 0;
+	recordKeys = 0;
+	recordRun = -1;
+
+	keysResetState();
+}
+
+//---------------------------------------------------------------------------------
+int keysRecordStop(void)
+//---------------------------------------------------------------------------------
+{
+	if ( recordData && recordRun >= 0) keysRecordEntry();
+
+	recordData = NULL;
+	recordRun = -1;
+
+	return recordUsed;
+}
+
+//---------------------------------------------------------------------------------
+bool keysRecording(void)
+//---------------------------------------------------------------------------------
+{
+	return recordData != NULL;
+}
+
+//---------------------------------------------------------------------------------
+void keysReplayStart(const u8 *data, int size)
+//---------------------------------------------------------------------------------
+{
+	replayData = data;
+	replaySize = size;
+	replayPos = 0;
+	replayKeys = 0;
+	replayRun = 0;
+
+	keysResetState();
+}
+
+//---------------------------------------------------------------------------------
+void keysReplayStop(void)
+//---------------------------------------------------------------------------------
+{
+	replayData = NULL;
+}
+
+//---------------------------------------------------------------------------------
+bool keysReplaying(void)
+//---------------------------------------------------------------------------------
+{
+	return replayData != NULL;
+}
+
+//---------------------------------------------------------------------------------
+static u32 keysEventTime(void)
+//---------------------------------------------------------------------------------
+{
+	// the upper timer counts overflows of the lower one
+	return timerReadCascaded(eventTimer);
+}
+
+//---------------------------------------------------------------------------------
+static void keysEventPush(u16 keys, u16 type, u32 time)
+//---------------------------------------------------------------------------------
+{
+	int next = (eventHead + 1) & (KEYEVENT_QUEUE_SIZE - 1);
+
+	// queue is full, drop the event
+	if ( next == eventTail) return;
+
+	eventQueue[eventHead].time = time;
+	eventQueue[eventHead].keys = keys;
+	eventQueue[eventHead].type = type;
+
+	eventHead = next;
+}
+
+//---------------------------------------------------------------------------------
+void keysEventSample(void)
+//---------------------------------------------------------------------------------
+{
+	u16 ime, keys, changed;
+
+	if ( eventTimer < 0) return;
+
+	// the keypad irq may interrupt a sample taken from the vblank handler
+	ime = REG_IME;
+	REG_IME = 0;
+
+	keys = (REG_KEYINPUT & 0x03ff) ^ 0x03ff;
+	changed = keys ^ eventKeys;
+
+	if ( changed) {
+		u32 time = keysEventTime();
+
+		if ( changed & keys) keysEventPush( changed & keys, KEYEVENT_PRESS, time);
+		if ( changed & eventKeys) keysEventPush( changed & eventKeys, KEYEVENT_RELEASE, time);
+
+		eventKeys = keys;
+	}
+
+	// only keys which are up can raise the next irq, held keys would retrigger it
+	REG_KEYCNT = KEYIRQ_ENABLE | KEYIRQ_OR | (keys ^ 0x03ff);
+
+	REG_IME = ime;
+}
+
+//---------------------------------------------------------------------------------
+bool keysEventInit(int timer)
+//---------------------------------------------------------------------------------
+{
+	if ( timer < 0 || timer > 2) return false;
+
+	eventTimer = timer;
+
+	// two cascaded timers give a free running 32 bit count of 64 cycle ticks
+	timerStartCascaded(timer, TIMER_FREQ_64);
+
+	eventHead = eventTail = 0;
+	eventKeys = (REG_KEYINPUT & 0x03ff) ^ 0x03ff;
+
+	irqSet(IRQ_KEYPAD, keysEventSample);
+	REG_KEYCNT = KEYIRQ_ENABLE | KEYIRQ_OR | (eventKeys ^ 0x03ff);
+	irqEnable(IRQ_KEYPAD);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+void keysEventStop(void)
+//---------------------------------------------------------------------------------
+{
+	if ( eventTimer < 0) return;
+
+	irqDisable(IRQ_KEYPAD);
+	REG_KEYCNT = 0;
+
+	REG_TMCNT_H(eventTimer) = 0;
+	REG_TMCNT_H(eventTimer + 1) = 0;
+
+	eventTimer = -1;
+}
+
+//---------------------------------------------------------------------------------
+bool keysEventNext(KeyEvent *event)
+//---------------------------------------------------------------------------------
+{
+	int tail = eventTail;
+
+	if ( tail == eventHead) return false;
+
+	*event = eventQueue[tail];
+	eventTail = (tail + 1) & (KEYEVENT_QUEUE_SIZE - 1);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+int keysEventPending(void)
+//---------------------------------------------------------------------------------
+{
+	return (eventHead - eventTail) & (KEYEVENT_QUEUE_SIZE - 1);
+}
+
+//---------------------------------------------------------------------------------
+void keysEventFlush(void)
+//---------------------------------------------------------------------------------
+{
+	eventTail = eventHead;
+}
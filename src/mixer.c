@@ -0,0 +1,267 @@
+/*
+
+	libgba software sound mixer
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	Each side has two buffers of one frame's worth of samples, back to
+	back. The DMA runs on from the first into the second by itself and
+	is pointed back at the first once the second has played, while the
+	buffer which has just played is mixed again.
+
+---------------------------------------------------------------------------------*/
+#include "gba_mixer.h"
+#include "gba_sound.h"
+#include "gba_dma.h"
+#include "gba_timers.h"
+#include "gba_interrupt.h"
+
+//---------------------------------------------------------------------------------
+#define MIXER_CYCLES_PER_FRAME	280896
+
+#define MIXER_DMA_MODE	(DMA_DST_FIXED | DMA_SRC_INC | DMA_REPEAT | DMA32 | DMA_SPECIAL | DMA_ENABLE)
+
+static s8 mixerBufferL[MIXER_MAX_SAMPLES * 2] ALIGN(4) EWRAM_BSS;
+static s8 mixerBufferR[MIXER_MAX_SAMPLES * 2] ALIGN(4) EWRAM_BSS;
+static s8 mixerStreamBuffer[MIXER_MAX_SAMPLES] ALIGN(4) EWRAM_BSS;
+
+static MixerVoice mixerVoices[MIXER_MAX_VOICES];
+static int mixerNumVoices = 0;
+static int mixerSamples = 0;		// samples per frame, 0 when stopped
+static u32 mixerPeriod = 0;			// cpu cycles per sample
+static int mixerPlaying = 0;		// buffer the DMA is in
+static MIXER_REFILL mixerRefill = MIXER_REFILL_VBLANK;
+
+static MixerStreamFn mixerStream = NULL;
+static void *mixerStreamContext = NULL;
+static int mixerStreamVoice = 0;
+
+//---------------------------------------------------------------------------------
+bool mixerInit(MIXER_RATE rate, int voices, MIXER_REFILL refill)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	if ( voices < 1 || voices > MIXER_MAX_VOICES) return false;
+	if ( rate <= 0 || rate > MIXER_MAX_SAMPLES || (MIXER_CYCLES_PER_FRAME % rate)) return false;
+
+	mixerStop();
+
+	for ( i = 0; i < MIXER_MAX_VOICES; i++) {
+		mixerVoices[i].data = NULL;
+		mixerVoices[i].leftVolume = mixerVoices[i].rightVolume = MIXER_VOLUME_MAX / 2;
+	}
+	mixerStream = NULL;
+	for ( i = 0; i < MIXER_MAX_SAMPLES * 2; i++) mixerBufferL[i] = mixerBufferR[i] = 0;
+
+	mixerNumVoices = voices;
+	mixerSamples = rate;
+	mixerPeriod = MIXER_CYCLES_PER_FRAME / rate;
+	mixerPlaying = 0;
+	mixerRefill = refill;
+
+	// FIFO A on the left, B on the right, both clocked by timer 0
+	REG_SOUNDCNT_X = SNDSTAT_ENABLE;
+	REG_SOUNDCNT_H = (REG_SOUNDCNT_H & 3) | SNDA_VOL_100 | SNDA_L_ENABLE | SNDA_RESET_FIFO |
+					 SNDB_VOL_100 | SNDB_R_ENABLE | SNDB_RESET_FIFO;
+
+	REG_DMA1SAD = (u32)mixerBufferL;
+	REG_DMA1DAD = (u32)&REG_FIFO_A;
+	REG_DMA1CNT = MIXER_DMA_MODE;
+
+	REG_DMA2SAD = (u32)mixerBufferR;
+	REG_DMA2DAD = (u32)&REG_FIFO_B;
+	REG_DMA2CNT = MIXER_DMA_MODE;
+
+	REG_TM0CNT_L = 65536 - mixerPeriod;
+
+	if ( refill == MIXER_REFILL_TIMER) {
+		// timer 1 overflows each time a buffer has played
+		REG_TM1CNT_L = 65536 - mixerSamples;
+		REG_TM1CNT_H = TIMER_COUNT | TIMER_IRQ | TIMER_START;
+		irqSet(IRQ_TIMER1, mixerUpdate);
+		irqEnable(IRQ_TIMER1);
+	}
+
+	REG_TM0CNT_H = TIMER_START;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+void mixerStop(void)
+//---------------------------------------------------------------------------------
+{
+	if ( mixerSamples == 0) return;
+
+	if ( mixerRefill == MIXER_REFILL_TIMER) {
+		irqDisable(IRQ_TIMER1);
+		REG_TM1CNT_H = 0;
+	}
+
+	REG_TM0CNT_H = 0;
+	REG_DMA1CNT = 0;
+	REG_DMA2CNT = 0;
+
+	REG_SOUNDCNT_H &= 3;
+
+	mixerSamples = 0;
+}
+
+//---------------------------------------------------------------------------------
+void mixerUpdate(void)
+//---------------------------------------------------------------------------------
+{
+	s8 *left, *right;
+	MixerVoice *v;
+	int count;
+
+	if ( mixerSamples == 0) return;
+
+	if ( mixerPlaying) {
+		// the second buffer has played, start the first one again
+		REG_DMA1CNT = 0;
+		REG_DMA1SAD = (u32)mixerBufferL;
+		REG_DMA1CNT = MIXER_DMA_MODE;
+
+		REG_DMA2CNT = 0;
+		REG_DMA2SAD = (u32)mixerBufferR;
+		REG_DMA2CNT = MIXER_DMA_MODE;
+
+		mixerPlaying = 0;
+		left = mixerBufferL + mixerSamples;
+		right = mixerBufferR + mixerSamples;
+	} else {
+		mixerPlaying = 1;
+		left = mixerBufferL;
+		right = mixerBufferR;
+	}
+
+	if ( mixerStream) {
+		count = mixerStream(mixerStreamContext, mixerStreamBuffer, mixerSamples);
+
+		v = &mixerVoices[mixerStreamVoice];
+		v->position = 0;
+		v->step = 1 << MIXER_FRACTION_BITS;
+		v->end = count << MIXER_FRACTION_BITS;
+		v->loopLength = 0;
+		v->data = count ? mixerStreamBuffer : NULL;
+	}
+
+	mixerMixVoices(mixerVoices, mixerNumVoices, left, right, mixerSamples);
+}
+
+//---------------------------------------------------------------------------------
+// the voices are changed with interrupts off, as the mixer can run in one
+//---------------------------------------------------------------------------------
+void mixerPlay(int voice, const s8 *data, u32 length, u32 loopLength, u32 freq)
+//---------------------------------------------------------------------------------
+{
+	MixerVoice *v;
+	u16 ime;
+
+	if ( voice < 0 || voice >= MIXER_MAX_VOICES || length == 0 || length > MIXER_MAX_LENGTH) return;
+	if ( loopLength > length) loopLength = length;
+
+	v = &mixerVoices[voice];
+
+	ime = REG_IME;
+	REG_IME = 0;
+
+	v->position = 0;
+	v->step = (freq * mixerPeriod) >> (24 - MIXER_FRACTION_BITS);
+	v->end = length << MIXER_FRACTION_BITS;
+	v->loopLength = loopLength << MIXER_FRACTION_BITS;
+	v->data = data;
+
+	REG_IME = ime;
+}
+
+//---------------------------------------------------------------------------------
+void mixerStopVoice(int voice)
+//---------------------------------------------------------------------------------
+{
+	if ( voice < 0 || voice >= MIXER_MAX_VOICES) return;
+
+	mixerVoices[voice].data = NULL;
+}
+
+//---------------------------------------------------------------------------------
+void mixerSetVolume(int voice, int volume, int pan)
+//---------------------------------------------------------------------------------
+{
+	u16 ime;
+
+	if ( voice < 0 || voice >= MIXER_MAX_VOICES) return;
+
+	if ( volume < 0) volume = 0; else if ( volume > MIXER_VOLUME_MAX) volume = MIXER_VOLUME_MAX;
+	if ( pan < MIXER_PAN_LEFT) pan = MIXER_PAN_LEFT; else if ( pan > MIXER_PAN_RIGHT) pan = MIXER_PAN_RIGHT;
+
+	ime = REG_IME;
+	REG_IME = 0;
+
+	mixerVoices[voice].leftVolume = (volume * (MIXER_PAN_RIGHT - pan)) >> 8;
+	mixerVoices[voice].rightVolume = (volume * pan) >> 8;
+
+	REG_IME = ime;
+}
+
+//---------------------------------------------------------------------------------
+void mixerSetFreq(int voice, u32 freq)
+//---------------------------------------------------------------------------------
+{
+	if ( voice < 0 || voice >= MIXER_MAX_VOICES) return;
+
+	mixerVoices[voice].step = (freq * mixerPeriod) >> (24 - MIXER_FRACTION_BITS);
+}
+
+//---------------------------------------------------------------------------------
+bool mixerVoiceActive(int voice)
+//---------------------------------------------------------------------------------
+{
+	if ( voice < 0 || voice >= MIXER_MAX_VOICES) return false;
+
+	return mixerVoices[voice].data != NULL;
+}
+
+//---------------------------------------------------------------------------------
+void mixerSetStream(int voice, MixerStreamFn fn, void *context)
+//---------------------------------------------------------------------------------
+{
+	u16 ime;
+
+	if ( voice < 0 || voice >= MIXER_MAX_VOICES) return;
+
+	ime = REG_IME;
+	REG_IME = 0;
+
+	if ( fn == NULL && mixerStream) mixerVoices[mixerStreamVoice].data = NULL;
+
+	mixerStream = fn;
+	mixerStreamContext = context;
+	mixerStreamVoice = voice;
+
+	REG_IME = ime;
+}
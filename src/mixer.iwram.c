@@ -0,0 +1,117 @@
+/*
+
+	libgba software sound mixer, mixing kernel
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	Built as ARM code, see the .iwram.o rule in the Makefile, and placed in
+	IWRAM. Nothing here touches the hardware so it can be built on a host.
+
+	The output is mixed a chunk at a time into 32 bit accumulators, left
+	and right interleaved so the voice loop reads and writes both with one
+	ldm/stm pair. Each voice works out how many samples it has left before
+	its end, so the inner loop runs without any checks.
+
+---------------------------------------------------------------------------------*/
+#include "gba_mixer.h"
+
+//---------------------------------------------------------------------------------
+static s32 mixerChunk[MIXER_CHUNK*2];
+
+//---------------------------------------------------------------------------------
+IWRAM_CODE static void mixVoice(MixerVoice *voice, s32 *mix, int samples)
+//---------------------------------------------------------------------------------
+{
+	const s8 *data = voice->data;
+	u32 pos = voice->position, step = voice->step, end = voice->end;
+	s32 lv = voice->leftVolume, rv = voice->rightVolume;
+	s32 s;
+	int run;
+
+	while ( samples) {
+		// output samples before the voice reaches its end
+		if ( step == 0) {
+			run = samples;
+		} else {
+			run = (end - pos + step - 1) / step;
+			if ( run > samples) run = samples;
+		}
+
+		samples -= run;
+
+		for ( ; run; run--) {
+			s = data[pos >> MIXER_FRACTION_BITS];
+			mix[0] += s * lv;
+			mix[1] += s * rv;
+			mix += 2;
+			pos += step;
+		}
+
+		if ( pos >= end) {
+			if ( voice->loopLength == 0) {
+				voice->data = NULL;
+				return;
+			}
+			while ( pos >= end) pos -= voice->loopLength;
+		}
+	}
+
+	voice->position = pos;
+}
+
+//---------------------------------------------------------------------------------
+IWRAM_CODE void mixerMixVoices(MixerVoice *voices, int numVoices, s8 *left, s8 *right, int samples)
+//---------------------------------------------------------------------------------
+{
+	s32 *mix;
+	s32 l, r;
+	int count, i;
+
+	while ( samples) {
+		count = ( samples > MIXER_CHUNK) ? MIXER_CHUNK : samples;
+
+		for ( i = 0; i < count * 2; i++) mixerChunk[i] = 0;
+
+		for ( i = 0; i < numVoices; i++) {
+			if ( voices[i].data) mixVoice(&voices[i], mixerChunk, count);
+		}
+
+		// full volume on one side maps a sample straight to the output
+		mix = mixerChunk;
+		for ( i = 0; i < count; i++) {
+			l = mix[0] >> 8;
+			r = mix[1] >> 8;
+			mix += 2;
+
+			if ( l > 127) l = 127; else if ( l < -128) l = -128;
+			if ( r > 127) r = 127; else if ( r < -128) r = -128;
+
+			*left++ = l;
+			*right++ = r;
+		}
+
+		samples -= count;
+	}
+}
@@ -0,0 +1,177 @@
+/*
+
+	libgba table based pitch to frequency conversion
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	freq * 2^((pitch - 180 * 256) / 3072), where pitch is the MIDI key in
+	8.8 fixed point, the power function GBATEK gives for the BIOS
+	MidiKey2Freq, truncated.
+
+	180 * 256 is exactly 15 octaves, so the octave is pitch / 3072 less 15
+	and only the fraction of an octave needs a table. It is split into a
+	coarse step, 16 to a semitone, and a fine step. Both tables hold
+	powers of two in 1.63 fixed point, so the multiplier is within a few
+	parts in 2^62 and the product with a 32 bit frequency is off by less
+	than 2^-29, which only matters when the exact result is that close to
+	a whole number.
+
+---------------------------------------------------------------------------------*/
+#include "gba_sound.h"
+
+#define PITCH_MAX		PITCH(178, 255)
+#define PITCH_STEPS		192		// coarse steps to an octave
+
+//---------------------------------------------------------------------------------
+// 2^(n / 192)
+//---------------------------------------------------------------------------------
+static const unsigned long long pitchCoarseTable[PITCH_STEPS] = {
+	0x8000000000000000ULL, 0x807682CB0AE6D2A1ULL, 0x80ED734FC1CF6F10ULL,
+	0x8164D1F3BC030773ULL, 0x81DC9F1CEEDA143AULL, 0x8254DB31AE136A4BULL,
+	0x82CD8698AC2BA1D7ULL, 0x8346A1B8FAB4CE1DULL, 0x83C02CFA0AAE865BULL,
+	0x843A28C3ACDE4046ULL, 0x84B4957E1227FC56ULL, 0x852F7391CBE7441DULL,
+	0x85AAC367CC487B15ULL, 0x8626856966A2820DULL, 0x86A2BA004FD0ADA7ULL,
+	0x871F61969E8D1010ULL, 0x879C7C96CBCB165EULL, 0x881A0B6BB31279CBULL,
+	0x88980E8092DA8527ULL, 0x891686410CE5AECAULL, 0x89957319269D8757ULL,
+	0x8A14D575496EFD9AULL, 0x8A94ADC24326F7D8ULL, 0x8B14FC6D464F42D4ULL,
+	0x8B95C1E3EA8BD6E7ULL, 0x8C16FE942CF8736DULL, 0x8C98B2EC708690DEULL,
+	0x8D1ADF5B7E5BA9E6ULL, 0x8D9D8450862FDBC4ULL, 0x8E20A23B1EACDE49ULL,
+	0x8EA4398B45CD53C0ULL, 0x8F284AB1613C711EULL, 0x8FACD61E3EB5FEB6ULL,
+	0x9031DC431466B1DCULL, 0x90B75D91814CDFB7ULL, 0x913D5A7B8D998999ULL,
+	0x91C3D373AB11C336ULL, 0x924AC8ECB5707307ULL, 0x92D23B59F2C86D2DULL,
+	0x935A2B2F13E6E92CULL, 0x93E298E034B652C9ULL, 0x946B84E1DCA17671ULL,
+	0x94F4EFA8FEF70961ULL, 0x957ED9AAFB4D8E0AULL, 0x9609435D9DE794DFULL,
+	0x96942D3720185A00ULL, 0x971F97AE28A8C00BULL, 0x97AB8339CC3CA868ULL,
+	0x9837F0518DB8A96FULL, 0x98C4DF6D5EA822B7ULL, 0x995251059FA3AFE7ULL,
+	0x99E0459320B7FA65ULL, 0x9A6EBD8F21CCEA33ULL, 0x9AFDB973530D365AULL,
+	0x9B8D39B9D54E5539ULL, 0x9C1D3EDD3A78CD09ULL, 0x9CADC95885F0E4FEULL,
+	0x9D3ED9A72CFFB751ULL, 0x9DD07045173CA494ULL, 0x9E628DAE9EF728A8ULL,
+	0x9EF5326091A111AEULL, 0x9F885ED830391951ULL, 0xA01C13932FB5E0C2ULL,
+	0xA0B0510FB9714FC2ULL, 0xA14517CC6B945711ULL, 0xA1DA6848598316AAULL,
+	0xA27043030C496819ULL, 0xA306A87C8307CD56ULL, 0xA39D99353360C477ULL,
+	0xA43515AE09E6809EULL, 0xA4CD1E686A890879ULL, 0xA565B3E63104BABBULL,
+	0xA5FED6A9B15138EAULL, 0xA6988735B810B8D6ULL, 0xA732C60D8AFFBD2AULL,
+	0xA7CD93B4E965356AULL, 0xA868F0B00C8305BCULL, 0xA904DD83A806F6ECULL,
+	0xA9A15AB4EA7C0EF8ULL, 0xAA3E68C97DBC528FULL, 0xAADC08478762EFE5ULL,
+	0xAB7A39B5A93ED337ULL, 0xAC18FD9B01C5A56EULL, 0xACB8547F2C87352EULL,
+	0xAD583EEA42A14AC6ULL, 0xADF8BD64DB33E763ULL, 0xAE99D0780BD5EFD8ULL,
+	0xAF3B78AD690A4375ULL, 0xAFDDB68F06B53F42ULL, 0xB0808AA77892AE0AULL,
+	0xB123F581D2AC2590ULL, 0xB1C7F7A9A9CFD166ULL, 0xB26C91AB1407ABBCULL,
+	0xB311C412A9112489ULL, 0xB3B78F6D82D5378DULL, 0xB45DF4493DE0F16FULL,
+	0xB504F333F9DE6484ULL, 0xB5AC8CBC5A0E0D82ULL, 0xB654C17185C0A8A3ULL,
+	0xB6FD91E328D17791ULL, 0xB7A6FEA17420F889ULL, 0xB851083D1E100F19ULL,
+	0xB8FBAF4762FB9EE9ULL, 0xB9A6F45205B898F4ULL, 0xBA52D7EF50107B9BULL,
+	0xBAFF5AB2133E45FBULL, 0xBBAC7D2DA86BDEFDULL, 0xBC5A3FF5F12FF071ULL,
+	0xBD08A39F580C36BFULL, 0xBDB7A8BED0EC4582ULL, 0xBE674FE9D9A4C183ULL,
+	0xBF1799B67A731083ULL, 0xBFC886BB467D7F37ULL, 0xC07A178F5C53DDF0ULL,
+	0xC12C4CCA66709456ULL, 0xC1DF27049BBA2CA2ULL, 0xC292A6D6C00556C7ULL,
+	0xC346CCDA24976407ULL, 0xC3FB99A8A8A93B46ULL, 0xC4B10DDCB9EAC6A9ULL,
+	0xC5672A115506DADDULL, 0xC61DEEE206279885ULL, 0xC6D55CEAE97B4831ULL,
+	0xC78D74C8ABB9B15DULL, 0xC84637188AA9ECE2ULL, 0xC8FFA47855A8B351ULL,
+	0xC9B9BD866E2F27A3ULL, 0xCA7482E1C85A1EB7ULL, 0xCB2FF529EB71E416ULL,
+	0xCBEC14FEF2727C5DULL, 0xCCA8E3018C9465E2ULL, 0xCD665FD2FDD5D7E6ULL,
+	0xCE248C151F8480E4ULL, 0xCEE3686A60C7C462ULL, 0xCFA2F575C72B78C5ULL,
+	0xD06333DAEF2B2595ULL, 0xD124243E0CBDC2B2ULL, 0xD1E5C743EBE1F8E7ULL,
+	0xD2A81D91F12AE45AULL, 0xD36B27CE1A4D5952ULL, 0xD42EE69EFEADABC2ULL,
+	0xD4F35AABCFEDFA1FULL, 0xD5B8849C5A7CFBF3ULL, 0xD67E6519062554A4ULL,
+	0xD744FCCAD69D6AF4ULL, 0xD80C4C5B6C17C5ADULL, 0xD8D4547503D3EDF1ULL,
+	0xD99D15C278AFD7B6ULL, 0xDA6690EF43B9D0DDULL, 0xDB30C6A77CC2F769ULL,
+	0xDBFBB797DAF23755ULL, 0xDCC7646DB557D077ULL, 0xDD93CDD703816504ULL,
+	0xDE60F4825E0E9124ULL, 0xDF2ED91EFF460C1AULL, 0xDFFD7C5CC3AB537FULL,
+	0xE0CCDEEC2A94E111ULL, 0xE19D017E56C2EB91ULL, 0xE26DE4C50EF6B33CULL,
+	0xE33F8972BE8A5A51ULL, 0xE411F03A76094A35ULL, 0xE4E519CFEBC925ABULL,
+	0xE5B906E77C8348A8ULL, 0xE68DB8362BEED64BULL, 0xE7632E71A55B556FULL,
+	0xE8396A503C4BDC68ULL, 0xE9106C88ED12CC70ULL, 0xE9E835D35D6E1D35ULL,
+	0xEAC0C6E7DD24392FULL, 0xEB9A207F66A16B20ULL, 0xEC7443539F95DD65ULL,
+	0xED4F301ED9942B84ULL, 0xEE2AE79C12B08691ULL, 0xEF076A86F6206CE9ULL,
+	0xEFE4B99BDCDAF5CBULL, 0xF0C2D597CE39B163ULL, 0xF1A1BF38809A1DBDULL,
+	0xF281773C59FFB13AULL, 0xF361FE6270B67B10ULL, 0xF443556A8BF65A55ULL,
+	0xF5257D152486CC2CULL, 0xF60876236563519AULL, 0xF6EC41572C606D8FULL,
+	0xF7D0DF730AD13BB9ULL, 0xF8B6513A462DA09DULL, 0xF99C9770D8B91395ULL,
+	0xFA83B2DB722A033AULL, 0xFB6BA43F7851D4C9ULL, 0xFC546C6307C57F0EULL,
+	0xFD3E0C0CF486C175ULL, 0xFE288404CAADF7BBULL, 0xFF13D512CF148AE5ULL
+};
+
+//---------------------------------------------------------------------------------
+// 2^(n / 3072)
+//---------------------------------------------------------------------------------
+static const unsigned long long pitchFineTable[3072 / PITCH_STEPS] = {
+	0x8000000000000000ULL, 0x800764F7AAEB8870ULL, 0x800ECA5CB0929CEAULL,
+	0x8016302F17467628ULL, 0x801D966EE558AA53ULL, 0x8024FD1C211B2D06ULL,
+	0x802C6436D0E04F51ULL, 0x8033CBBEFAFABFC4ULL, 0x803B33B4A5BD8A70ULL,
+	0x80429C17D77C18EDULL, 0x804A04E8968A3263ULL, 0x80516E26E93BFB89ULL,
+	0x8058D7D2D5E5F6B1ULL, 0x806041EC62DD03C8ULL, 0x8067AC739676605FULL,
+	0x806F17687707A7B0ULL
+};
+
+//---------------------------------------------------------------------------------
+// the high 64 bits of a 64 by 64 bit multiply, from 32 bit halves
+//---------------------------------------------------------------------------------
+static inline unsigned long long pitchMulHigh(unsigned long long a, unsigned long long b)
+{
+	unsigned long long aLow = (u32)a, aHigh = a >> 32, bLow = (u32)b, bHigh = b >> 32;
+	unsigned long long low = aLow * bLow, middle1 = aHigh * bLow, middle2 = aLow * bHigh;
+	unsigned long long middle = (low >> 32) + (u32)middle1 + (u32)middle2;
+
+	return aHigh * bHigh + (middle1 >> 32) + (middle2 >> 32) + (middle >> 32);
+}
+
+//---------------------------------------------------------------------------------
+u32 pitchToFreq(u32 freq, u32 pitch)
+//---------------------------------------------------------------------------------
+{
+	u32 octave, rest;
+	unsigned long long mult, t;
+
+	if ( pitch > PITCH_MAX) pitch = PITCH_MAX;
+
+	// pitch / 3072 without a division, exact for all 16 bit pitches
+	octave = ((pitch >> 10) * 43691) >> 17;
+	rest = pitch - octave * 3072;
+
+	// 2^(rest / 3072) in 2.62 fixed point
+	mult = pitchMulHigh(pitchCoarseTable[rest >> 4], pitchFineTable[rest & 15]);
+
+	// freq * mult is 96 bits, of which the low 32 are always shifted out
+	t = (unsigned long long)freq * (mult >> 32) + (((unsigned long long)freq * (u32)mult) >> 32);
+
+	return t >> (62 + 15 - octave - 32);
+}
+
+//---------------------------------------------------------------------------------
+u32 pitchMidiKeyToFreq(WaveData *wa, u8 mk, u8 fp)
+//---------------------------------------------------------------------------------
+{
+	return pitchToFreq(wa->freq, PITCH(mk, fp));
+}
+
+//---------------------------------------------------------------------------------
+void pitchToFreqBatch(const u32 *freq, const u16 *pitch, u32 *out, int count)
+//---------------------------------------------------------------------------------
+{
+	while ( count--) {
+		*out++ = pitchToFreq(*freq++, *pitch++);
+	}
+}
@@ -0,0 +1,222 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of ADPCM streaming: disc streams have to play the same as
+	streams in memory, without adpcmRead ever reading the disc
+
+	Also prints the host time adpcmDecode takes for a frame of samples.
+	It is no measure of the GBA, but shows when a change slows it down.
+
+---------------------------------------------------------------------------------*/
+#include <gba_adpcm.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "adpcm_encode.h"
+#include "gbahost.h"
+
+#define SAMPLES		(3 * ADPCM_BLOCK_SAMPLES + 500)
+#define BLOCKS		4
+#define FRAME		304			// samples per frame at 18157Hz
+#define PASSES		3
+#define TIMED		2000		// frames decoded for the timing
+
+static s16 pcm[SAMPLES];
+static u8 encoded[BLOCKS * ADPCM_BLOCK_SIZE];
+static s8 expected[PASSES * SAMPLES], output[PASSES * SAMPLES + FRAME];
+
+// the disc, a stand-in which knows whether the mixer interrupt is running
+static bool inInterrupt = false;
+static bool failReads = false;
+static int reads = 0;
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+static bool readSectors (sec_t sector, sec_t numSectors, void* buffer)
+//---------------------------------------------------------------------------------
+{
+	CHECK (!inInterrupt);
+	reads++;
+
+	if (failReads || sector + numSectors > BLOCKS) return false;
+
+	memcpy (buffer, encoded + sector * ADPCM_BLOCK_SIZE, numSectors * ADPCM_BLOCK_SIZE);
+	return true;
+}
+
+static const DISC_INTERFACE disc = { 0, 0, NULL, NULL, readSectors, NULL, NULL, NULL };
+
+//---------------------------------------------------------------------------------
+// one frame as the mixer reads it, from its interrupt
+//---------------------------------------------------------------------------------
+static int frame (AdpcmStream* stream, s8* buffer)
+//---------------------------------------------------------------------------------
+{
+	int count;
+
+	inInterrupt = true;
+	count = adpcmRead (stream, buffer, FRAME);
+	inInterrupt = false;
+
+	return count;
+}
+
+//---------------------------------------------------------------------------------
+// plays a disc stream with a prefetch in the main loop after every frame,
+// returns the samples played
+//---------------------------------------------------------------------------------
+static int play (AdpcmStream* stream, int samples)
+//---------------------------------------------------------------------------------
+{
+	int done = 0, count;
+
+	while (done < samples) {
+		count = frame (stream, output + done);
+		done += count;
+		if (count < FRAME) break;
+
+		CHECK (adpcmPrefetch (stream));
+	}
+
+	return done;
+}
+
+//---------------------------------------------------------------------------------
+static long long nanoseconds (void)
+//---------------------------------------------------------------------------------
+{
+	struct timespec t;
+
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+//---------------------------------------------------------------------------------
+// decodes the blocks a frame at a time, as adpcmRead does, and prints the
+// time each frame took
+//---------------------------------------------------------------------------------
+static void timeDecode (void)
+//---------------------------------------------------------------------------------
+{
+	AdpcmState state;
+	const u8* block = NULL;
+	int frames, offset = ADPCM_BLOCK_SAMPLES, count, done;
+	long long start, ns, totalNs = 0, mostNs = 0;
+
+	for (frames = 0; frames < TIMED; frames++) {
+		start = nanoseconds ();
+		for (done = 0; done < FRAME; done += count) {
+			if (offset == ADPCM_BLOCK_SAMPLES) {
+				block = (block == NULL || block == encoded + sizeof(encoded) - ADPCM_BLOCK_SIZE) ? encoded : block + ADPCM_BLOCK_SIZE;
+				state.predictor = (s16)(block[0] | (block[1] << 8));
+				state.index = block[2];
+				offset = 0;
+			}
+			count = FRAME - done;
+			if (count > ADPCM_BLOCK_SAMPLES - offset) count = ADPCM_BLOCK_SAMPLES - offset;
+
+			adpcmDecode (&state, block + ADPCM_HEADER_SIZE, offset, output + done, count);
+			offset += count;
+		}
+		ns = nanoseconds () - start;
+
+		// the first frame is the start of the stream
+		if (frames == 0) CHECK (memcmp (output, expected, FRAME) == 0);
+
+		totalNs += ns;
+		if (ns > mostNs) mostNs = ns;
+	}
+
+	printf ("adpcmDecode per frame of %d samples: %lld ns on average, %lld at most\n", FRAME, totalNs / TIMED, mostNs);
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	static AdpcmStream stream;
+	int i, done, count, error, mostError = 0;
+
+	// REG_IME
+	if (!gbaHostMap ()) {
+		printf ("can't set up the GBA memory\n");
+		return 1;
+	}
+
+	// a triangle wave, from 0 as the encoder starts there
+	for (i = 0; i < SAMPLES; i++) {
+		error = (i * 250 + 10000) % 40000;
+		pcm[i] = ((error < 20000) ? error : 40000 - error) - 10000;
+	}
+	CHECK (adpcmEncodedSize (SAMPLES) == sizeof(encoded));
+	CHECK (adpcmEncode (pcm, SAMPLES, encoded) == sizeof(encoded));
+
+	// the decoder tracks the input closely
+	adpcmOpen (&stream, encoded, SAMPLES, true);
+	CHECK (adpcmRead (&stream, expected, PASSES * SAMPLES) == PASSES * SAMPLES);
+	for (i = 0; i < SAMPLES; i++) {
+		error = expected[i] - (pcm[i] >> 8);
+		if (error < 0) error = -error;
+		if (error > mostError) mostError = error;
+	}
+	CHECK (mostError <= 4);
+
+	// every pass decodes the same
+	CHECK (memcmp (expected, expected + SAMPLES, SAMPLES) == 0);
+
+	// once through, the same as from memory
+	CHECK (adpcmOpenDisc (&stream, &disc, 0, SAMPLES, false));
+	CHECK (reads == 2);
+	CHECK (play (&stream, PASSES * SAMPLES) == SAMPLES);
+	CHECK (memcmp (output, expected, SAMPLES) == 0);
+	CHECK (reads == BLOCKS);
+
+	// looped
+	reads = 0;
+	CHECK (adpcmOpenDisc (&stream, &disc, 0, SAMPLES, true));
+	CHECK (play (&stream, PASSES * SAMPLES) >= PASSES * SAMPLES);
+	CHECK (memcmp (output, expected, PASSES * SAMPLES) == 0);
+	CHECK (reads >= PASSES * BLOCKS);
+
+	// without prefetches the stream stops short at the end of the second
+	// block, then carries on from there once the block is read
+	CHECK (adpcmOpenDisc (&stream, &disc, 0, SAMPLES, false));
+	for (done = 0; (count = frame (&stream, output + done)) == FRAME; done += count);
+	done += count;
+	CHECK (done == 2 * ADPCM_BLOCK_SAMPLES);
+	CHECK (frame (&stream, output + done) == 0);
+
+	failReads = true;
+	CHECK (!adpcmPrefetch (&stream));
+	CHECK (frame (&stream, output + done) == 0);
+	failReads = false;
+
+	CHECK (adpcmPrefetch (&stream));
+	done += frame (&stream, output + done);
+	CHECK (done == 2 * ADPCM_BLOCK_SAMPLES + FRAME);
+	CHECK (memcmp (output, expected, done) == 0);
+
+	// a stream of one block loops without reading again
+	reads = 0;
+	CHECK (adpcmOpenDisc (&stream, &disc, 0, 100, true));
+	CHECK (frame (&stream, output) == FRAME);
+	CHECK (adpcmPrefetch (&stream));
+	CHECK (frame (&stream, output + FRAME) == FRAME);
+	CHECK (reads == 1);
+	for (i = 0; i < 2 * FRAME; i++) {
+		CHECK (output[i] == expected[i % 100]);
+	}
+
+	// a disc which can't be read has nothing to play
+	failReads = true;
+	CHECK (!adpcmOpenDisc (&stream, &disc, 0, SAMPLES, true));
+	CHECK (frame (&stream, output) == 0);
+	failReads = false;
+
+	timeDecode ();
+
+	return failures != 0;
+}
@@ -0,0 +1,364 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the BoyScout player against the PSG model of tools/
+
+	boyscout.bin is a small generated song with patterns on all four
+	channels. The checksums are those of the player as first imported,
+	so any change to what the player writes to the sound registers, or
+	when, shows up here.
+
+---------------------------------------------------------------------------------*/
+#include <BoyScout.h>
+#include <gba_interrupt.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gbahost.h"
+#include "psg.h"
+
+#define SONG	"boyscout.bin"
+#define RATE	32768
+
+// a second player plays the song once over the first from this tick on,
+// which has it give channels back between the notes of the first
+#define SHARE_START	111
+#define SHARE_TICKS	500
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+typedef struct {
+	int ticks;
+	u32 registers;
+	u32 audio;
+} Result;
+
+//---------------------------------------------------------------------------------
+// plays the selected player's song once, or looped for the given ticks, as
+// tools/bsrender does
+//---------------------------------------------------------------------------------
+static Result render (int ticks)
+//---------------------------------------------------------------------------------
+{
+	static s16 buffer[2 * PSG_FRAME_CYCLES / (PSG_CLOCK / RATE) + 2];
+	const u8* io = (const u8*)GBAHOST_IO;
+	Result result = { 0, 0, 2166136261u };
+	unsigned long long rendered = 0;
+	int samples, i;
+	Psg psg;
+
+	psgInit (&psg, RATE);
+	BoyScoutPlaySong (ticks > 0);
+
+	for (result.ticks = 0; !ticks || result.ticks < ticks; result.ticks++) {
+		if (!BoyScoutUpdateSong ()) break;
+
+		for (i = 0x60; i < 0xa0; i++) {
+			result.registers = result.registers * 31 + io[i];
+		}
+		psgUpdate (&psg, (vu16*)GBAHOST_IO);
+
+		samples = (result.ticks + 1) * (unsigned long long)PSG_FRAME_CYCLES / psg.cyclesPerSample - rendered;
+		rendered += samples;
+		psgRender (&psg, buffer, samples);
+
+		for (i = 0; i < samples * 2; i++) {
+			result.audio = (result.audio ^ (u16)buffer[i]) * 16777619u;
+		}
+	}
+
+	return result;
+}
+
+//---------------------------------------------------------------------------------
+static Result play (int ticks, int compile)
+//---------------------------------------------------------------------------------
+{
+	// the registers as after a reset
+	memset ((void*)GBAHOST_IO, 0, GBAHOST_IO_SIZE);
+
+	BoyScoutInitialize ();
+	BoyScoutSetMemoryArea (GBAHOST_EWRAM);
+	CHECK (BoyScoutOpenSong ((const u8*)GBAHOST_ROM));
+	if (compile) {
+		CHECK (BoyScoutCompileSong ());
+	}
+
+	return render (ticks);
+}
+
+//---------------------------------------------------------------------------------
+// plays a preloaded song once and looped, which has to match the song
+// opened and played
+//---------------------------------------------------------------------------------
+static void checkLoaded (SBoyScoutSong* song)
+//---------------------------------------------------------------------------------
+{
+	Result result;
+	int loop;
+
+	for (loop = 0; loop < 2; loop++) {
+		memset ((void*)GBAHOST_IO, 0, GBAHOST_IO_SIZE);
+		BoyScoutInitialize ();
+		BoyScoutSetSong (song);
+		CHECK (BoyScoutGetPlayer ()->pSong == song);
+
+		result = render (loop ? 3000 : 0);
+		if (loop) {
+			CHECK (result.ticks == 3000);
+			CHECK (result.registers == 0x025ae974);
+			CHECK (result.audio == 0x141aa31d);
+		} else {
+			CHECK (result.ticks == 152);
+			CHECK (result.registers == 0x6d1144b4);
+			CHECK (result.audio == 0xbff9fafd);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------
+// songs preloaded into a pool of just the size they need
+//---------------------------------------------------------------------------------
+static void checkArena (void)
+//---------------------------------------------------------------------------------
+{
+	static SBoyScoutSong songs[2], untouched;
+	const u8* data = (const u8*)GBAHOST_ROM;
+	u8* pool = (u8*)(GBAHOST_EWRAM + 0x20000);
+	SBoyScoutArena arena, before;
+	unsigned int needed, compiled;
+	int i;
+
+	needed = BoyScoutGetNeededSongMemory (data);
+	CHECK (needed > 0 && needed % BOYSCOUT_MEMORY_ALIGN == 0);
+
+	// a byte short, the song is refused and nothing is touched
+	memset (pool, 0xa5, 0x20000);
+	memset (&songs[0], 0x5a, sizeof(SBoyScoutSong));
+	untouched = songs[0];
+	BoyScoutArenaInit (&arena, (unsigned int)pool, needed - 1);
+	before = arena;
+	CHECK (!BoyScoutLoadSong (&songs[0], data, &arena));
+	CHECK (memcmp (&arena, &before, sizeof(arena)) == 0);
+	CHECK (memcmp (&songs[0], &untouched, sizeof(SBoyScoutSong)) == 0);
+	for (i = 0; i < 0x20000 && pool[i] == 0xa5; i++);
+	CHECK (i == 0x20000);
+
+	// the needed size is exact
+	BoyScoutArenaInit (&arena, (unsigned int)pool, needed);
+	CHECK (BoyScoutLoadSong (&songs[0], data, &arena));
+	CHECK (BoyScoutArenaGetFree (&arena) == 0);
+	CHECK (pool[needed] == 0xa5);
+
+	// as is the compiled size, the rows are refused a byte short
+	compiled = BoyScoutGetNeededLoadedCompiledMemory (&songs[0]);
+	CHECK (compiled > 0);
+	BoyScoutArenaInit (&arena, (unsigned int)pool, needed + compiled - 1);
+	CHECK (BoyScoutLoadSong (&songs[0], data, &arena));
+	before = arena;
+	CHECK (!BoyScoutCompileLoadedSong (&songs[0], &arena));
+	CHECK (memcmp (&arena, &before, sizeof(arena)) == 0);
+	CHECK (!songs[0].nSongCompiled);
+
+	// two songs, one compiled, fill the pool exactly
+	memset (pool, 0xa5, 0x20000);
+	BoyScoutArenaInit (&arena, (unsigned int)pool, 2 * needed + compiled);
+	CHECK (BoyScoutLoadSong (&songs[0], data, &arena));
+	CHECK (BoyScoutLoadSong (&songs[1], data, &arena));
+	CHECK (BoyScoutCompileLoadedSong (&songs[1], &arena));
+	CHECK (BoyScoutArenaGetFree (&arena) == 0);
+	CHECK (pool[2 * needed + compiled] == 0xa5);
+	CHECK (!songs[0].nSongCompiled && songs[1].nSongCompiled);
+
+	// and each plays the same as the song opened, switched back and forth
+	checkLoaded (&songs[0]);
+	checkLoaded (&songs[1]);
+	checkLoaded (&songs[0]);
+}
+
+//---------------------------------------------------------------------------------
+static void checkPlaying (void)
+//---------------------------------------------------------------------------------
+{
+	SBoyScoutArena arena;
+
+	BoyScoutInitialize ();
+	BoyScoutSetMemoryArea (GBAHOST_EWRAM);
+	CHECK (BoyScoutOpenSong ((const u8*)GBAHOST_ROM));
+	BoyScoutPlaySong (1);
+
+	// the patterns can't change format under the player
+	BoyScoutArenaInit (&arena, GBAHOST_EWRAM + 0x20000, 0x20000);
+	CHECK (BoyScoutCompileSong () == 0);
+	CHECK (BoyScoutCompileLoadedSong (BoyScoutGetPlayer ()->pSong, &arena) == 0);
+	CHECK (BoyScoutGetPlayer ()->pSong->nSongCompiled == 0);
+
+	BoyScoutStopSong ();
+	CHECK (BoyScoutCompileSong () != 0);
+}
+
+//---------------------------------------------------------------------------------
+// the sound registers up to the wave RAM, without the INIT bits and the
+// wave bank, which the players may pick differently
+//---------------------------------------------------------------------------------
+static void soundRegisters (u16* regs)
+//---------------------------------------------------------------------------------
+{
+	const vu16* io = (const vu16*)(GBAHOST_IO + 0x60);
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		regs[i] = io[i];
+	}
+	regs[2] &= 0x7fff;
+	regs[6] &= 0x7fff;
+	regs[8] &= ~0x40;
+	regs[10] &= 0x7fff;
+	regs[14] &= 0x7fff;
+}
+
+//---------------------------------------------------------------------------------
+static void startMusic (void)
+//---------------------------------------------------------------------------------
+{
+	memset ((void*)GBAHOST_IO, 0, GBAHOST_IO_SIZE);
+
+	BoyScoutInitialize ();
+	BoyScoutSetMemoryArea (GBAHOST_EWRAM);
+	CHECK (BoyScoutOpenSong ((const u8*)GBAHOST_ROM));
+	BoyScoutPlaySong (1);
+}
+
+//---------------------------------------------------------------------------------
+// as soon as the first player has a channel back it has to put its own
+// settings back, not wait for its next note on the channel
+//---------------------------------------------------------------------------------
+static void checkRegained (void)
+//---------------------------------------------------------------------------------
+{
+	// the registers of each channel
+	static const u16 channelRegs[SOUND_CHANNEL_COUNT] = { 0x0007, 0x0050, 0x0700, 0x5000 };
+	static u16 alone[SHARE_TICKS][16];
+	static SBoyScoutPlayer sfx;
+	u16 regs[16];
+	int tick, i, n, taken = 0, regained = 0;
+	unsigned char owned, lastOwned = 0xf;
+
+	startMusic ();
+	for (tick = 0; tick < SHARE_TICKS; tick++) {
+		BoyScoutUpdateAllSongs ();
+		soundRegisters (alone[tick]);
+	}
+
+	startMusic ();
+	for (tick = 0; tick < SHARE_TICKS; tick++) {
+		if (tick == SHARE_START) {
+			BoyScoutAddPlayer (&sfx, 1);
+			BoyScoutSelectPlayer (&sfx);
+			BoyScoutSetMemoryArea (GBAHOST_EWRAM + 0x20000);
+			CHECK (BoyScoutOpenSong ((const u8*)GBAHOST_ROM));
+			BoyScoutPlaySong (0);
+			BoyScoutSelectPlayer (0);
+		}
+
+		BoyScoutUpdateAllSongs ();
+		soundRegisters (regs);
+
+		owned = BoyScoutGetPlayer ()->nOwnedChannels;
+		taken |= ~owned & 0xf;
+		regained |= owned & ~lastOwned;
+		lastOwned = owned;
+
+		for (n = 0; n < SOUND_CHANNEL_COUNT; n++) {
+			// the first player only sees a channel taken on its next row
+			if (!(sfx.nPlayState & PLAYSTATE_STOP) && sfx.aiPlayPatterns[n] != PATTERN_PARAMETER_EMPTY) continue;
+
+			for (i = 0; i < 16; i++) {
+				if ((owned & (1 << n)) && (channelRegs[n] & (1 << i)) && regs[i] != alone[tick][i]) {
+					printf ("tick %d, channel %d, register %x: %04x, %04x alone\n", tick, n + 1, 0x60 + 2 * i, regs[i], alone[tick][i]);
+					failures++;
+				}
+			}
+		}
+	}
+
+	// every channel was taken and given back
+	CHECK (taken == 0xf);
+	CHECK (regained == 0xf);
+	CHECK (sfx.nPlayState & PLAYSTATE_STOP);
+
+	BoyScoutRemovePlayer (&sfx);
+}
+
+//---------------------------------------------------------------------------------
+// the timer plays every player without selecting it, a one shot ending
+// has to stop its own player and not the selected one
+//---------------------------------------------------------------------------------
+static void checkTimer (void)
+//---------------------------------------------------------------------------------
+{
+	static SBoyScoutPlayer sfx;
+	SBoyScoutPlayer* music;
+	int tick;
+
+	startMusic ();
+	music = BoyScoutGetPlayer ();
+
+	BoyScoutAddPlayer (&sfx, 1);
+	BoyScoutSelectPlayer (&sfx);
+	BoyScoutSetMemoryArea (GBAHOST_EWRAM + 0x20000);
+	CHECK (BoyScoutOpenSong ((const u8*)GBAHOST_ROM));
+	BoyScoutPlaySong (0);
+	BoyScoutSelectPlayer (0);
+
+	CHECK (BoyScoutStartTimer (0));
+	for (tick = 0; tick < 2000; tick++) {
+		if (!gbaHostInterrupt (IRQ_TIMER0)) break;
+	}
+	BoyScoutStopTimer ();
+
+	CHECK (tick == 2000);
+	CHECK (BoyScoutGetPlayer () == music);
+	CHECK (!(music->nPlayState & PLAYSTATE_STOP));
+	CHECK (sfx.nPlayState & PLAYSTATE_STOP);
+	CHECK (sfx.iPlayPosition == sfx.pSong->nSongLength);
+
+	// and no timer is left to fire
+	CHECK (!gbaHostInterrupt (IRQ_TIMER0));
+
+	BoyScoutRemovePlayer (&sfx);
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	Result result;
+	int compile;
+
+	if (!gbaHostMap () || gbaHostLoadRom (SONG) <= 0) {
+		printf ("can't set up the GBA memory and " SONG "\n");
+		return 1;
+	}
+
+	// compiled songs play exactly the same
+	for (compile = 0; compile < 2; compile++) {
+		result = play (0, compile);
+		CHECK (result.ticks == 152);
+		CHECK (result.registers == 0x6d1144b4);
+		CHECK (result.audio == 0xbff9fafd);
+
+		result = play (3000, compile);
+		CHECK (result.ticks == 3000);
+		CHECK (result.registers == 0x025ae974);
+		CHECK (result.audio == 0x141aa31d);
+	}
+
+	checkArena ();
+	checkPlaying ();
+	checkRegained ();
+	checkTimer ();
+
+	return failures != 0;
+}
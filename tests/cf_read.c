@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the CF data register reads against a mock register
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "io_cf_common.h"
+
+// every read of the mock data register returns the next halfword
+static vu16 mockData;
+static u32 mockReads;
+
+static u16 mockRead (vu16* reg) {
+	if (reg != &mockData) {
+		return 0xdead;
+	}
+	return (u16)(0x1234 + 0x0101 * mockReads++);
+}
+
+#define CF_READ_DATA(reg) mockRead (reg)
+#include "../src/disc_io/io_cf_read.iwram.c"
+
+CF_REGISTERS cfRegisters = { &mockData };
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+static void check (u32 count)
+//---------------------------------------------------------------------------------
+{
+	u16 buff[260];
+	u32 i;
+
+	memset (buff, 0xff, sizeof(buff));
+	mockReads = 0;
+
+	_CF_readHalfwords (buff, count);
+
+	CHECK(mockReads == count);
+	for (i = 0; i < count; i++) {
+		CHECK(buff[i] == (u16)(0x1234 + 0x0101 * i));
+	}
+	// nothing past the end is touched
+	CHECK(buff[count] == 0xffff);
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	check (256);
+	check (0);
+	check (1);
+	check (7);
+	check (8);
+	check (13);
+
+	return failures != 0;
+}
@@ -0,0 +1,181 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the combo matcher, fed keypad input a frame at a time:
+	combos sharing their start or end, fallbacks out of a half entered
+	combo, the frame window of each combo and duplicate combos
+
+---------------------------------------------------------------------------------*/
+#include <gba_input.h>
+#include <stdio.h>
+
+#include "gbahost.h"
+
+#define D	KEY_DOWN
+#define DF	(KEY_DOWN | KEY_RIGHT)
+#define F	KEY_RIGHT
+#define B	KEY_LEFT
+
+static const u8 fireball[] = { COMBO_DOWN, COMBO_DOWN_FORWARD, COMBO_FORWARD, COMBO_A };
+static const u8 jab[] = { COMBO_FORWARD, COMBO_A };
+static const u8 kick[] = { COMBO_DOWN, COMBO_DOWN_FORWARD, COMBO_FORWARD, COMBO_B };
+static const u8 dash[] = { COMBO_FORWARD, COMBO_NEUTRAL, COMBO_FORWARD };
+static const u8 pause[] = { COMBO_START };
+static const u8 dashPunch[] = { COMBO_FORWARD, COMBO_NEUTRAL, COMBO_FORWARD, COMBO_A };
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+// one frame with keys held on the keypad, returns the combo completed
+//---------------------------------------------------------------------------------
+static int frame (u16 pressed)
+//---------------------------------------------------------------------------------
+{
+	REG_KEYINPUT = pressed ^ 0x03ff;
+	scanKeys ();
+	return comboUpdate ();
+}
+
+//---------------------------------------------------------------------------------
+// lets go of the keypad and starts afresh
+//---------------------------------------------------------------------------------
+static void release (void)
+//---------------------------------------------------------------------------------
+{
+	frame (0);
+	comboReset ();
+}
+
+//---------------------------------------------------------------------------------
+// holds each entry of keys for hold frames, returns the last combo
+// completed, and counts all of them in matches
+//---------------------------------------------------------------------------------
+static int enter (const u16* keys, int count, int hold, int* matches)
+//---------------------------------------------------------------------------------
+{
+	int i, n, id, last = -1;
+
+	*matches = 0;
+	for (i = 0; i < count; i++) {
+		for (n = 0; n < hold; n++) {
+			id = frame (keys[i]);
+			if (id >= 0) {
+				last = id;
+				(*matches)++;
+			}
+		}
+	}
+	release ();
+
+	return last;
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	static const u16 fireballKeys[] = { D, DF, F, F | KEY_A };
+	static const u16 kickKeys[] = { D, DF, F, F | KEY_B };
+	static const u16 restartKeys[] = { D, DF, D, DF, F, F | KEY_A };
+	static const u16 dashKeys[] = { F, 0, F };
+	static const u16 backKeys[] = { B, 0, B };
+	static const u16 jabKeys[] = { F, F | KEY_A };
+	static const u16 dashesKeys[] = { F, 0, F, 0, F, F | KEY_A };
+	int fireballId, jabId, kickId, dashId, pauseId, dashPunchId;
+	int matches, i;
+
+	if (!gbaHostMap ()) {
+		printf ("can't set up the GBA memory\n");
+		return 1;
+	}
+	REG_KEYINPUT = 0x03ff;
+
+	// nothing matches before a compile
+	comboClear ();
+	CHECK (frame (KEY_START) == -1);
+
+	fireballId = comboAdd (fireball, 4, 30);
+	jabId = comboAdd (jab, 2, 12);
+	kickId = comboAdd (kick, 4, 30);
+	dashId = comboAdd (dash, 3, 20);
+	pauseId = comboAdd (pause, 1, 0);
+	dashPunchId = comboAdd (dashPunch, 4, 20);
+	CHECK (fireballId == 0 && jabId == 1 && kickId == 2 && dashId == 3 && pauseId == 4 && dashPunchId == 5);
+	CHECK (comboAdd (fireball, 0, 30) == -1);
+	CHECK (comboAdd (fireball, COMBO_MAX_STEPS + 1, 30) == -1);
+	CHECK (comboAdd (fireball, 4, -1) == -1);
+	CHECK (comboCompile ());
+	release ();
+
+	// the longest combo in time wins over the one ending inside it, and
+	// only one is reported for the step
+	CHECK (enter (fireballKeys, 4, 10, &matches) == fireballId);
+	CHECK (matches == 1);
+
+	// over its window the fireball falls back to the jab at its end, which
+	// is only reported within its own window
+	CHECK (enter (fireballKeys, 4, 11, &matches) == jabId);
+	CHECK (matches == 1);
+	CHECK (enter (fireballKeys, 4, 13, &matches) == -1);
+	CHECK (enter (jabKeys, 2, 12, &matches) == jabId);
+	CHECK (enter (jabKeys, 2, 13, &matches) == -1);
+
+	// combos sharing their first three steps go their own way on the last
+	CHECK (enter (kickKeys, 4, 5, &matches) == kickId);
+	CHECK (matches == 1);
+
+	// a half entered combo which goes wrong falls back to where its
+	// steps start another, and the window counts from there
+	CHECK (enter (restartKeys, 6, 7, &matches) == fireballId);
+	CHECK (matches == 1);
+
+	// and not only to the first step: after a dash, the next neutral and
+	// forward are the middle of another dash, which can end in a punch
+	CHECK (enter (dashesKeys, 6, 3, &matches) == dashPunchId);
+	CHECK (matches == 3);
+
+	// neutral is a step of its own, and back isn't forward until facing left
+	CHECK (enter (dashKeys, 3, 4, &matches) == dashId);
+	CHECK (enter (backKeys, 3, 4, &matches) == -1);
+	comboSetFacing (true);
+	CHECK (enter (backKeys, 3, 4, &matches) == dashId);
+	comboSetFacing (false);
+
+	// a one step combo with no time at all, pressed not held
+	CHECK (frame (KEY_START) == pauseId);
+	CHECK (frame (KEY_START) == -1);
+	release ();
+
+	// the window is stored in 16 bits, larger ones are the most it holds
+	comboClear ();
+	CHECK (comboAdd (jab, 2, 100000) == 0);
+	CHECK (comboCompile ());
+	release ();
+	for (i = 0; i < 0xffff; i++) frame (F);
+	CHECK (frame (F | KEY_A) == 0);
+	release ();
+	for (i = 0; i < 0x10000; i++) frame (F);
+	CHECK (frame (F | KEY_A) == -1);
+	release ();
+
+	// the same steps twice can't be compiled, and nothing is matched
+	comboClear ();
+	CHECK (comboAdd (fireball, 4, 30) == 0);
+	CHECK (comboAdd (jab, 2, 12) == 1);
+	CHECK (comboAdd (fireball, 4, 60) == 2);
+	CHECK (!comboCompile ());
+	CHECK (enter (fireballKeys, 4, 5, &matches) == -1);
+	CHECK (enter (jabKeys, 2, 5, &matches) == -1);
+
+	// a combo inside another is fine, it isn't the same
+	comboClear ();
+	CHECK (comboAdd (fireball, 4, 30) == 0);
+	CHECK (comboAdd (fireball, 3, 30) == 1);
+	CHECK (comboCompile ());
+	release ();
+	CHECK (enter (fireballKeys, 4, 5, &matches) == 0);
+	CHECK (matches == 2);
+
+	return failures != 0;
+}
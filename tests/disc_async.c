@@ -0,0 +1,293 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the interrupt driven CF transfers, with the timer
+	interrupt run by hand against a CF card on mock registers
+
+	The card only moves on between ticks, as a real one does while the
+	CPU is elsewhere: it takes a command, raises DRQ a few ticks later,
+	and drops it again once a sector has gone through the data register.
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "gbahost.h"
+
+static u16 cardRead (void);
+static void cardWrite (u16 value);
+
+#define CF_READ_DATA(reg) ((void)(reg), cardRead ())
+#define CF_WRITE_DATA(reg, value) ((void)(reg), cardWrite (value))
+#include "../src/disc_io/io_cf_common.c"
+#include "../src/disc_io/io_cf_read.iwram.c"
+#include "../src/disc_io/disc_async.c"
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+#define TIMER		2
+#define SECTORS		600
+#define LATENCY		2			// ticks from a command or a sector to DRQ
+#define PROGRAMMING	5			// ticks the card stays busy after the last sector written
+
+static u8 card[SECTORS * 512];
+static u8 buffer[SECTORS * 512 + 1], expected[SECTORS * 512];
+
+static vu16 dataRegister, statusRegister, commandRegister, errorRegister, countRegister;
+static vu16 lba1Register, lba2Register, lba3Register, lba4Register;
+
+static const CF_REGISTERS registers = {
+	&dataRegister, &statusRegister, &commandRegister, &errorRegister, &countRegister,
+	&lba1Register, &lba2Register, &lba3Register, &lba4Register
+};
+
+static const DISC_INTERFACE cfDisc = {
+	0, 0, NULL, NULL, (FN_MEDIUM_READSECTORS)&_CF_readSectors, (FN_MEDIUM_WRITESECTORS)&_CF_writeSectors, NULL, NULL
+};
+
+// the card's side of the transfer
+static char commands[256];		// "R" or "W", first sector and count of each command
+static u32 cardSector;
+static int cardRemaining;		// sectors left in the command
+static bool cardWriting;
+static int cardHalfwords;		// moved of the current sector
+static int cardWait;			// ticks until DRQ, or until no longer busy
+static int cardStall;			// sectors after which DRQ is never raised again, -1 for none
+
+//---------------------------------------------------------------------------------
+static void cardReset (void)
+//---------------------------------------------------------------------------------
+{
+	statusRegister = CF_STS_INSERTED;
+	commandRegister = CF_STS_INSERTED;
+	cardRemaining = 0;
+	cardWait = 0;
+	cardStall = -1;
+	commands[0] = 0;
+}
+
+//---------------------------------------------------------------------------------
+// a sector has gone through the data register
+//---------------------------------------------------------------------------------
+static void cardSectorDone (void)
+//---------------------------------------------------------------------------------
+{
+	statusRegister = CF_STS_INSERTED;
+	cardHalfwords = 0;
+	cardSector++;
+
+	if (cardStall > 0) cardStall--;
+
+	if (--cardRemaining > 0) {
+		cardWait = LATENCY;
+	} else if (cardWriting) {
+		commandRegister = CF_STS_BUSY;
+		cardWait = PROGRAMMING;
+	}
+}
+
+//---------------------------------------------------------------------------------
+static u16 cardRead (void)
+//---------------------------------------------------------------------------------
+{
+	u8* data = card + cardSector * 512 + cardHalfwords * 2;
+
+	CHECK (statusRegister == CF_STS_READY);
+
+	if (++cardHalfwords == 256) cardSectorDone ();
+	return data[0] | (data[1] << 8);
+}
+
+//---------------------------------------------------------------------------------
+static void cardWrite (u16 value)
+//---------------------------------------------------------------------------------
+{
+	u8* data = card + cardSector * 512 + cardHalfwords * 2;
+
+	CHECK (statusRegister == CF_STS_READY);
+
+	data[0] = value;
+	data[1] = value >> 8;
+	if (++cardHalfwords == 256) cardSectorDone ();
+}
+
+//---------------------------------------------------------------------------------
+// what the card does between two ticks
+//---------------------------------------------------------------------------------
+static void cardStep (void)
+//---------------------------------------------------------------------------------
+{
+	if (commandRegister == CF_CMD_READ || commandRegister == CF_CMD_WRITE) {
+		cardSector = lba1Register | (lba2Register << 8) | (lba3Register << 16) | ((lba4Register & 0x0f) << 24);
+		cardRemaining = countRegister ? countRegister : 256;
+		cardHalfwords = 0;
+		cardWriting = (commandRegister == CF_CMD_WRITE);
+		sprintf (commands + strlen (commands), "%c%u+%d ", cardWriting ? 'W' : 'R', cardSector, cardRemaining);
+
+		commandRegister = CF_STS_BUSY;
+		cardWait = LATENCY;
+		return;
+	}
+
+	if (cardWait > 0 && --cardWait == 0) {
+		commandRegister = CF_STS_INSERTED;
+		if (cardRemaining > 0 && cardStall != 0) statusRegister = CF_STS_READY;
+	}
+}
+
+//---------------------------------------------------------------------------------
+// runs the timer interrupt until the transfer ends, returns the ticks taken
+//---------------------------------------------------------------------------------
+static int run (int most)
+//---------------------------------------------------------------------------------
+{
+	int ticks = 0;
+
+	while (discAsyncPoll () == DISC_ASYNC_BUSY && ticks < most) {
+		cardStep ();
+		CHECK (gbaHostInterrupt (IRQ_TIMER0 << TIMER));
+		ticks++;
+	}
+	return ticks;
+}
+
+//---------------------------------------------------------------------------------
+void IntrWait (u32 ReturnFlag, u32 IntFlag)
+//---------------------------------------------------------------------------------
+{
+	CHECK (IntFlag == IRQ_TIMER0 << TIMER);
+
+	cardStep ();
+	gbaHostInterrupt (IntFlag);
+}
+
+// callbacks, in the order they were called
+static char calls[64];
+
+//---------------------------------------------------------------------------------
+static void callback (bool result, void* userData)
+//---------------------------------------------------------------------------------
+{
+	// the status is already final when the callback runs
+	CHECK (discAsyncPoll () == (result ? DISC_ASYNC_DONE : DISC_ASYNC_FAILED));
+
+	sprintf (calls + strlen (calls), "%s:%d ", (const char*)userData, result);
+}
+
+//---------------------------------------------------------------------------------
+// starts a second read from the first one's callback
+//---------------------------------------------------------------------------------
+static void chain (bool result, void* userData)
+//---------------------------------------------------------------------------------
+{
+	callback (result, userData);
+	CHECK (discAsyncRead (100, 2, buffer + 512, callback, "second"));
+}
+
+//---------------------------------------------------------------------------------
+static bool syncRead (u32 sector, u32 numSectors, void* buffer)
+//---------------------------------------------------------------------------------
+{
+	memcpy (buffer, card + sector * 512, numSectors * 512);
+	return true;
+}
+
+static const DISC_INTERFACE syncDisc = { 0, 0, NULL, NULL, syncRead, NULL, NULL, NULL };
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	if (!gbaHostMap ()) {
+		printf ("can't set up the GBA memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(card); i++) card[i] = i * 13 + (i >> 9);
+
+	cardReset ();
+	// _CF_startup would find these registers are 16 bit
+	cfRegisters = registers;
+	CHECK (discAsyncInit (&cfDisc, TIMER));
+
+	// more than one command's worth, all moved in the interrupt
+	CHECK (discAsyncRead (10, 300, buffer, callback, "read"));
+	CHECK (discAsyncPoll () == DISC_ASYNC_BUSY);
+	CHECK (REG_TMCNT_H(TIMER) == (TIMER_START | TIMER_IRQ | TIMER_FREQ_64));
+	CHECK (!discAsyncRead (0, 1, buffer, callback, "refused"));
+	CHECK (run (10000) < 10000);
+	CHECK (discAsyncPoll () == DISC_ASYNC_DONE);
+	CHECK (strcmp (commands, "R10+256 R266+44 ") == 0);
+	CHECK (strcmp (calls, "read:1 ") == 0);
+	CHECK (memcmp (buffer, card + 10 * 512, 300 * 512) == 0);
+
+	// the timer only runs during a transfer
+	CHECK (REG_TMCNT_H(TIMER) == 0);
+	CHECK (!gbaHostInterrupt (IRQ_TIMER0 << TIMER));
+
+	// a write from an odd address isn't done until the card has programmed it
+	for (i = 0; i < 5 * 512; i++) buffer[i + 1] = expected[i] = i * 3;
+	commands[0] = calls[0] = 0;
+	CHECK (discAsyncWrite (400, 5, buffer + 1, callback, "write"));
+	for (i = 0; commandRegister != CF_STS_BUSY || cardRemaining > 0; i++) {
+		CHECK (i < 100);
+		cardStep ();
+		gbaHostInterrupt (IRQ_TIMER0 << TIMER);
+	}
+	cardStep ();
+	gbaHostInterrupt (IRQ_TIMER0 << TIMER);
+	CHECK (discAsyncPoll () == DISC_ASYNC_BUSY);
+	CHECK (calls[0] == 0);
+	CHECK (discAsyncWait ());
+	CHECK (strcmp (commands, "W400+5 ") == 0);
+	CHECK (strcmp (calls, "write:1 ") == 0);
+	CHECK (memcmp (card + 400 * 512, expected, 5 * 512) == 0);
+
+	// a transfer started from a callback runs after it
+	commands[0] = calls[0] = 0;
+	CHECK (discAsyncRead (50, 1, buffer, chain, "first"));
+	run (100);
+	CHECK (discAsyncPoll () == DISC_ASYNC_DONE);
+	CHECK (strcmp (commands, "R50+1 R100+2 ") == 0);
+	CHECK (strcmp (calls, "first:1 second:1 ") == 0);
+	CHECK (memcmp (buffer, card + 50 * 512, 512) == 0);
+	CHECK (memcmp (buffer + 512, card + 100 * 512, 2 * 512) == 0);
+
+	// a card which stops part way fails the transfer after the timeout
+	commands[0] = calls[0] = 0;
+	memset (buffer, 0, 8 * 512);
+	cardStall = 3;
+	CHECK (discAsyncRead (20, 8, buffer, callback, "stall"));
+	i = run (10000);
+	CHECK (i > DISC_ASYNC_TIMEOUT_TICKS && i < DISC_ASYNC_TIMEOUT_TICKS + 20);
+	CHECK (discAsyncPoll () == DISC_ASYNC_FAILED);
+	CHECK (strcmp (calls, "stall:0 ") == 0);
+	CHECK (memcmp (buffer, card + 20 * 512, 3 * 512) == 0);
+	CHECK (buffer[3 * 512] == 0);
+	CHECK (REG_TMCNT_H(TIMER) == 0);
+
+	// stopping part way fails the transfer without a callback, and
+	// releases the timer and its interrupt
+	cardReset ();
+	calls[0] = 0;
+	CHECK (discAsyncRead (30, 8, buffer, callback, "stopped"));
+	run (3 * LATENCY);
+	CHECK (discAsyncPoll () == DISC_ASYNC_BUSY);
+	discAsyncStop ();
+	CHECK (discAsyncPoll () == DISC_ASYNC_FAILED);
+	CHECK (REG_TMCNT_H(TIMER) == 0);
+	CHECK (!gbaHostInterrupt (IRQ_TIMER0 << TIMER));
+	CHECK (calls[0] == 0);
+	CHECK (!discAsyncRead (30, 8, buffer, callback, "no disc"));
+
+	// other interfaces finish inside the call
+	CHECK (discAsyncInit (&syncDisc, TIMER));
+	CHECK (discAsyncRead (60, 2, buffer, callback, "sync"));
+	CHECK (strcmp (calls, "sync:1 ") == 0);
+	CHECK (memcmp (buffer, card + 60 * 512, 2 * 512) == 0);
+
+	return failures != 0;
+}
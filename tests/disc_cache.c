@@ -0,0 +1,175 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the disc cache against a RAM disc
+
+---------------------------------------------------------------------------------*/
+#include <disc_cache.h>
+#include <disc_virtual.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SECTORS		64
+#define CACHED		8
+
+static u8 image[SECTORS * DISC_CACHE_SECTOR_SIZE];
+static u8 buffer[SECTORS * DISC_CACHE_SECTOR_SIZE];
+static u8 expect[SECTORS * DISC_CACHE_SECTOR_SIZE];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+// a RAM disc whose writes can be made to fail
+//---------------------------------------------------------------------------------
+static const DISC_INTERFACE* ram;
+static bool failWrites = false;
+static int discWrites = 0;
+
+static bool _fail_startup (void) { return ram->startup(); }
+static bool _fail_isInserted (void) { return ram->isInserted(); }
+static bool _fail_clearStatus (void) { return ram->clearStatus(); }
+static bool _fail_shutdown (void) { return ram->shutdown(); }
+
+static bool _fail_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	return ram->readSectors (sector, numSectors, buffer);
+}
+
+static bool _fail_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	discWrites++;
+	if (failWrites) {
+		// half of the sectors reach the disc before the error
+		ram->writeSectors (sector, numSectors / 2, buffer);
+		return false;
+	}
+	return ram->writeSectors (sector, numSectors, buffer);
+}
+
+static const DISC_INTERFACE failDisc = {
+	DEVICE_TYPE_RAMDISC,
+	FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE,
+	_fail_startup,
+	_fail_isInserted,
+	_fail_readSectors,
+	_fail_writeSectors,
+	_fail_clearStatus,
+	_fail_shutdown
+};
+
+static void fill (u8* data, sec_t sector, sec_t numSectors, int seed) {
+	u32 i;
+
+	for (i = 0; i < numSectors * DISC_CACHE_SECTOR_SIZE; i++) {
+		data[i] = (u8)(sector * 7 + i * 13 + seed);
+	}
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	const DISC_INTERFACE* disc;
+	DISC_CACHE_STATS stats;
+	int i;
+
+	fill (image, 0, SECTORS, 0);
+	memcpy (expect, image, sizeof(image));
+
+	ram = discRamInit (image, SECTORS, true);
+	CHECK(ram != NULL);
+	disc = discCacheInit (&failDisc, CACHED);
+	CHECK(disc != NULL);
+	CHECK(disc->ioType == DEVICE_TYPE_RAMDISC);
+	CHECK(disc->startup());
+
+	// reads match the disc and cached sectors are kept
+	CHECK(disc->readSectors (3, 1, buffer));
+	CHECK(disc->readSectors (10, 1, buffer + DISC_CACHE_SECTOR_SIZE));
+	CHECK(memcmp (buffer, expect + 3 * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) == 0);
+	CHECK(memcmp (buffer + DISC_CACHE_SECTOR_SIZE, expect + 10 * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) == 0);
+
+	// a small write stays in the cache until flushed
+	fill (buffer, 20, 2, 1);
+	CHECK(disc->writeSectors (20, 2, buffer));
+	memcpy (expect + 20 * DISC_CACHE_SECTOR_SIZE, buffer, 2 * DISC_CACHE_SECTOR_SIZE);
+	CHECK(memcmp (image + 20 * DISC_CACHE_SECTOR_SIZE, expect + 20 * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) != 0);
+	CHECK(discCacheFlush());
+	CHECK(memcmp (image, expect, sizeof(image)) == 0);
+
+	// a large write goes through and refreshes the cached copies
+	fill (buffer, 0, 16, 2);
+	CHECK(disc->writeSectors (0, 16, buffer));
+	memcpy (expect, buffer, 16 * DISC_CACHE_SECTOR_SIZE);
+	CHECK(memcmp (image, expect, sizeof(image)) == 0);
+	CHECK(disc->readSectors (3, 1, buffer));
+	CHECK(memcmp (buffer, expect + 3 * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) == 0);
+	CHECK(disc->readSectors (10, 1, buffer));
+	CHECK(memcmp (buffer, expect + 10 * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) == 0);
+
+	// a failed large write leaves nothing stale in the cache
+	fill (buffer, 0, 16, 3);
+	failWrites = true;
+	CHECK(!disc->writeSectors (0, 16, buffer));
+	failWrites = false;
+	for (i = 15; i >= 0; i--) {
+		CHECK(disc->readSectors (i, 1, buffer));
+		CHECK(memcmp (buffer, image + i * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) == 0);
+	}
+
+	// a failed large write keeps sectors which were not written back yet
+	fill (buffer, 30, 1, 4);
+	CHECK(disc->writeSectors (30, 1, buffer));
+	memcpy (expect, buffer, DISC_CACHE_SECTOR_SIZE);
+	fill (buffer, 24, 16, 5);
+	failWrites = true;
+	CHECK(!disc->writeSectors (24, 16, buffer));
+	failWrites = false;
+	CHECK(discCacheFlush());
+	CHECK(memcmp (image + 30 * DISC_CACHE_SECTOR_SIZE, expect, DISC_CACHE_SECTOR_SIZE) == 0);
+
+	// rewriting a dirty sector costs nothing until the flush, which
+	// writes it back once
+	CHECK(discCacheFlush());
+	discCacheResetStats();
+	discWrites = 0;
+	for (i = 0; i < 10; i++) {
+		fill (buffer, 40, 1, 6 + i);
+		CHECK(disc->writeSectors (40, 1, buffer));
+	}
+	memcpy (expect + 40 * DISC_CACHE_SECTOR_SIZE, buffer, DISC_CACHE_SECTOR_SIZE);
+	CHECK(discWrites == 0);
+	CHECK(discCacheFlush());
+	CHECK(discWrites == 1);
+	discCacheGetStats (&stats);
+	CHECK(stats.writeMisses == 1);
+	CHECK(stats.writeHits == 9);
+	CHECK(stats.writeBacks == 1);
+	CHECK(stats.sectorsFlushed == 1);
+	CHECK(memcmp (image + 40 * DISC_CACHE_SECTOR_SIZE, expect + 40 * DISC_CACHE_SECTOR_SIZE, DISC_CACHE_SECTOR_SIZE) == 0);
+
+	// a clean cache flushes nothing
+	CHECK(discCacheFlush());
+	CHECK(discWrites == 1);
+	discCacheGetStats (&stats);
+	CHECK(stats.writeBacks == 1);
+
+	// adjacent dirty sectors, written out of order and over again, go
+	// back in one write
+	discCacheResetStats();
+	discWrites = 0;
+	for (i = 0; i < 3; i++) {
+		fill (buffer, 50, 1, i);
+		CHECK(disc->writeSectors (50, 1, buffer));
+		fill (buffer, 48, 2, i);
+		CHECK(disc->writeSectors (48, 2, buffer));
+	}
+	CHECK(discCacheFlush());
+	CHECK(discWrites == 1);
+	discCacheGetStats (&stats);
+	CHECK(stats.writeBacks == 1);
+	CHECK(stats.sectorsFlushed == 3);
+
+	CHECK(discCacheFree());
+
+	return failures != 0;
+}
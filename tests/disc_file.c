@@ -0,0 +1,159 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the file backed disc against a disc image in /tmp
+
+	The file is moved through pread and pwrite which here are interrupted
+	and come back short now and then, as they may for a real file, so the
+	sectors only come out right if the disc goes on until all are done.
+
+---------------------------------------------------------------------------------*/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define pread shortRead
+#define pwrite shortWrite
+#include "../src/disc_io/disc_virtual.c"
+#undef pread
+#undef pwrite
+
+// the real ones, which unistd.h declared under the names above
+extern ssize_t pread (int fd, void* buf, size_t count, off_t offset);
+extern ssize_t pwrite (int fd, const void* buf, size_t count, off_t offset);
+
+#define SECTORS		40
+#define SHORTEST	100
+
+static u8 image[SECTORS * BYTES_PER_SECTOR];
+static u8 buffer[SECTORS * BYTES_PER_SECTOR];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+static int calls, interrupted;
+
+// every third call is interrupted, the others move at most a little
+// more than SHORTEST bytes
+static size_t shorten (size_t count) {
+	calls++;
+	if (calls % 3 == 0) {
+		interrupted++;
+		errno = EINTR;
+		return 0;
+	}
+	return count < SHORTEST + calls % 7 ? count : SHORTEST + calls % 7;
+}
+
+ssize_t shortRead (int fd, void* buf, size_t count, off_t offset) {
+	size_t length = shorten (count);
+
+	return length ? pread (fd, buf, length, offset) : -1;
+}
+
+ssize_t shortWrite (int fd, const void* buf, size_t count, off_t offset) {
+	size_t length = shorten (count);
+
+	return length ? pwrite (fd, buf, length, offset) : -1;
+}
+
+static void fill (u8* data, sec_t sector, sec_t numSectors, int seed) {
+	u32 i;
+
+	for (i = 0; i < numSectors * BYTES_PER_SECTOR; i++) {
+		data[i] = (u8)(sector * 7 + i * 13 + seed);
+	}
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	char path[] = "/tmp/disc_fileXXXXXX";
+	const DISC_INTERFACE* disc;
+	FILE* file;
+	int fd;
+
+	fd = mkstemp (path);
+	if (fd < 0) {
+		printf ("can't make a disc image\n");
+		return 1;
+	}
+	fill (image, 0, SECTORS, 0);
+	CHECK(write (fd, image, sizeof(image)) == sizeof(image));
+	// a partial sector at the end isn't part of the disc
+	CHECK(write (fd, image, 100) == 100);
+	close (fd);
+
+	// nothing is opened until startup
+	disc = discFileInit (path, true);
+	CHECK(disc != NULL);
+	CHECK(disc->ioType == DEVICE_TYPE_FILEDISC);
+	CHECK(disc->features == (FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE));
+	CHECK(!disc->isInserted());
+	CHECK(!disc->readSectors (0, 1, buffer));
+	CHECK(disc->startup());
+	CHECK(disc->isInserted());
+	CHECK(fileDisc.numSectors == SECTORS);
+
+	// reads of every sector, in pieces
+	calls = interrupted = 0;
+	CHECK(disc->readSectors (0, SECTORS, buffer));
+	CHECK(memcmp (buffer, image, sizeof(image)) == 0);
+	CHECK(interrupted > 0 && calls > SECTORS * BYTES_PER_SECTOR / (SHORTEST + 7));
+	CHECK(disc->readSectors (SECTORS - 1, 1, buffer));
+	CHECK(memcmp (buffer, image + (SECTORS - 1) * BYTES_PER_SECTOR, BYTES_PER_SECTOR) == 0);
+
+	// nothing past the end
+	CHECK(!disc->readSectors (SECTORS, 1, buffer));
+	CHECK(!disc->readSectors (SECTORS - 2, 3, buffer));
+	CHECK(!disc->writeSectors (SECTORS - 1, 2, buffer));
+
+	// writes reach the file, and read back after a restart
+	fill (buffer, 5, 7, 1);
+	memcpy (image + 5 * BYTES_PER_SECTOR, buffer, 7 * BYTES_PER_SECTOR);
+	calls = interrupted = 0;
+	CHECK(disc->writeSectors (5, 7, buffer));
+	CHECK(interrupted > 0);
+	CHECK(disc->shutdown());
+	CHECK(!disc->isInserted());
+	CHECK(disc->startup());
+	CHECK(disc->readSectors (0, SECTORS, buffer));
+	CHECK(memcmp (buffer, image, sizeof(image)) == 0);
+	CHECK(disc->shutdown());
+
+	file = fopen (path, "rb");
+	CHECK(file != NULL && fread (buffer, 1, sizeof(buffer), file) == sizeof(buffer));
+	CHECK(memcmp (buffer, image, sizeof(image)) == 0);
+	if (file) fclose (file);
+
+	// a read only disc refuses writes and leaves the file as it was
+	disc = discFileInit (path, false);
+	CHECK(disc->features == FEATURE_MEDIUM_CANREAD);
+	CHECK(disc->startup());
+	fill (buffer, 0, 1, 2);
+	CHECK(!disc->writeSectors (0, 1, buffer));
+	CHECK(disc->readSectors (0, 1, buffer));
+	CHECK(memcmp (buffer, image, BYTES_PER_SECTOR) == 0);
+
+	// the simulated time is charged for the file disc as well
+	CHECK(discVirtualSetTiming (disc, &discTimingCF));
+	discVirtualResetElapsed (disc);
+	CHECK(disc->readSectors (0, 4, buffer));
+	CHECK(discVirtualElapsed (disc) == discTimingCF.commandLatency + 4ULL * BYTES_PER_SECTOR * 1000000 / discTimingCF.bytesPerSecond);
+	CHECK(disc->shutdown());
+
+	// a missing file, or one under a sector, doesn't start
+	unlink (path);
+	CHECK(!discFileInit (path, false)->startup());
+	fd = open (path, O_RDWR | O_CREAT, 0600);
+	CHECK(fd >= 0 && write (fd, image, 100) == 100);
+	close (fd);
+	CHECK(!discFileInit (path, false)->startup());
+	unlink (path);
+
+	CHECK(discFileInit (NULL, false) == NULL);
+
+	return failures != 0;
+}
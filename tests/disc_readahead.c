@@ -0,0 +1,134 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the readahead wrapper against a RAM disc
+
+---------------------------------------------------------------------------------*/
+#include <disc_readahead.h>
+#include <disc_virtual.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SECTOR_SIZE	512
+#define SECTORS		64
+
+static u8 image[SECTORS * SECTOR_SIZE];
+static u8 buffer[4 * SECTOR_SIZE];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+// a RAM disc whose writes can be made to fail
+//---------------------------------------------------------------------------------
+static const DISC_INTERFACE* ram;
+static bool failWrites = false;
+
+static bool _fail_startup (void) { return ram->startup(); }
+static bool _fail_isInserted (void) { return ram->isInserted(); }
+static bool _fail_clearStatus (void) { return ram->clearStatus(); }
+static bool _fail_shutdown (void) { return ram->shutdown(); }
+
+static bool _fail_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	return ram->readSectors (sector, numSectors, buffer);
+}
+
+static bool _fail_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	if (failWrites) {
+		// half of the sectors reach the disc before the error
+		ram->writeSectors (sector, numSectors / 2, buffer);
+		return false;
+	}
+	return ram->writeSectors (sector, numSectors, buffer);
+}
+
+static const DISC_INTERFACE failDisc = {
+	DEVICE_TYPE_RAMDISC,
+	FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE,
+	_fail_startup,
+	_fail_isInserted,
+	_fail_readSectors,
+	_fail_writeSectors,
+	_fail_clearStatus,
+	_fail_shutdown
+};
+
+static void fill (u8* data, sec_t sector, sec_t numSectors, int seed) {
+	u32 i;
+
+	for (i = 0; i < numSectors * SECTOR_SIZE; i++) {
+		data[i] = (u8)(sector * 7 + i * 13 + seed);
+	}
+}
+
+//---------------------------------------------------------------------------------
+// reads a sector through the wrapper and checks it against the disc
+//---------------------------------------------------------------------------------
+static bool readMatches (const DISC_INTERFACE* disc, sec_t sector)
+//---------------------------------------------------------------------------------
+{
+	return disc->readSectors (sector, 1, buffer) && memcmp (buffer, image + sector * SECTOR_SIZE, SECTOR_SIZE) == 0;
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	DISC_READAHEAD_STATS stats;
+	const DISC_INTERFACE* disc;
+	int i;
+
+	fill (image, 0, SECTORS, 0);
+
+	ram = discRamInit (image, SECTORS, true);
+	CHECK(ram != NULL);
+	disc = discReadaheadInit (&failDisc, 32);
+	CHECK(disc != NULL);
+	CHECK(disc->ioType == DEVICE_TYPE_RAMDISC);
+	CHECK(disc->features == failDisc.features);
+	CHECK(disc->startup());
+
+	// sequential single sectors are fetched 8, 16 then 32 at a time
+	for (i = 0; i < 32; i++) {
+		CHECK(readMatches (disc, i));
+	}
+	discReadaheadGetStats (&stats);
+	CHECK(stats.readCommands == 3);
+	CHECK(stats.sectorsPrefetched == 8 + 16 + 32);
+	CHECK(stats.sectorsBuffered == 32);
+	CHECK(stats.sectorsDirect == 0);
+
+	// a read elsewhere goes straight to the disc and ends the run
+	CHECK(readMatches (disc, 60));
+	CHECK(readMatches (disc, 58));
+	discReadaheadGetStats (&stats);
+	CHECK(stats.readCommands == 5);
+	CHECK(stats.sectorsDirect == 2);
+
+	// sectors still buffered are served from the buffer
+	CHECK(readMatches (disc, 30));
+	discReadaheadGetStats (&stats);
+	CHECK(stats.readCommands == 5);
+
+	// a write goes through to the disc and updates the buffered copy
+	fill (buffer, 30, 2, 1);
+	CHECK(disc->writeSectors (30, 2, buffer));
+	CHECK(memcmp (image + 30 * SECTOR_SIZE, buffer, 2 * SECTOR_SIZE) == 0);
+	CHECK(readMatches (disc, 30));
+	CHECK(readMatches (disc, 31));
+	discReadaheadGetStats (&stats);
+	CHECK(stats.readCommands == 5);
+
+	// a failed write, which got only its first sector to the disc, leaves
+	// nothing in the buffer which differs from the disc
+	fill (buffer, 30, 2, 2);
+	failWrites = true;
+	CHECK(!disc->writeSectors (30, 2, buffer));
+	failWrites = false;
+	CHECK(readMatches (disc, 30));
+	CHECK(readMatches (disc, 31));
+
+	discReadaheadFree();
+
+	return failures != 0;
+}
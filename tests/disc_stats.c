@@ -0,0 +1,155 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the statistics wrapper against a RAM disc
+
+	The cascaded timers are plain memory on the host, so the disc below
+	the wrapper moves them on by hand, by a fixed time for each command
+	and each sector, and the latencies measured are known exactly.
+
+---------------------------------------------------------------------------------*/
+#include <disc_stats.h>
+#include <disc_virtual.h>
+#include <gba_timers.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gbahost.h"
+
+#define SECTOR_SIZE	512
+#define SECTORS		64
+#define TIMER		1
+#define COMMAND		50			// ticks for each command
+#define PER_SECTOR	100			// and for each sector moved
+
+static u8 image[SECTORS * SECTOR_SIZE];
+static u8 buffer[16 * SECTOR_SIZE];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+// a RAM disc which takes time
+//---------------------------------------------------------------------------------
+static const DISC_INTERFACE* ram;
+
+static void _slow_wait (u32 ticks) {
+	u32 count = timerReadCascaded (TIMER) + ticks;
+
+	REG_TMCNT_L(TIMER) = count;
+	REG_TMCNT_L(TIMER + 1) = count >> 16;
+}
+
+static bool _slow_startup (void) { _slow_wait (COMMAND); return ram->startup(); }
+static bool _slow_isInserted (void) { return ram->isInserted(); }
+static bool _slow_clearStatus (void) { return ram->clearStatus(); }
+static bool _slow_shutdown (void) { return ram->shutdown(); }
+
+static bool _slow_readSectors (sec_t sector, sec_t numSectors, void* buffer) {
+	_slow_wait (COMMAND + numSectors * PER_SECTOR);
+	return ram->readSectors (sector, numSectors, buffer);
+}
+
+static bool _slow_writeSectors (sec_t sector, sec_t numSectors, const void* buffer) {
+	_slow_wait (COMMAND + numSectors * PER_SECTOR);
+	return ram->writeSectors (sector, numSectors, buffer);
+}
+
+static const DISC_INTERFACE slowDisc = {
+	DEVICE_TYPE_RAMDISC,
+	FEATURE_MEDIUM_CANREAD | FEATURE_MEDIUM_CANWRITE,
+	_slow_startup,
+	_slow_isInserted,
+	_slow_readSectors,
+	_slow_writeSectors,
+	_slow_clearStatus,
+	_slow_shutdown
+};
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	DISC_TRACE_ENTRY trace[4];
+	DISC_STATS stats;
+	const DISC_INTERFACE* disc;
+	u32 start;
+	int i;
+
+	if (!gbaHostMap ()) {
+		printf ("can't set up the GBA memory\n");
+		return 1;
+	}
+
+	CHECK(discStatsInit (NULL, TIMER) == NULL);
+	CHECK(discStatsInit (&slowDisc, 3) == NULL);
+
+	ram = discRamInit (image, SECTORS, true);
+	CHECK(ram != NULL);
+
+	// the wrapper passes on the wrapped disc's type and features, and
+	// starts the low timer with the high one counting its overflows
+	disc = discStatsInit (&slowDisc, TIMER);
+	CHECK(disc != NULL);
+	CHECK(disc->ioType == DEVICE_TYPE_RAMDISC);
+	CHECK(disc->features == slowDisc.features);
+	CHECK(REG_TMCNT_H(TIMER) == (TIMER_START | TIMER_FREQ_64));
+	CHECK(REG_TMCNT_H(TIMER + 1) == (TIMER_START | TIMER_COUNT));
+	CHECK(disc->startup());
+
+	// reads and writes counted, by size, with their latencies; the low
+	// timer overflows part way through
+	REG_TMCNT_L(TIMER) = 0xff00;
+	discStatsReset();
+	CHECK(disc->readSectors (0, 1, buffer));
+	CHECK(disc->readSectors (1, 3, buffer));
+	CHECK(disc->readSectors (8, 16, buffer));
+	CHECK(disc->writeSectors (4, 2, buffer));
+	CHECK(!disc->readSectors (SECTORS - 1, 2, buffer));
+	CHECK(!disc->writeSectors (SECTORS, 1, buffer));
+	discStatsGet (&stats);
+	CHECK(stats.reads == 4);
+	CHECK(stats.writes == 2);
+	CHECK(stats.readErrors == 1);
+	CHECK(stats.writeErrors == 1);
+	CHECK(stats.sectorsRead == 1 + 3 + 16);
+	CHECK(stats.sectorsWritten == 2);
+	CHECK(stats.readBatches[0] == 1 && stats.readBatches[1] == 2 && stats.readBatches[4] == 1);
+	CHECK(stats.writeBatches[0] == 1 && stats.writeBatches[1] == 1);
+	CHECK(stats.readTicks == 4 * COMMAND + (1 + 3 + 16 + 2) * PER_SECTOR);
+	CHECK(stats.maxReadTicks == COMMAND + 16 * PER_SECTOR);
+	CHECK(stats.writeTicks == 2 * COMMAND + 3 * PER_SECTOR);
+	CHECK(stats.maxWriteTicks == COMMAND + 2 * PER_SECTOR);
+
+	// the trace keeps the newest calls once the ring is full
+	start = timerReadCascaded (TIMER);
+	discStatsTraceStart (trace, 4);
+	for (i = 0; i < 5; i++) CHECK(disc->readSectors (i, 1, buffer));
+	CHECK(disc->clearStatus());
+	CHECK(discStatsTraceStop() == 6);
+	CHECK(trace[0].op == DISC_TRACE_READ && trace[0].sector == 4);
+	CHECK(trace[0].time == start + 4 * (COMMAND + PER_SECTOR));
+	CHECK(trace[0].ticks == COMMAND + PER_SECTOR);
+	CHECK(trace[0].numSectors == 1 && trace[0].result == 1);
+	CHECK(trace[1].op == DISC_TRACE_CLEARSTATUS && trace[1].ticks == 0);
+	CHECK(trace[2].sector == 2 && trace[3].sector == 3);
+	CHECK(disc->readSectors (0, 1, buffer));
+	CHECK(trace[2].sector == 2);
+
+	// stopped, the timers are released and nothing is timed
+	discStatsStop();
+	CHECK(REG_TMCNT_H(TIMER) == 0);
+	CHECK(REG_TMCNT_H(TIMER + 1) == 0);
+	discStatsReset();
+	CHECK(disc->readSectors (0, 2, buffer));
+	discStatsGet (&stats);
+	CHECK(stats.reads == 1 && stats.sectorsRead == 2);
+	CHECK(stats.readTicks == 0);
+
+	// and not started at all without a timer
+	disc = discStatsInit (&slowDisc, -1);
+	CHECK(disc != NULL);
+	CHECK(REG_TMCNT_H(TIMER) == 0);
+
+	return failures != 0;
+}
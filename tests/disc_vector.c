@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the vectored transfers of disc.c through the generic
+	path, with sectors split across segments at odd halfwords
+
+---------------------------------------------------------------------------------*/
+#include <disc.h>
+#include <disc_virtual.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "io_cf_common.h"
+#include "io_scsd.h"
+#include "io_m3sd.h"
+
+#define SECTOR_SIZE	512
+#define SECTORS		10
+#define SIZE		(SECTORS * SECTOR_SIZE)
+
+// the built in drivers disc.c knows, none of which the RAM disc is
+const DISC_INTERFACE _io_mpcf, _io_m3cf, _io_sccf, _io_scsd, _io_m3sd;
+bool _CF_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments) { return false; }
+bool _SCSD_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments) { return false; }
+bool _M3SD_readSectorsV (u32 sector, const DISC_SEGMENT* segments, int numSegments) { return false; }
+bool _SCSD_probe (void) { return false; }
+bool _M3SD_probe (void) { return false; }
+
+static u8 image[SIZE];
+static u8 data[SIZE];
+static u16 target[SIZE / 2 + 64];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+// splits the target into segments of the given lengths, each one a
+// halfword past the end of the last so no two are contiguous
+//---------------------------------------------------------------------------------
+static int segments (DISC_SEGMENT* list, const u32* lengths, int count)
+//---------------------------------------------------------------------------------
+{
+	u8* p = (u8*)target + 2;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		list[i].buffer = p;
+		list[i].length = lengths[i];
+		p += lengths[i] + 2;
+	}
+
+	return count;
+}
+
+//---------------------------------------------------------------------------------
+// the data of the segments back to back
+//---------------------------------------------------------------------------------
+static void gather (u8* out, const DISC_SEGMENT* list, int count)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		memcpy (out, list[i].buffer, list[i].length);
+		out += list[i].length;
+	}
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	// whole sectors, sectors split at odd halfwords, one sector in many
+	// pieces and a run spanning a segment boundary
+	static const u32 lengths[] = { 1024, 2, 510, 6, 300, 206, 1022, 2, 2, 2, 508, 512, 2 * 512 - 2, 2 };
+	DISC_SEGMENT list[16];
+	const DISC_INTERFACE* disc;
+	int count, i;
+
+	for (i = 0; i < SIZE; i++) image[i] = i * 7 + (i >> 9);
+
+	disc = discRamInit (image, SECTORS, true);
+	CHECK (disc != NULL && disc->startup ());
+
+	count = segments (list, lengths, sizeof(lengths) / sizeof(lengths[0]));
+
+	// reads
+	memset (target, 0xff, sizeof(target));
+	CHECK (discReadSectorsV (disc, 0, list, count));
+	gather (data, list, count);
+	CHECK (memcmp (data, image, SIZE) == 0);
+
+	// the gaps between the segments are untouched
+	for (i = 0; i < count; i++) {
+		CHECK (((u16*)list[i].buffer)[-1] == 0xffff);
+	}
+
+	// writes
+	for (i = 0; i < count; i++) memset (list[i].buffer, i + 1, list[i].length);
+	gather (data, list, count);
+	CHECK (discWriteSectorsV (disc, 0, list, count));
+	CHECK (memcmp (data, image, SIZE) == 0);
+
+	// odd lengths or addresses, and part sectors, are refused
+	list[0].length = 3;
+	CHECK (!discReadSectorsV (disc, 0, list, 2));
+	list[0].buffer = (u8*)target + 1;
+	list[0].length = 512;
+	CHECK (!discReadSectorsV (disc, 0, list, 1));
+	CHECK (!discWriteSectorsV (disc, 0, list, 1));
+	list[0].buffer = target;
+	list[0].length = 510;
+	CHECK (!discReadSectorsV (disc, 0, list, 1));
+
+	return failures != 0;
+}
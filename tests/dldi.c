@@ -0,0 +1,187 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of DLDI relocation and patching, with the bounds checks
+
+---------------------------------------------------------------------------------*/
+#include <dldi.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DRIVER_BASE	0xBF800000
+#define DRIVER_DATA	0x200
+#define STUB_OFFSET	0x400
+#define STUB_BASE	(0x08000000 + STUB_OFFSET)
+#define IMAGE_SIZE	0x1000
+
+// word indices of the header fields
+#define W_START		16
+#define W_END		17
+#define W_GLUE		18
+#define W_GOT		20
+#define W_BSS		22
+#define W_STARTUP	26
+
+static u32 driver[0x100];
+static u32 image[IMAGE_SIZE / 4];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+static void header (u32* words, u32 base, u32 dataSize, u8 driverSize, u8 fix, u8 allocated)
+//---------------------------------------------------------------------------------
+{
+	u8* bytes = (u8*)words;
+	int i;
+
+	memset (words, 0, DLDI_HEADER_SIZE);
+	words[0] = 0xBF8DA5ED;
+	memcpy (bytes + 4, " Chishm", 8);
+	bytes[12] = 1;
+	bytes[13] = driverSize;
+	bytes[14] = fix;
+	bytes[15] = allocated;
+	strcpy ((char*)bytes + 16, "Test driver");
+
+	words[W_START] = base;
+	words[W_END] = base + dataSize;
+	for (i = W_GLUE; i <= W_BSS + 1; i++) {
+		words[i] = base + dataSize;
+	}
+	// six function pointers into the code
+	for (i = 0; i < 6; i++) {
+		words[W_STARTUP + i] = base + DLDI_HEADER_SIZE + 4 * i;
+	}
+}
+
+//---------------------------------------------------------------------------------
+static void makeDriver (u8 fix)
+//---------------------------------------------------------------------------------
+{
+	u32 i;
+
+	header (driver, DRIVER_BASE, DRIVER_DATA, 10, fix, 10);
+
+	// glue 0x100-0x120, GOT 0x140-0x160, BSS 0x200-0x300 past the data
+	driver[W_GLUE] = DRIVER_BASE + 0x100;
+	driver[W_GLUE + 1] = DRIVER_BASE + 0x120;
+	driver[W_GOT] = DRIVER_BASE + 0x140;
+	driver[W_GOT + 1] = DRIVER_BASE + 0x160;
+	driver[W_BSS] = DRIVER_BASE + 0x200;
+	driver[W_BSS + 1] = DRIVER_BASE + 0x300;
+
+	// the body is all pointers into the driver, except every fourth word
+	for (i = DLDI_HEADER_SIZE / 4; i < DRIVER_DATA / 4; i++) {
+		driver[i] = (i & 3) ? DRIVER_BASE + i * 4 : 0x08000000 + i;
+	}
+	// the ends of the range are left alone
+	driver[0x30] = DRIVER_BASE - 4;
+	driver[0x31] = DRIVER_BASE + DRIVER_DATA;
+}
+
+//---------------------------------------------------------------------------------
+static void makeImage (u8 allocated)
+//---------------------------------------------------------------------------------
+{
+	u32 i;
+
+	for (i = 0; i < IMAGE_SIZE / 4; i++) {
+		image[i] = 0xEEEEEEEE;
+	}
+	header (image + STUB_OFFSET / 4, STUB_BASE, 1u << allocated, allocated, 0, allocated);
+}
+
+//---------------------------------------------------------------------------------
+static bool relocated (u32 index, u8 fix)
+//---------------------------------------------------------------------------------
+{
+	u32 offset = index * 4;
+
+	if (fix & FIX_ALL) return offset >= DLDI_HEADER_SIZE;
+	if ((fix & FIX_GLUE) && offset >= 0x100 && offset < 0x120) return true;
+	if ((fix & FIX_GOT) && offset >= 0x140 && offset < 0x160) return true;
+	return false;
+}
+
+//---------------------------------------------------------------------------------
+static void checkPatched (u8 fix)
+//---------------------------------------------------------------------------------
+{
+	u32* stub = image + STUB_OFFSET / 4;
+	u32 delta = STUB_BASE - DRIVER_BASE;
+	u32 i, expect;
+	int j;
+
+	makeDriver (fix);
+	makeImage (11);
+	CHECK(dldiPatchImage ((u8*)image, IMAGE_SIZE, (DLDI_INTERFACE*)driver, DRIVER_DATA));
+
+	// the header points at the new location and keeps the stub's allocation
+	CHECK(stub[W_START] == STUB_BASE);
+	CHECK(stub[W_END] == STUB_BASE + DRIVER_DATA);
+	CHECK(stub[W_BSS] == STUB_BASE + 0x200);
+	CHECK(stub[W_BSS + 1] == STUB_BASE + 0x300);
+	CHECK(((u8*)stub)[15] == 11);
+	for (j = 0; j < 6; j++) {
+		CHECK(stub[W_STARTUP + j] == STUB_BASE + DLDI_HEADER_SIZE + 4 * j);
+	}
+
+	// the body is relocated where the fix flags say
+	for (i = DLDI_HEADER_SIZE / 4; i < DRIVER_DATA / 4; i++) {
+		expect = driver[i];
+		if (relocated (i, fix) && expect - DRIVER_BASE < DRIVER_DATA) {
+			expect += delta;
+		}
+		CHECK(stub[i] == expect);
+	}
+
+	// the BSS is cleared and nothing past the driver is touched
+	for (i = 0x200 / 4; i < 0x300 / 4; i++) {
+		CHECK(stub[i] == 0);
+	}
+	CHECK(image[STUB_OFFSET / 4 - 1] == 0xEEEEEEEE);
+	CHECK(image[(STUB_OFFSET + 0x800) / 4] == 0xEEEEEEEE);
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	checkPatched (FIX_ALL | FIX_BSS);
+	checkPatched (FIX_GLUE | FIX_BSS);
+	checkPatched (FIX_GOT | FIX_BSS);
+	checkPatched (FIX_GLUE | FIX_GOT | FIX_BSS);
+
+	// a driver is needed whole, word aligned, with its sections in range
+	makeDriver (FIX_ALL);
+	CHECK(dldiValidate ((DLDI_INTERFACE*)driver, DRIVER_DATA));
+	CHECK(dldiGetSize ((DLDI_INTERFACE*)driver) == 0x300);
+	CHECK(!dldiValidate ((DLDI_INTERFACE*)driver, DRIVER_DATA - 4));
+	CHECK(!dldiValidate ((DLDI_INTERFACE*)((u8*)driver + 2), DRIVER_DATA));
+	driver[W_GOT + 1] = DRIVER_BASE + DRIVER_DATA + 4;
+	CHECK(!dldiValidate ((DLDI_INTERFACE*)driver, DRIVER_DATA));
+	makeDriver (FIX_ALL);
+	driver[W_END] = DRIVER_BASE + 0x40;
+	CHECK(!dldiValidate ((DLDI_INTERFACE*)driver, DRIVER_DATA));
+	makeDriver (FIX_ALL);
+	((u8*)driver)[13] = 9;		// 512 bytes is too small with the BSS
+	CHECK(!dldiValidate ((DLDI_INTERFACE*)driver, DRIVER_DATA));
+	makeDriver (FIX_ALL);
+	driver[0] ^= 1;
+	CHECK(!dldiValidate ((DLDI_INTERFACE*)driver, DRIVER_DATA));
+
+	// the stub has to be there and have room for the driver and its BSS
+	makeDriver (FIX_ALL | FIX_BSS);
+	makeImage (9);
+	CHECK(!dldiPatchImage ((u8*)image, IMAGE_SIZE, (DLDI_INTERFACE*)driver, DRIVER_DATA));
+	CHECK(image[STUB_OFFSET / 4 + W_START] == STUB_BASE);
+	makeImage (11);
+	CHECK(!dldiPatchImage ((u8*)image, STUB_OFFSET + 0x200, (DLDI_INTERFACE*)driver, DRIVER_DATA));
+	CHECK(!dldiPatchImage ((u8*)image, STUB_OFFSET + DLDI_HEADER_SIZE - 4, (DLDI_INTERFACE*)driver, DRIVER_DATA));
+	CHECK(!dldiPatchImage ((u8*)image + 2, IMAGE_SIZE - 4, (DLDI_INTERFACE*)driver, DRIVER_DATA));
+	image[STUB_OFFSET / 4 + 1] ^= 0x100;
+	CHECK(!dldiPatchImage ((u8*)image, IMAGE_SIZE, (DLDI_INTERFACE*)driver, DRIVER_DATA));
+
+	return failures != 0;
+}
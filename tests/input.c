@@ -0,0 +1,125 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of keypad recording and replay: a recording has to decode
+	to the keys it was made from, and replay the same keysDown, keysUp and
+	keysDownRepeat, with runs of keys longer than one entry can hold
+
+---------------------------------------------------------------------------------*/
+#include <gba_input.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gbahost.h"
+#include "keys_decode.h"
+
+#define FRAMES	5000
+
+static u16 keys[FRAMES], decoded[FRAMES];
+static u16 held[FRAMES], down[FRAMES], up[FRAMES], downRepeat[FRAMES];
+static u8 recording[4 * FRAMES];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+static u32 nextRandom (void)
+//---------------------------------------------------------------------------------
+{
+	static u32 seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+//---------------------------------------------------------------------------------
+// one frame with keys held on the keypad
+//---------------------------------------------------------------------------------
+static void frame (u16 pressed)
+//---------------------------------------------------------------------------------
+{
+	REG_KEYINPUT = pressed ^ 0x03ff;
+	scanKeys ();
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	// run lengths around the 64 frames one entry holds
+	static const int lengths[] = { 1, 2, 63, 64, 65, 127, 128, 129, 300 };
+	int i, n, run, size, entries = 0, mismatches;
+	u16 pressed = 0;
+
+	if (!gbaHostMap ()) {
+		printf ("can't set up the GBA memory\n");
+		return 1;
+	}
+
+	// runs of random keys, each different from the last
+	for (i = 0; i < FRAMES; i += run) {
+		run = lengths[nextRandom () % 9];
+		if (run > FRAMES - i) run = FRAMES - i;
+
+		pressed ^= 1 + nextRandom () % 0x03ff;
+		for (n = 0; n < run; n++) keys[i + n] = pressed;
+
+		entries += (run + 63) / 64;
+	}
+
+	// record, with the repeat on
+	setRepeat (20, 5);
+	keysRecordStart (recording, sizeof(recording));
+	for (i = 0; i < FRAMES; i++) {
+		frame (keys[i]);
+		held[i] = keysHeld ();
+		down[i] = keysDown ();
+		up[i] = keysUp ();
+		downRepeat[i] = keysDownRepeat ();
+	}
+	CHECK (keysRecording ());
+	size = keysRecordStop ();
+	CHECK (!keysRecording ());
+
+	// an entry for each run, and one more for each 64 frames of it
+	CHECK (size == 2 * entries);
+
+	// decodes to the keys it was made from
+	CHECK (keysDecode (recording, size, NULL, 0) == FRAMES);
+	CHECK (keysDecode (recording, size, decoded, FRAMES) == FRAMES);
+	CHECK (memcmp (decoded, keys, sizeof(keys)) == 0);
+
+	// replays the same, whatever the keypad says
+	keysReplayStart (recording, size);
+	mismatches = 0;
+	for (i = 0; i < FRAMES; i++) {
+		frame (nextRandom () & 0x03ff);
+		mismatches += keysHeld () != held[i];
+		mismatches += keysDown () != down[i];
+		mismatches += keysUp () != up[i];
+		mismatches += keysDownRepeat () != downRepeat[i];
+	}
+	CHECK (mismatches == 0);
+	CHECK (keysReplaying ());
+
+	// then hands back to the keypad
+	frame (KEY_A | KEY_L);
+	CHECK (!keysReplaying ());
+	CHECK (keysHeld () == (KEY_A | KEY_L));
+
+	// a recording which runs out of space stops, keeping what fitted
+	keysRecordStart (recording, 11);
+	for (i = 0; i < FRAMES && keysRecording (); i++) frame (keys[i]);
+	CHECK (!keysRecording ());
+	size = keysRecordStop ();
+	CHECK (size == 10);
+	n = keysDecode (recording, size, decoded, FRAMES);
+	CHECK (n > 0 && n < i);
+	CHECK (memcmp (decoded, keys, n * sizeof(u16)) == 0);
+
+	// an empty recording
+	keysRecordStart (recording, sizeof(recording));
+	CHECK (keysRecordStop () == 0);
+
+	return failures != 0;
+}
@@ -0,0 +1,184 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the M3 SD writes against a card behind mock M3
+	registers, checking the commands and blocks the card is sent
+
+	Reads and writes of the direction, data and status registers all go
+	through m3sdRegister, so a write shows up as a changed value at the
+	next access. Values put there for reads have bit 15 set, which the
+	driver never writes.
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "sd_card.h"
+
+enum { DIR, DAT, STS, REGISTERS };
+
+static vu16 registers[REGISTERS];
+static u16 placed[REGISTERS];
+static vu16 commandRegister, argumentHighRegister, argumentLowRegister;
+
+static vu16* m3sdRegister (int reg);
+
+#define REG_M3SD_DIR	(*m3sdRegister (DIR))
+#define REG_M3SD_DAT	(*m3sdRegister (DAT))
+#define REG_M3SD_CMD	commandRegister
+#define REG_M3SD_ARGH	argumentHighRegister
+#define REG_M3SD_ARGL	argumentLowRegister
+#define REG_M3SD_STS	(*m3sdRegister (STS))
+#include "../src/disc_io/io_m3sd.c"
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+#define SECTORS	8
+#define STATUS	0x45		// command sent, byte sent and data ready
+
+static u8 buffer[SECTORS * 512];
+
+// the M3's side of the card's command and data lines
+static int byteState;			// 1 once a byte is asked for, 2 once it is being received
+static u8 byteLatch;
+static u16 dataOut;
+static int nibbles = -1;		// received in a block, -1 before the start bit
+static u8 block[512 + 8];
+
+//---------------------------------------------------------------------------------
+static void dataClock (int nibble)
+//---------------------------------------------------------------------------------
+{
+	if (nibbles < 0) {
+		if (nibble == 0) nibbles = 0;
+		return;
+	}
+
+	if (nibbles & 1) {
+		block[nibbles >> 1] |= nibble;
+	} else {
+		block[nibbles >> 1] = nibble << 4;
+	}
+
+	if (++nibbles == 2 * sizeof(block)) {
+		nibbles = -1;
+		sdCardBlock (block, block + 512);
+	}
+}
+
+//---------------------------------------------------------------------------------
+static void written (int reg, u16 value)
+//---------------------------------------------------------------------------------
+{
+	switch (reg) {
+	case DIR:
+		if (value == 0x29) sdCardCommand (commandRegister & 0x3f, (argumentHighRegister << 16) | argumentLowRegister);
+		if (value == 0x0c) dataClock (dataOut & 0x0f);
+		if (value == 0x00 && sdCard.busy > 0) sdCard.busy--;
+		break;
+	case DAT:
+		dataOut = value;
+		break;
+	case STS:
+		if (value == 0x02) byteState = 1;
+		break;
+	}
+}
+
+//---------------------------------------------------------------------------------
+static u16 readValue (int reg)
+//---------------------------------------------------------------------------------
+{
+	switch (reg) {
+	case DAT:
+		return byteLatch | ((sdCard.busy == 0) ? 0x100 : 0);
+	case STS:
+		if (byteState == 1) {
+			byteState = 2;
+			return STATUS | 0x08;
+		}
+		if (byteState == 2) {
+			byteState = 0;
+			byteLatch = sdCardResponseByte ();
+		}
+		return STATUS;
+	}
+	return 0;
+}
+
+//---------------------------------------------------------------------------------
+static vu16* m3sdRegister (int reg)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	for (i = 0; i < REGISTERS; i++) {
+		if (registers[i] != placed[i]) {
+			placed[i] = registers[i];
+			written (i, registers[i]);
+		}
+	}
+
+	placed[reg] = 0x8000 | readValue (reg);
+	registers[reg] = placed[reg];
+	return &registers[reg];
+}
+
+//---------------------------------------------------------------------------------
+void _M3_changeMode (u32 mode)
+//---------------------------------------------------------------------------------
+{
+}
+
+//---------------------------------------------------------------------------------
+// a fresh card, started up, with only what follows logged
+//---------------------------------------------------------------------------------
+static void startCard (void)
+//---------------------------------------------------------------------------------
+{
+	sdCardReset ();
+	CHECK (_M3SD_initCard ());
+	sdCard.log[0] = 0;
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	for (i = 0; i < sizeof(buffer); i++) buffer[i] = i * 7 + (i >> 9);
+
+	// pre-erase, the blocks in one stream, stop, then wait out the programming
+	startCard ();
+	CHECK (_M3SD_writeSectors (5, 3, buffer));
+	CHECK (strcmp (sdCard.log, "55:12340000 23:3 25:a00 D D D 12:0 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (sdCard.eraseCount == 3);
+	CHECK (memcmp (sdCard.data[5], buffer, 3 * 512) == 0);
+
+	// a block the card stays busy after ends the stream there, still
+	// stopped and waited for
+	startCard ();
+	sdCard.failBlock = 2;
+	CHECK (!_M3SD_writeSectors (10, 4, buffer));
+	CHECK (strcmp (sdCard.log, "55:12340000 23:4 25:1400 D D X 12:0 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (memcmp (sdCard.data[10], buffer, 2 * 512) == 0);
+
+	// a card without APP_CMD still gets the blocks, without the pre-erase
+	startCard ();
+	sdCard.noAppCmd = true;
+	CHECK (_M3SD_writeSectors (0, 2, buffer + 512));
+	CHECK (strcmp (sdCard.log, "55:12340000 25:0 D D 12:0 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (memcmp (sdCard.data[0], buffer + 512, 2 * 512) == 0);
+
+	// one sector is a plain WRITE_BLOCK
+	startCard ();
+	CHECK (_M3SD_writeSectors (7, 1, buffer));
+	CHECK (strcmp (sdCard.log, "24:e00 D 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (memcmp (sdCard.data[7], buffer, 512) == 0);
+
+	if (failures) printf ("log: %s\n", sdCard.log);
+
+	return failures != 0;
+}
@@ -0,0 +1,201 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the mixing kernel against a plain one sample at a time
+	mix, which has to match it exactly, voice state included, and of the
+	longest samples mixerPlay takes
+
+---------------------------------------------------------------------------------*/
+#include <gba_mixer.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gbahost.h"
+
+#define SAMPLE_LENGTH	5000
+
+static s8 samples[MIXER_MAX_VOICES][SAMPLE_LENGTH];
+static s8 longest[MIXER_MAX_LENGTH];
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+static u32 nextRandom (void)
+//---------------------------------------------------------------------------------
+{
+	static u32 seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+//---------------------------------------------------------------------------------
+static void reference (MixerVoice* voices, int numVoices, s8* left, s8* right, int count)
+//---------------------------------------------------------------------------------
+{
+	MixerVoice* v;
+	s32 l, r, s;
+	int i;
+
+	while (count--) {
+		l = r = 0;
+
+		for (i = 0; i < numVoices; i++) {
+			v = &voices[i];
+			if (!v->data) continue;
+
+			s = v->data[v->position >> MIXER_FRACTION_BITS];
+			l += s * v->leftVolume;
+			r += s * v->rightVolume;
+
+			v->position += v->step;
+			if (v->position >= v->end) {
+				if (!v->loopLength) {
+					v->data = NULL;
+				} else {
+					while (v->position >= v->end) v->position -= v->loopLength;
+				}
+			}
+		}
+
+		l >>= 8;
+		r >>= 8;
+		*left++ = (l > 127) ? 127 : (l < -128) ? -128 : l;
+		*right++ = (r > 127) ? 127 : (r < -128) ? -128 : r;
+	}
+}
+
+//---------------------------------------------------------------------------------
+static void randomVoice (MixerVoice* v, int i)
+//---------------------------------------------------------------------------------
+{
+	u32 length = 1 + nextRandom () % SAMPLE_LENGTH;
+
+	v->data = (nextRandom () % 5) ? samples[i] : NULL;
+	v->position = 0;
+	v->end = length << MIXER_FRACTION_BITS;
+
+	// fractional steps, with some whole ones and some standing still
+	v->step = (nextRandom () % 3) ? nextRandom () % 20000 : (nextRandom () % 4) << MIXER_FRACTION_BITS;
+	v->loopLength = (nextRandom () % 2) ? (1 + nextRandom () % length) << MIXER_FRACTION_BITS : 0;
+	v->leftVolume = nextRandom () % (MIXER_VOLUME_MAX + 1);
+	v->rightVolume = nextRandom () % (MIXER_VOLUME_MAX + 1);
+}
+
+//---------------------------------------------------------------------------------
+// mixes both ways for some frames, returns the number of mismatches
+//---------------------------------------------------------------------------------
+static int compare (MixerVoice* voices, int numVoices, int frames)
+//---------------------------------------------------------------------------------
+{
+	static const int rates[] = { MIXER_RATE_5734, MIXER_RATE_18157, MIXER_RATE_31536, MIXER_RATE_42048 };
+	MixerVoice expected[MIXER_MAX_VOICES];
+	s8 left[MIXER_MAX_SAMPLES], right[MIXER_MAX_SAMPLES];
+	s8 expectedLeft[MIXER_MAX_SAMPLES], expectedRight[MIXER_MAX_SAMPLES];
+	int count, i, mismatches = 0;
+
+	memcpy (expected, voices, sizeof(MixerVoice) * numVoices);
+
+	while (frames--) {
+		count = rates[nextRandom () % 4];
+
+		mixerMixVoices (voices, numVoices, left, right, count);
+		reference (expected, numVoices, expectedLeft, expectedRight, count);
+
+		mismatches += memcmp (left, expectedLeft, count) != 0;
+		mismatches += memcmp (right, expectedRight, count) != 0;
+
+		for (i = 0; i < numVoices; i++) {
+			mismatches += voices[i].data != expected[i].data;
+			mismatches += voices[i].data && voices[i].position != expected[i].position;
+		}
+	}
+
+	return mismatches;
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	MixerVoice voices[MIXER_MAX_VOICES];
+	s8 left[MIXER_CHUNK * 3], right[MIXER_CHUNK * 3];
+	int trial, i, j, numVoices;
+
+	for (i = 0; i < MIXER_MAX_VOICES; i++) {
+		for (j = 0; j < SAMPLE_LENGTH; j++) samples[i][j] = nextRandom ();
+	}
+
+	for (trial = 0; trial < 2000; trial++) {
+		numVoices = 1 + nextRandom () % MIXER_MAX_VOICES;
+		for (i = 0; i < numVoices; i++) randomVoice (&voices[i], i);
+
+		CHECK (compare (voices, numVoices, 20) == 0);
+	}
+
+	// a one shot sample ending part way through a chunk
+	memset (voices, 0, sizeof(voices));
+	voices[0].data = samples[0];
+	voices[0].step = 1 << MIXER_FRACTION_BITS;
+	voices[0].end = 100 << MIXER_FRACTION_BITS;
+	voices[0].leftVolume = MIXER_VOLUME_MAX;
+	voices[0].rightVolume = 0;
+
+	mixerMixVoices (voices, 1, left, right, MIXER_CHUNK * 3);
+	CHECK (voices[0].data == NULL);
+	CHECK (memcmp (left, samples[0], 100) == 0);
+	for (i = 0; i < MIXER_CHUNK * 3; i++) {
+		CHECK (right[i] == 0);
+		if (i >= 100) CHECK (left[i] == 0);
+	}
+
+	// eight voices at full volume clip
+	for (i = 0; i < MIXER_MAX_VOICES; i++) {
+		voices[i].data = (const s8*)"\x7f\x80";
+		voices[i].position = 0;
+		voices[i].step = 1 << MIXER_FRACTION_BITS;
+		voices[i].end = 2 << MIXER_FRACTION_BITS;
+		voices[i].loopLength = 2 << MIXER_FRACTION_BITS;
+		voices[i].leftVolume = voices[i].rightVolume = MIXER_VOLUME_MAX;
+	}
+
+	mixerMixVoices (voices, MIXER_MAX_VOICES, left, right, 4);
+	CHECK (left[0] == 127 && left[1] == -128 && left[2] == 127 && left[3] == -128);
+	CHECK (right[0] == 127 && right[1] == -128);
+
+	// a voice at the end of the longest sample can take the largest step
+	// without its position wrapping around
+	voices[0].data = longest;
+	voices[0].end = MIXER_MAX_LENGTH << MIXER_FRACTION_BITS;
+	voices[0].position = voices[0].end - 1;
+	voices[0].step = (256 << MIXER_FRACTION_BITS) - 1;
+	voices[0].loopLength = 0;
+	mixerMixVoices (voices, 1, left, right, 2);
+	CHECK (voices[0].data == NULL);
+
+	if (!gbaHostMap ()) {
+		printf ("can't set up the GBA memory\n");
+		return 1;
+	}
+	CHECK (mixerInit (MIXER_RATE_18157, 1, MIXER_REFILL_VBLANK));
+
+	// samples whose end doesn't fit in a position are refused
+	mixerPlay (0, longest, MIXER_MAX_LENGTH + 1, 0, 18157);
+	CHECK (!mixerVoiceActive (0));
+	mixerPlay (0, longest, 1 << 20, 0, 18157);
+	CHECK (!mixerVoiceActive (0));
+	mixerPlay (0, longest, 0xffffffff, 0, 18157);
+	CHECK (!mixerVoiceActive (0));
+
+	// the longest plays to its end, at four times the mixer rate
+	mixerPlay (0, longest, MIXER_MAX_LENGTH, 0, 4 * 18157);
+	CHECK (mixerVoiceActive (0));
+	for (i = 0; i < MIXER_MAX_LENGTH / MIXER_RATE_18157 && mixerVoiceActive (0); i++) mixerUpdate ();
+	CHECK (!mixerVoiceActive (0));
+	CHECK (i > MIXER_MAX_LENGTH / (5 * MIXER_RATE_18157) && i <= MIXER_MAX_LENGTH / (3 * MIXER_RATE_18157));
+
+	mixerStop ();
+
+	return failures != 0;
+}
@@ -0,0 +1,196 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the pitch conversion against freq * 2^((pitch - 46080) / 3072)
+	truncated, the power function GBATEK gives for MidiKey2Freq
+
+	The table holds that function worked out exactly, not values read back
+	from the BIOS; rows of { freq, pitch, SWI 31 result } captured from
+	hardware can be added to it as they are
+
+---------------------------------------------------------------------------------*/
+#include <gba_sound.h>
+#include <math.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+static const struct {
+	u32 freq;
+	u16 pitch;
+	u32 result;
+} expected[] = {
+	{ 0x00d10c00, 0x3c80, 13771u },
+	{ 0x00000001, 0x0000, 0u },
+	{ 0x00000001, 0x0001, 0u },
+	{ 0x00000001, 0x00ff, 0u },
+	{ 0x00000001, 0x3c00, 0u },
+	{ 0x00000001, 0x4511, 0u },
+	{ 0x00000001, 0x9c00, 0u },
+	{ 0x00000001, 0xa800, 0u },
+	{ 0x00000001, 0xb307, 0u },
+	{ 0x00000001, 0xb2ff, 0u },
+	{ 0x00000001, 0xffff, 0u },
+	{ 0x007d0000, 0x0000, 250u },
+	{ 0x007d0000, 0x0001, 250u },
+	{ 0x007d0000, 0x00ff, 264u },
+	{ 0x007d0000, 0x3c00, 8000u },
+	{ 0x007d0000, 0x4511, 13506u },
+	{ 0x007d0000, 0x9c00, 2048000u },
+	{ 0x007d0000, 0xa800, 4096000u },
+	{ 0x007d0000, 0xb307, 7730473u },
+	{ 0x007d0000, 0xb2ff, 7730473u },
+	{ 0x007d0000, 0xffff, 7730473u },
+	{ 0x01588800, 0x0000, 689u },
+	{ 0x01588800, 0x0001, 689u },
+	{ 0x01588800, 0x00ff, 729u },
+	{ 0x01588800, 0x3c00, 22050u },
+	{ 0x01588800, 0x4511, 37226u },
+	{ 0x01588800, 0x9c00, 5644800u },
+	{ 0x01588800, 0xa800, 11289600u },
+	{ 0x01588800, 0xb307, 21307118u },
+	{ 0x01588800, 0xb2ff, 21307118u },
+	{ 0x01588800, 0xffff, 21307118u },
+	{ 0x02b11000, 0x0000, 1378u },
+	{ 0x02b11000, 0x0001, 1378u },
+	{ 0x02b11000, 0x00ff, 1459u },
+	{ 0x02b11000, 0x3c00, 44100u },
+	{ 0x02b11000, 0x4511, 74452u },
+	{ 0x02b11000, 0x9c00, 11289600u },
+	{ 0x02b11000, 0xa800, 22579200u },
+	{ 0x02b11000, 0xb307, 42614237u },
+	{ 0x02b11000, 0xb2ff, 42614237u },
+	{ 0x02b11000, 0xffff, 42614237u },
+	{ 0x7fffffff, 0x0000, 65535u },
+	{ 0x7fffffff, 0x0001, 65550u },
+	{ 0x7fffffff, 0x00ff, 69417u },
+	{ 0x7fffffff, 0x3c00, 2097151u },
+	{ 0x7fffffff, 0x4511, 3540529u },
+	{ 0x7fffffff, 0x9c00, 536870911u },
+	{ 0x7fffffff, 0xa800, 1073741823u },
+	{ 0x7fffffff, 0xb307, 2026497353u },
+	{ 0x7fffffff, 0xb2ff, 2026497353u },
+	{ 0x7fffffff, 0xffff, 2026497353u },
+	{ 0xffffffff, 0x0000, 131071u },
+	{ 0xffffffff, 0x0001, 131101u },
+	{ 0xffffffff, 0x00ff, 138834u },
+	{ 0xffffffff, 0x3c00, 4194303u },
+	{ 0xffffffff, 0x4511, 7081059u },
+	{ 0xffffffff, 0x9c00, 1073741823u },
+	{ 0xffffffff, 0xa800, 2147483647u },
+	{ 0xffffffff, 0xb307, 4052994707u },
+	{ 0xffffffff, 0xb2ff, 4052994707u },
+	{ 0xffffffff, 0xffff, 4052994707u },
+	{ 0x9f767c45, 0x82c9, 155877712u },
+	{ 0xbde5c099, 0xb791, 3006458755u },
+	{ 0xcb91ce37, 0x0ed9, 245724u },
+	{ 0xd7210dff, 0xee66, 3405926500u },
+	{ 0xc6a53877, 0x7f83, 160725999u },
+	{ 0xa6233255, 0x1a8c, 394174u },
+	{ 0xe6a16a3b, 0x504e, 12209467u },
+	{ 0x1cfb10f6, 0xbe5b, 458823185u },
+	{ 0x7814e8a2, 0x7e3e, 90289474u },
+	{ 0x617959ce, 0x3435, 1018159u },
+	{ 0x92edcf45, 0x7fa8, 119878329u },
+	{ 0x035b7399, 0x6ef7, 1044472u },
+	{ 0x687c966c, 0x8f18, 207948964u },
+	{ 0x2e9c82b1, 0xc764, 737951690u },
+	{ 0x28dbd25e, 0x24d4, 175557u },
+	{ 0x238642ea, 0xe3c1, 562423603u },
+	{ 0x206f5c66, 0x43b5, 829413u },
+	{ 0x00745130, 0x02b8, 272u },
+	{ 0x359eeefb, 0x6e53, 16076016u },
+	{ 0xf5cae3bf, 0x54eb, 16985433u },
+	{ 0xdf561d80, 0x553d, 15721816u },
+	{ 0x4a0fe75d, 0xa096, 404853716u },
+	{ 0xf6236bf2, 0x65d4, 45174422u },
+	{ 0x8a0a8c96, 0x68d8, 30155845u },
+	{ 0x2e81d66d, 0x64cd, 8043804u },
+	{ 0xf770c226, 0xc435, 3917480019u },
+	{ 0x4c7d6df0, 0x0b0b, 74113u },
+	{ 0x5c76f18a, 0xd46e, 1463900891u },
+	{ 0x2a7c1880, 0x4a99, 1617511u },
+	{ 0x43892dfc, 0x2159, 237332u },
+	{ 0x54f46a69, 0x9a4b, 322868193u },
+	{ 0xd1412584, 0x01bb, 118400u },
+	{ 0x98921396, 0xad00, 1708401529u },
+	{ 0x10e6d8e6, 0x9eb2, 82833433u },
+	{ 0x5af84e6b, 0x9cb4, 397371138u }
+};
+
+//---------------------------------------------------------------------------------
+// the function in long double, -1 when it is too near a whole number to say
+//---------------------------------------------------------------------------------
+static long long reference (u32 freq, u32 pitch)
+//---------------------------------------------------------------------------------
+{
+	long double value, whole;
+
+	if (pitch > PITCH (178, 255)) pitch = PITCH (178, 255);
+
+	value = freq * exp2l (((long double)pitch - 46080) / 3072);
+	whole = floorl (value);
+
+	if (value - whole < 1e-6L || whole + 1 - value < 1e-6L) return -1;
+	return whole;
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	// sample rates in 22.10 as the m4a driver keeps them, and the extremes
+	static const u32 rates[] = { 0, 1, 8000 << 10, 13379 << 10, 22050 << 10, 44100 << 10, 0x7fffffff, 0xffffffff };
+	u32 freq[256], out[256], seed = 1, pitch32;
+	u16 pitch[256];
+	long long result;
+	WaveData wave;
+	int i, mismatches = 0;
+
+	for (i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+		if (pitchToFreq (expected[i].freq, expected[i].pitch) != expected[i].result) {
+			printf ("%08x %04x: %u, not %u\n", expected[i].freq, expected[i].pitch,
+				pitchToFreq (expected[i].freq, expected[i].pitch), expected[i].result);
+			failures++;
+		}
+	}
+
+	// every pitch
+	for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+		for (pitch32 = 0; pitch32 < 0x10000; pitch32++) {
+			result = reference (rates[i], pitch32);
+			mismatches += result >= 0 && pitchToFreq (rates[i], pitch32) != result;
+		}
+	}
+
+	// random frequencies
+	for (i = 0; i < 1000000; i++) {
+		seed = seed * 1103515245 + 12345;
+		pitch32 = seed >> 16;
+		seed = seed * 1103515245 + 12345;
+		result = reference (seed, pitch32);
+		mismatches += result >= 0 && pitchToFreq (seed, pitch32) != result;
+	}
+
+	CHECK (mismatches == 0);
+
+	// key 168 is an octave below the sample's own rate, 180 would be the rate
+	wave.freq = 22050 << 10;
+	CHECK (pitchMidiKeyToFreq (&wave, 168, 0) == 22050 << 9);
+	CHECK (pitchMidiKeyToFreq (&wave, 156, 0) == 22050 << 8);
+	CHECK (pitchMidiKeyToFreq (&wave, 60, 128) == pitchToFreq (wave.freq, PITCH (60, 128)));
+	CHECK (pitchToFreq (wave.freq, PITCH (255, 0)) == pitchToFreq (wave.freq, PITCH (178, 255)));
+
+	// the batch gives the same as one at a time
+	for (i = 0; i < 256; i++) {
+		freq[i] = rates[i & 7];
+		pitch[i] = i * 0xb5;
+	}
+	pitchToFreqBatch (freq, pitch, out, 256);
+	for (i = 0; i < 256; i++) {
+		CHECK (out[i] == pitchToFreq (freq[i], pitch[i]));
+	}
+
+	return failures != 0;
+}
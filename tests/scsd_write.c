@@ -0,0 +1,117 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the SuperCard SD writes against a card on a mock
+	command register, checking the commands and blocks the card is sent
+
+	Reads and writes of the command register both go through scsdCmd, so
+	a write shows up as a changed value at the next access. Values put
+	there for reads have bit 15 set, which the bit banged writes never do.
+	_SCSD_writeData_s is ARM assembly, so it is replaced here by a hand
+	over of the block to the card.
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "sd_card.h"
+
+static vu16 cmdRegister;
+static u16 cmdPlaced;
+
+static vu16* scsdCmd (void);
+
+static vu16 dataWrite, dataRead, liteEnable, lock;
+static vu32 dataRead32;
+
+#define REG_SCSD_CMD			(*scsdCmd ())
+#define REG_SCSD_DATAWRITE		dataWrite
+#define REG_SCSD_DATAREAD		dataRead
+#define REG_SCSD_DATAREAD_32	dataRead32
+#define REG_SCSD_LITE_ENABLE	liteEnable
+#define REG_SCSD_LOCK			lock
+#include "../src/disc_io/io_scsd.c"
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+#define SECTORS	8
+
+static u8 buffer[SECTORS * 512];
+
+//---------------------------------------------------------------------------------
+static vu16* scsdCmd (void)
+//---------------------------------------------------------------------------------
+{
+	if (cmdRegister != cmdPlaced) {
+		sdCardCommandBit ((cmdRegister >> 7) & 1);
+	}
+
+	cmdPlaced = 0x8000 | sdCardResponseBit ();
+	cmdRegister = cmdPlaced;
+	return &cmdRegister;
+}
+
+//---------------------------------------------------------------------------------
+bool _SCSD_writeData_s (u8 *data, u16* crc)
+//---------------------------------------------------------------------------------
+{
+	return sdCardBlock (data, (u8*)crc);
+}
+
+//---------------------------------------------------------------------------------
+void _SC_changeMode (u8 mode)
+//---------------------------------------------------------------------------------
+{
+}
+
+//---------------------------------------------------------------------------------
+// a fresh card, started up, with only what follows logged
+//---------------------------------------------------------------------------------
+static void startCard (void)
+//---------------------------------------------------------------------------------
+{
+	sdCardReset ();
+	CHECK (_SCSD_initCard ());
+	sdCard.log[0] = 0;
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	for (i = 0; i < sizeof(buffer); i++) buffer[i] = i * 7 + (i >> 9);
+
+	// pre-erase, the blocks in one stream, stop, then wait out the programming
+	startCard ();
+	CHECK (_SCSD_writeSectors (5, 3, buffer));
+	CHECK (strcmp (sdCard.log, "55:12340000 23:3 25:a00 D D D 12:0 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (sdCard.eraseCount == 3);
+	CHECK (memcmp (sdCard.data[5], buffer, 3 * 512) == 0);
+
+	// a refused block ends the stream there, still stopped and waited for
+	startCard ();
+	sdCard.failBlock = 2;
+	CHECK (!_SCSD_writeSectors (10, 4, buffer));
+	CHECK (strcmp (sdCard.log, "55:12340000 23:4 25:1400 D D X 12:0 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (memcmp (sdCard.data[10], buffer, 2 * 512) == 0);
+
+	// a card without APP_CMD still gets the blocks, without the pre-erase
+	startCard ();
+	sdCard.noAppCmd = true;
+	CHECK (_SCSD_writeSectors (0, 2, buffer + 512));
+	CHECK (strcmp (sdCard.log, "55:12340000 25:0 D D 12:0 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (memcmp (sdCard.data[0], buffer + 512, 2 * 512) == 0);
+
+	// one sector is a plain WRITE_BLOCK
+	startCard ();
+	CHECK (_SCSD_writeSectors (7, 1, buffer));
+	CHECK (strcmp (sdCard.log, "24:e00 D 13:12340000 13:12340000 13:12340000 ") == 0);
+	CHECK (memcmp (sdCard.data[7], buffer, 512) == 0);
+
+	if (failures) printf ("log: %s\n", sdCard.log);
+
+	return failures != 0;
+}
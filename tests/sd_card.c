@@ -0,0 +1,234 @@
+/*---------------------------------------------------------------------------------
+
+	An SD card for the host checks of the SD drivers, which answers
+	commands, takes data blocks and logs what it was sent
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "sd_card.h"
+
+SD_CARD sdCard;
+
+static int state, programming;
+static bool appCmd, singleBlock;
+static u32 writeSector, blocks;
+
+static u8 response[20];
+static int responseLength, responseByte, responseBit;
+
+static u8 packet[6];
+static int packetBits;
+
+//---------------------------------------------------------------------------------
+void sdCardReset (void)
+//---------------------------------------------------------------------------------
+{
+	memset (&sdCard, 0, sizeof(sdCard));
+	sdCard.failBlock = -1;
+
+	state = SD_STATE_IDLE;
+	programming = 0;
+	appCmd = false;
+	responseLength = responseByte = responseBit = 0;
+	packetBits = 0;
+}
+
+//---------------------------------------------------------------------------------
+// a 48 bit response, after a byte of the line idling high
+//---------------------------------------------------------------------------------
+static void respond (u8 first, u32 argument)
+//---------------------------------------------------------------------------------
+{
+	response[0] = 0xff;
+	response[1] = first;
+	response[2] = argument >> 24;
+	response[3] = argument >> 16;
+	response[4] = argument >> 8;
+	response[5] = argument;
+	response[6] = _SD_CRC7 (response + 1, 5);
+
+	responseLength = 7;
+	responseByte = responseBit = 0;
+}
+
+//---------------------------------------------------------------------------------
+static void respondR1 (u8 command)
+//---------------------------------------------------------------------------------
+{
+	bool ready = (state == SD_STATE_TRAN);
+
+	respond (command, (state << 9) | (ready << 8) | (appCmd << 5));
+}
+
+//---------------------------------------------------------------------------------
+// a 136 bit CID or CSD
+//---------------------------------------------------------------------------------
+static void respondR2 (void)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	response[0] = 0xff;
+	response[1] = 0x3f;
+	for (i = 2; i < 18; i++) response[i] = i;
+	response[17] = _SD_CRC7 (response + 2, 15);
+
+	responseLength = 18;
+	responseByte = responseBit = 0;
+}
+
+//---------------------------------------------------------------------------------
+void sdCardCommand (u8 command, u32 argument)
+//---------------------------------------------------------------------------------
+{
+	bool app = appCmd;
+
+	sprintf (sdCard.log + strlen (sdCard.log), "%d:%x ", command, argument);
+	responseLength = 0;
+	appCmd = false;
+
+	if (app && command == SD_APP_OP_COND) {
+		respond (0x3f, 0x80000000 | SD_OCR_VALUE);
+		state = SD_STATE_READY;
+		return;
+	}
+
+	if (app && command == SET_WR_BLK_ERASE_COUNT) {
+		sdCard.eraseCount = argument;
+		respondR1 (command);
+		return;
+	}
+
+	switch (command) {
+	case GO_IDLE_STATE:
+		state = SD_STATE_IDLE;
+		break;
+	case APP_CMD:
+		if (!sdCard.noAppCmd) {
+			appCmd = true;
+			respondR1 (command);
+		}
+		break;
+	case ALL_SEND_CID:
+		respondR2 ();
+		state = SD_STATE_IDENT;
+		break;
+	case SEND_RELATIVE_ADDR:
+		respond (command, (SD_CARD_RCA << 16) | (state << 9));
+		state = SD_STATE_STBY;
+		break;
+	case SEND_CSD:
+		respondR2 ();
+		break;
+	case SELECT_CARD:
+		respondR1 (command);
+		state = SD_STATE_TRAN;
+		break;
+	case SEND_STATUS:
+		if (programming > 0 && --programming == 0) {
+			state = SD_STATE_TRAN;
+		}
+		respondR1 (command);
+		break;
+	case WRITE_BLOCK:
+	case WRITE_MULTIPLE_BLOCK:
+		respondR1 (command);
+		state = SD_STATE_RCV;
+		singleBlock = (command == WRITE_BLOCK);
+		writeSector = argument / 512;
+		blocks = 0;
+		break;
+	case STOP_TRANSMISSION:
+		respondR1 (command);
+		if (state == SD_STATE_RCV) {
+			state = SD_STATE_PRG;
+			programming = SD_CARD_PROGRAMMING;
+		}
+		sdCard.busy = 0;
+		break;
+	default:
+		respondR1 (command);
+		break;
+	}
+}
+
+//---------------------------------------------------------------------------------
+void sdCardPacket (const u8* packet)
+//---------------------------------------------------------------------------------
+{
+	if ((packet[0] & 0xc0) != 0x40 || packet[5] != _SD_CRC7 ((u8*)packet, 5)) return;
+
+	sdCardCommand (packet[0] & 0x3f, (packet[1] << 24) | (packet[2] << 16) | (packet[3] << 8) | packet[4]);
+}
+
+//---------------------------------------------------------------------------------
+void sdCardCommandBit (int bit)
+//---------------------------------------------------------------------------------
+{
+	// the line idles high until the start bit
+	if (packetBits == 0 && bit) return;
+
+	packet[packetBits >> 3] = (packet[packetBits >> 3] << 1) | bit;
+	if (++packetBits == 48) {
+		packetBits = 0;
+		sdCardPacket (packet);
+	}
+}
+
+//---------------------------------------------------------------------------------
+int sdCardResponseBit (void)
+//---------------------------------------------------------------------------------
+{
+	int bit;
+
+	if (responseByte >= responseLength) return 1;
+
+	bit = (response[responseByte] >> (7 - responseBit)) & 1;
+	if (++responseBit == 8) {
+		responseBit = 0;
+		responseByte++;
+	}
+	return bit;
+}
+
+//---------------------------------------------------------------------------------
+u8 sdCardResponseByte (void)
+//---------------------------------------------------------------------------------
+{
+	if (responseByte >= responseLength) return 0xff;
+
+	return response[responseByte++];
+}
+
+//---------------------------------------------------------------------------------
+bool sdCardBlock (const u8* data, const u8* crc)
+//---------------------------------------------------------------------------------
+{
+	u8 expected[8];
+	u32 block = blocks++;
+
+	if (state != SD_STATE_RCV || block == sdCard.failBlock || writeSector + block >= SD_CARD_SECTORS) {
+		strcat (sdCard.log, "X ");
+		sdCard.busy = -1;
+		return false;
+	}
+
+	_SD_CRC16 ((u8*)data, 512, expected);
+	if (memcmp (crc, expected, 8) != 0) {
+		strcat (sdCard.log, "X ");
+		return false;
+	}
+
+	memcpy (sdCard.data[writeSector + block], data, 512);
+	strcat (sdCard.log, "D ");
+
+	// programming the block
+	sdCard.busy = 8;
+	if (singleBlock) {
+		state = SD_STATE_PRG;
+		programming = SD_CARD_PROGRAMMING;
+	}
+	return true;
+}
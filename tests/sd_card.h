@@ -0,0 +1,45 @@
+/*---------------------------------------------------------------------------------
+
+	An SD card for the host checks of the SD drivers, which answers
+	commands, takes data blocks and logs what it was sent
+
+---------------------------------------------------------------------------------*/
+#ifndef SD_CARD_H
+#define SD_CARD_H
+
+#include "io_sd_common.h"
+
+#define SD_CARD_RCA			0x1234
+#define SD_CARD_SECTORS		64
+#define SD_CARD_PROGRAMMING	3		// SEND_STATUS polls answered with the programming state
+
+typedef struct {
+	char log[1024];					// "cmd:arg" for each command, D for each block taken, X for one refused
+	u8 data[SD_CARD_SECTORS][512];
+	int failBlock;					// block of a multiple block write to refuse, -1 for none
+	bool noAppCmd;					// APP_CMD goes unanswered
+	int eraseCount;					// from SET_WR_BLK_ERASE_COUNT
+	int busy;						// data line clocks left busy, -1 until STOP_TRANSMISSION
+} SD_CARD;
+
+extern SD_CARD sdCard;
+
+// power on, with nothing logged
+void sdCardReset (void);
+
+// a command, whose response is then read a bit or a byte at a time
+void sdCardCommand (u8 command, u32 argument);
+// a whole command packet, start bit to end bit, ignored if the CRC is wrong
+void sdCardPacket (const u8* packet);
+// the command line a bit at a time, as bit banged
+void sdCardCommandBit (int bit);
+
+// response bits and bytes, 1s when the card has nothing to say
+int sdCardResponseBit (void);
+u8 sdCardResponseByte (void);
+
+// a data block with its CRC16s as sent on the four data lines,
+// false if the card refuses it
+bool sdCardBlock (const u8* data, const u8* crc);
+
+#endif // SD_CARD_H
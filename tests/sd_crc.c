@@ -0,0 +1,158 @@
+/*---------------------------------------------------------------------------------
+
+	Host check of the table driven SD command CRC7 and the word at a time
+	data CRC16 against the bit serial ones they replaced, which are kept
+	here as the references
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+
+#include "io_sd_common.h"
+
+#define SECTOR_SIZE	512
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf ("%s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+
+//---------------------------------------------------------------------------------
+static u32 nextRandom (void)
+//---------------------------------------------------------------------------------
+{
+	static u32 seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+//---------------------------------------------------------------------------------
+// CRC7 with the end bit, a bit at a time
+//---------------------------------------------------------------------------------
+static u8 crc7 (u8* data, int cnt)
+//---------------------------------------------------------------------------------
+{
+	int i, a;
+	u8 crc, temp;
+
+	crc = 0;
+	for (a = 0; a < cnt; a++) {
+		temp = data[a];
+		for (i = 0; i < 8; i++) {
+			crc <<= 1;
+			if ((temp & 0x80) ^ (crc & 0x80)) crc ^= 0x09;
+			temp <<= 1;
+		}
+	}
+	crc = (crc << 1) | 1;
+	return crc;
+}
+
+//---------------------------------------------------------------------------------
+// four CRC16s, one for each data line, a bit at a time
+//---------------------------------------------------------------------------------
+static void crc16 (u8* buff, int buffLength, u8* crc16buff)
+//---------------------------------------------------------------------------------
+{
+	u32 a, b, c, d;
+	int count;
+	u32 bitPattern = 0x80808080;
+	u32 crcConst = 0x1021;
+	u32 dataByte = 0;
+
+	a = 0;
+	b = 0;
+	c = 0;
+	d = 0;
+
+	buffLength = buffLength * 8;
+
+	do {
+		if (bitPattern & 0x80) dataByte = *buff++;
+
+		a = a << 1;
+		if ( a & 0x10000) a ^= crcConst;
+		if (dataByte & (bitPattern >> 24)) a ^= crcConst;
+
+		b = b << 1;
+		if (b & 0x10000) b ^= crcConst;
+		if (dataByte & (bitPattern >> 25)) b ^= crcConst;
+
+		c = c << 1;
+		if (c & 0x10000) c ^= crcConst;
+		if (dataByte & (bitPattern >> 26)) c ^= crcConst;
+
+		d = d << 1;
+		if (d & 0x10000) d ^= crcConst;
+		if (dataByte & (bitPattern >> 27)) d ^= crcConst;
+
+		bitPattern = (bitPattern >> 4) | (bitPattern << 28);
+	} while (buffLength-=4);
+
+	count = 16;
+
+	do {
+		bitPattern = bitPattern << 4;
+		if (a & 0x8000) bitPattern |= 8;
+		if (b & 0x8000) bitPattern |= 4;
+		if (c & 0x8000) bitPattern |= 2;
+		if (d & 0x8000) bitPattern |= 1;
+
+		a = a << 1;
+		b = b << 1;
+		c = c << 1;
+		d = d << 1;
+
+		count--;
+
+		if (!(count & 0x01)) {
+			*crc16buff++ = (u8)(bitPattern & 0xff);
+		}
+	} while (count != 0);
+}
+
+//---------------------------------------------------------------------------------
+int main (void)
+//---------------------------------------------------------------------------------
+{
+	u8 buff[SECTOR_SIZE], crc[8], expected[8];
+	int trial, i, length, mismatches;
+
+	// commands, and longer runs to go through every table entry
+	mismatches = 0;
+	for (trial = 0; trial < 100000; trial++) {
+		length = (trial & 1) ? 5 : 1 + nextRandom () % 64;
+		for (i = 0; i < length; i++) buff[i] = nextRandom ();
+
+		mismatches += _SD_CRC7 (buff, length) != crc7 (buff, length);
+	}
+	CHECK (mismatches == 0);
+
+	// GO_IDLE_STATE, whose CRC the card checks even in SPI mode
+	memcpy (buff, "\x40\0\0\0\0", 5);
+	CHECK (_SD_CRC7 (buff, 5) == 0x95);
+
+	// random buffers of every allowed length up to a sector
+	mismatches = 0;
+	for (trial = 0; trial < 100000; trial++) {
+		length = 4 * (1 + nextRandom () % (SECTOR_SIZE / 4));
+		for (i = 0; i < length; i++) buff[i] = nextRandom ();
+
+		_SD_CRC16 (buff, length, crc);
+		crc16 (buff, length, expected);
+		mismatches += memcmp (crc, expected, 8) != 0;
+	}
+	CHECK (mismatches == 0);
+
+	// all ones and all zeroes
+	memset (buff, 0xff, sizeof(buff));
+	_SD_CRC16 (buff, sizeof(buff), crc);
+	crc16 (buff, sizeof(buff), expected);
+	CHECK (memcmp (crc, expected, 8) == 0);
+
+	memset (buff, 0, sizeof(buff));
+	_SD_CRC16 (buff, sizeof(buff), crc);
+	CHECK (memcmp (crc, "\0\0\0\0\0\0\0\0", 8) == 0);
+
+	return failures != 0;
+}
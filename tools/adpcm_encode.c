@@ -0,0 +1,116 @@
+/*
+
+	libgba IMA ADPCM encoder
+
+	Copyright 2003-2004 by Dave Murphy.
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Library General Public
+	License as published by the Free Software Foundation; either
+	version 2 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Library General Public License for more details.
+
+	You should have received a copy of the GNU Library General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+	USA.
+
+	Please report all bugs and problems through the bug tracker at
+	"http://sourceforge.net/tracker/?group_id=114505&atid=668551".
+
+
+*/
+
+/*---------------------------------------------------------------------------------
+	Built for the host along with src/adpcm.iwram.c for the tables. The
+	encoder follows the decoder's state exactly, so each block header
+	holds just what the decoder will have reached there.
+
+---------------------------------------------------------------------------------*/
+#include "adpcm_encode.h"
+
+//---------------------------------------------------------------------------------
+u32 adpcmEncodedSize(u32 samples)
+//---------------------------------------------------------------------------------
+{
+	return ((samples + ADPCM_BLOCK_SAMPLES - 1) / ADPCM_BLOCK_SAMPLES) * ADPCM_BLOCK_SIZE;
+}
+
+//---------------------------------------------------------------------------------
+static int adpcmEncodeSample(AdpcmState *state, s32 sample)
+//---------------------------------------------------------------------------------
+{
+	s32 step = adpcmStepTable[state->index];
+	s32 delta = sample - state->predictor;
+	s32 diff;
+	int code = 0;
+
+	if ( delta < 0) {
+		code = 8;
+		delta = -delta;
+	}
+
+	if ( delta >= step) { code |= 4; delta -= step; }
+	if ( delta >= step >> 1) { code |= 2; delta -= step >> 1; }
+	if ( delta >= step >> 2) code |= 1;
+
+	// step the state as the decoder will
+	diff = step >> 3;
+	if ( code & 4) diff += step;
+	if ( code & 2) diff += step >> 1;
+	if ( code & 1) diff += step >> 2;
+
+	if ( code & 8) {
+		state->predictor -= diff;
+		if ( state->predictor < -32768) state->predictor = -32768;
+	} else {
+		state->predictor += diff;
+		if ( state->predictor > 32767) state->predictor = 32767;
+	}
+
+	state->index += adpcmIndexTable[code];
+	if ( state->index < 0) state->index = 0; else if ( state->index > 88) state->index = 88;
+
+	return code;
+}
+
+//---------------------------------------------------------------------------------
+u32 adpcmEncode(const s16 *pcm, u32 samples, u8 *out)
+//---------------------------------------------------------------------------------
+{
+	AdpcmState state;
+	u32 size = adpcmEncodedSize(samples);
+	u32 i;
+	int code;
+	u8 *codes = out;
+
+	state.predictor = 0;
+	state.index = 0;
+
+	for ( i = 0; i < size; i++) out[i] = 0;
+
+	for ( i = 0; i < samples; i++) {
+		if ( i % ADPCM_BLOCK_SAMPLES == 0) {
+			out[0] = state.predictor & 255;
+			out[1] = (state.predictor >> 8) & 255;
+			out[2] = state.index;
+			out[3] = 0;
+			codes = out + ADPCM_HEADER_SIZE;
+			out += ADPCM_BLOCK_SIZE;
+		}
+
+		code = adpcmEncodeSample(&state, pcm[i]);
+
+		if ( i & 1) {
+			*codes++ |= code << 4;
+		} else {
+			*codes = code;
+		}
+	}
+
+	return size;
+}
@@ -0,0 +1,21 @@
+/*---------------------------------------------------------------------------------
+
+	IMA ADPCM encoder for the streams of gba_adpcm.h
+
+---------------------------------------------------------------------------------*/
+#ifndef _adpcm_encode_h_
+#define _adpcm_encode_h_
+
+#include <gba_adpcm.h>
+
+//---------------------------------------------------------------------------------
+// size of the encoding of a number of samples, whole blocks
+//---------------------------------------------------------------------------------
+u32 adpcmEncodedSize(u32 samples);
+
+//---------------------------------------------------------------------------------
+// encodes 16 bit PCM to adpcmEncodedSize bytes at out, returns that size
+//---------------------------------------------------------------------------------
+u32 adpcmEncode(const s16 *pcm, u32 samples, u8 *out);
+
+#endif // _adpcm_encode_h_
@@ -0,0 +1,124 @@
+/*---------------------------------------------------------------------------------
+
+	adpcmenc - encode a WAV file to an IMA ADPCM stream for gba_adpcm.h
+
+	Usage: adpcmenc input.wav output.bin
+
+	The input has to be 16 bit PCM, stereo is mixed down to mono. The
+	sample count and rate are printed, the count is what adpcmOpen and
+	adpcmOpenDisc take. The stream should be at the rate the mixer runs.
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adpcm_encode.h"
+
+//---------------------------------------------------------------------------------
+static u32 getLE(const u8 *p, int bytes)
+//---------------------------------------------------------------------------------
+{
+	u32 value = 0;
+
+	while ( bytes--) value = (value << 8) | p[bytes];
+
+	return value;
+}
+
+//---------------------------------------------------------------------------------
+// reads the samples of a 16 bit PCM WAV file as mono, returns NULL if it
+// isn't one
+//---------------------------------------------------------------------------------
+static s16 *readWav(const char *path, u32 *samples, u32 *rate)
+//---------------------------------------------------------------------------------
+{
+	FILE *f = fopen(path, "rb");
+	u8 header[12], chunk[8], format[16];
+	int channels = 0, i;
+	u32 size, n;
+	s16 *pcm = NULL;
+	s32 sum;
+	u8 frame[4];
+
+	if ( f == NULL) return NULL;
+
+	if ( fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) {
+		fclose(f);
+		return NULL;
+	}
+
+	while ( fread(chunk, 1, 8, f) == 8) {
+		size = getLE(chunk + 4, 4);
+
+		if ( !memcmp(chunk, "fmt ", 4) && size >= 16) {
+			if ( fread(format, 1, 16, f) != 16) break;
+			fseek(f, size - 16 + (size & 1), SEEK_CUR);
+
+			// PCM, mono or stereo, 16 bit
+			if ( getLE(format, 2) != 1 || getLE(format + 14, 2) != 16) break;
+			channels = getLE(format + 2, 2);
+			if ( channels != 1 && channels != 2) break;
+			*rate = getLE(format + 4, 4);
+		} else if ( !memcmp(chunk, "data", 4) && channels) {
+			*samples = size / (2 * channels);
+			pcm = malloc(*samples * sizeof(s16) + 1);
+			if ( pcm == NULL) break;
+
+			for ( n = 0; n < *samples; n++) {
+				if ( fread(frame, 2, channels, f) != (size_t)channels) {
+					*samples = n;
+					break;
+				}
+				for ( i = 0, sum = 0; i < channels; i++) sum += (s16)getLE(frame + 2 * i, 2);
+				pcm[n] = sum / channels;
+			}
+			break;
+		} else {
+			fseek(f, size + (size & 1), SEEK_CUR);
+		}
+	}
+
+	fclose(f);
+	return pcm;
+}
+
+//---------------------------------------------------------------------------------
+int main(int argc, char **argv)
+//---------------------------------------------------------------------------------
+{
+	u32 samples = 0, rate = 0, size;
+	s16 *pcm;
+	u8 *out;
+	FILE *f;
+
+	if ( argc != 3) {
+		fprintf(stderr, "usage: %s input.wav output.bin\n", argv[0]);
+		return 1;
+	}
+
+	if ( (pcm = readWav(argv[1], &samples, &rate)) == NULL) {
+		fprintf(stderr, "%s: %s is not a 16 bit PCM WAV file\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	size = adpcmEncodedSize(samples);
+	if ( (out = malloc(size + 1)) == NULL) {
+		fprintf(stderr, "%s: out of memory\n", argv[0]);
+		return 1;
+	}
+	adpcmEncode(pcm, samples, out);
+
+	if ( (f = fopen(argv[2], "wb")) == NULL || fwrite(out, 1, size, f) != size) {
+		fprintf(stderr, "%s: can't write %s\n", argv[0], argv[2]);
+		return 1;
+	}
+	fclose(f);
+
+	printf("%s: %u samples at %uHz, %u bytes\n", argv[2], samples, rate, size);
+
+	free(pcm);
+	free(out);
+
+	return 0;
+}
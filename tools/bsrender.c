@@ -0,0 +1,166 @@
+/*---------------------------------------------------------------------------------
+
+	bsrender - play a BoyScout song through a model of the PSG
+
+	Usage: bsrender [-c] [-t ticks] [-r rate] song.bin [output.wav]
+
+	The song is played once, or looped for the given number of frame
+	ticks, and rendered to a stereo 16 bit WAV file if one is given.
+	-c runs the optional compile step first, -r sets the output rate,
+	which should divide 16777216.
+
+	Printed are checksums of the sound registers after each tick and of
+	the rendered audio, for regression checks, along with what each tick
+	cost: the host time spent in BoyScoutUpdateSong and the number of
+	sound register halfwords it changed.
+
+---------------------------------------------------------------------------------*/
+#include <BoyScout.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gbahost.h"
+#include "psg.h"
+
+// one song played once stops well before this
+#define BSRENDER_MAX_TICKS	(60 * 60 * 30)
+
+//---------------------------------------------------------------------------------
+static void putLE(FILE *f, u32 value, int bytes)
+//---------------------------------------------------------------------------------
+{
+	while ( bytes--) {
+		fputc(value & 255, f);
+		value >>= 8;
+	}
+}
+
+//---------------------------------------------------------------------------------
+static void writeWavHeader(FILE *f, int rate, u32 samples)
+//---------------------------------------------------------------------------------
+{
+	u32 size = samples * 4;
+
+	fwrite("RIFF", 1, 4, f);
+	putLE(f, 36 + size, 4);
+	fwrite("WAVEfmt ", 1, 8, f);
+	putLE(f, 16, 4);
+	putLE(f, 1, 2);			// PCM
+	putLE(f, 2, 2);			// stereo
+	putLE(f, rate, 4);
+	putLE(f, rate * 4, 4);
+	putLE(f, 4, 2);
+	putLE(f, 16, 2);
+	fwrite("data", 1, 4, f);
+	putLE(f, size, 4);
+}
+
+//---------------------------------------------------------------------------------
+static long long nanoseconds(void)
+//---------------------------------------------------------------------------------
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+//---------------------------------------------------------------------------------
+int main(int argc, char **argv)
+//---------------------------------------------------------------------------------
+{
+	static s16 buffer[2 * PSG_FRAME_CYCLES / 256 + 2];
+	const u8 *io = (const u8 *)GBAHOST_IO;
+	int compile = 0, rate = 32768, ticks = 0, opt;
+	int tick, samples, i, changes, mostChanges = 0;
+	long long start, ns, totalNs = 0, mostNs = 0, totalChanges = 0;
+	unsigned long long rendered = 0;
+	u32 trace = 0, audio = 2166136261u;
+	FILE *wav = NULL;
+	Psg psg;
+
+	while ( (opt = getopt(argc, argv, "ct:r:")) != -1) {
+		switch ( opt) {
+		case 'c':	compile = 1; break;
+		case 't':	ticks = atoi(optarg); break;
+		case 'r':	rate = atoi(optarg); break;
+		default:	optind = argc + 1; break;
+		}
+	}
+
+	if ( optind >= argc || argc - optind > 2 || rate < 256 || rate > 65536 || ticks < 0) {
+		fprintf(stderr, "usage: %s [-c] [-t ticks] [-r rate] song.bin [output.wav]\n", argv[0]);
+		return 1;
+	}
+
+	if ( !gbaHostMap()) {
+		fprintf(stderr, "%s: can't map the GBA memory areas\n", argv[0]);
+		return 1;
+	}
+
+	if ( gbaHostLoadRom(argv[optind]) <= 0) {
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[optind]);
+		return 1;
+	}
+
+	BoyScoutInitialize();
+	BoyScoutSetMemoryArea(GBAHOST_EWRAM);
+	BoyScoutSetMemoryAreaSize(GBAHOST_EWRAM_SIZE);
+
+	if ( !BoyScoutOpenSong((const u8 *)GBAHOST_ROM) || (compile && !BoyScoutCompileSong())) {
+		fprintf(stderr, "%s: %s is not a song which fits in EWRAM\n", argv[0], argv[optind]);
+		return 1;
+	}
+
+	if ( argc - optind == 2 && (wav = fopen(argv[optind + 1], "wb")) == NULL) {
+		fprintf(stderr, "%s: can't write %s\n", argv[0], argv[optind + 1]);
+		return 1;
+	}
+	if ( wav) writeWavHeader(wav, rate, 0);
+
+	psgInit(&psg, rate);
+	BoyScoutPlaySong(ticks > 0);
+
+	for ( tick = 0; tick < (ticks ? ticks : BSRENDER_MAX_TICKS); tick++) {
+		start = nanoseconds();
+		if ( !BoyScoutUpdateSong()) break;
+		ns = nanoseconds() - start;
+
+		totalNs += ns;
+		if ( ns > mostNs) mostNs = ns;
+
+		// the registers as the player left them, before the model takes the INIT bits
+		for ( i = 0x60; i < 0xa0; i++) trace = trace * 31 + io[i];
+
+		changes = psgUpdate(&psg, (vu16 *)GBAHOST_IO);
+		totalChanges += changes;
+		if ( changes > mostChanges) mostChanges = changes;
+
+		// the samples up to the next tick
+		samples = (int)(((tick + 1) * (unsigned long long)PSG_FRAME_CYCLES) / psg.cyclesPerSample - rendered);
+		rendered += samples;
+
+		psgRender(&psg, buffer, samples);
+
+		for ( i = 0; i < samples * 2; i++) {
+			audio = (audio ^ (u16)buffer[i]) * 16777619u;
+			if ( wav) putLE(wav, (u16)buffer[i], 2);
+		}
+	}
+
+	if ( wav) {
+		fseek(wav, 0, SEEK_SET);
+		writeWavHeader(wav, rate, rendered);
+		fclose(wav);
+	}
+
+	printf("ticks %d, registers %08x, audio %08x\n", tick, trace, audio);
+	if ( tick) {
+		printf("per tick: %lld ns on average, %lld at most, %.2f register changes on average, %d at most\n",
+				totalNs / tick, mostNs, (double)totalChanges / tick, mostChanges);
+	}
+
+	return 0;
+}
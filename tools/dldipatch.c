@@ -0,0 +1,91 @@
+/*---------------------------------------------------------------------------------
+
+	dldipatch - patch a DLDI driver into a GBA ROM or multiboot image
+
+	Usage: dldipatch driver.dldi image.gba [output.gba]
+
+	The image is patched in place unless an output file is given. The
+	driver is relocated to the address the image's stub was linked at,
+	just as dldiPatchImage does on the GBA.
+
+---------------------------------------------------------------------------------*/
+#include <dldi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//---------------------------------------------------------------------------------
+// reads a whole file into a word aligned buffer
+//---------------------------------------------------------------------------------
+static u8 *readFile(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	u8 *data;
+	long length;
+
+	if ( f == NULL) return NULL;
+
+	fseek(f, 0, SEEK_END);
+	length = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	// malloc returns memory aligned for any type, words included
+	data = malloc(length > 0 ? length : 1);
+	if ( data != NULL && fread(data, 1, length, f) != (size_t)length) {
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+
+	*size = length;
+	return data;
+}
+
+//---------------------------------------------------------------------------------
+int main(int argc, char **argv)
+//---------------------------------------------------------------------------------
+{
+	const char *output;
+	u8 *driver, *image;
+	size_t driverSize, imageSize;
+	FILE *f;
+
+	if ( argc < 3 || argc > 4) {
+		fprintf(stderr, "usage: %s driver.dldi image.gba [output.gba]\n", argv[0]);
+		return 1;
+	}
+	output = argc == 4 ? argv[3] : argv[2];
+
+	if ( (driver = readFile(argv[1], &driverSize)) == NULL) {
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	if ( (image = readFile(argv[2], &imageSize)) == NULL) {
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[2]);
+		return 1;
+	}
+
+	if ( !dldiValidate((const DLDI_INTERFACE *)driver, driverSize)) {
+		fprintf(stderr, "%s: %s is not a valid DLDI driver\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	printf("%s: %.48s\n", argv[1], ((const DLDI_INTERFACE *)driver)->friendlyName);
+
+	if ( !dldiPatchImage(image, imageSize, (const DLDI_INTERFACE *)driver, driverSize)) {
+		fprintf(stderr, "%s: %s has no DLDI stub large enough for the driver\n", argv[0], argv[2]);
+		return 1;
+	}
+
+	if ( (f = fopen(output, "wb")) == NULL || fwrite(image, 1, imageSize, f) != imageSize) {
+		fprintf(stderr, "%s: can't write %s\n", argv[0], output);
+		return 1;
+	}
+	fclose(f);
+
+	printf("patched %s\n", output);
+
+	free(driver);
+	free(image);
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------------------------
+
+	Host stand-ins for running GBA code on a PC
+
+---------------------------------------------------------------------------------*/
+#include "gbahost.h"
+
+#include <gba_interrupt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE	0x100000
+#endif
+
+//---------------------------------------------------------------------------------
+static bool gbaHostMapArea(u32 address, u32 size)
+//---------------------------------------------------------------------------------
+{
+	void *p = mmap((void *)(uintptr_t)address, size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+	// older kernels take the flag as a hint and may map elsewhere
+	if ( p != MAP_FAILED && p != (void *)(uintptr_t)address) {
+		munmap(p, size);
+		p = MAP_FAILED;
+	}
+
+	return p != MAP_FAILED;
+}
+
+//---------------------------------------------------------------------------------
+bool gbaHostMap(void)
+//---------------------------------------------------------------------------------
+{
+	return	gbaHostMapArea(GBAHOST_EWRAM, GBAHOST_EWRAM_SIZE) &&
+			gbaHostMapArea(GBAHOST_IO, GBAHOST_IO_SIZE) &&
+			gbaHostMapArea(GBAHOST_ROM, GBAHOST_ROM_SIZE);
+}
+
+//---------------------------------------------------------------------------------
+long gbaHostLoadRom(const char *path)
+//---------------------------------------------------------------------------------
+{
+	FILE *f = fopen(path, "rb");
+	long size;
+
+	if ( f == NULL) return -1;
+
+	size = fread((void *)GBAHOST_ROM, 1, GBAHOST_ROM_SIZE, f);
+	if ( ferror(f)) size = -1;
+	fclose(f);
+
+	return size;
+}
+
+//---------------------------------------------------------------------------------
+// nothing interrupts the host, the handlers set up are kept for
+// gbaHostInterrupt to call
+//---------------------------------------------------------------------------------
+static IntFn gbaHostHandlers[16];
+static int gbaHostEnabled = 0;
+
+//---------------------------------------------------------------------------------
+IntFn *irqSet(irqMASK mask, IntFn function)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	for ( i = 0; i < 16; i++) {
+		if ( mask & (1 << i)) gbaHostHandlers[i] = function;
+	}
+
+	return NULL;
+}
+
+void irqEnable(int mask) { gbaHostEnabled |= mask; }
+void irqDisable(int mask) { gbaHostEnabled &= ~mask; }
+
+//---------------------------------------------------------------------------------
+bool gbaHostInterrupt(int mask)
+//---------------------------------------------------------------------------------
+{
+	int i;
+
+	for ( i = 0; i < 16; i++) {
+		if ( (mask & gbaHostEnabled & (1 << i)) && gbaHostHandlers[i]) {
+			gbaHostHandlers[i]();
+			return true;
+		}
+	}
+
+	return false;
+}
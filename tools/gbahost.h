@@ -0,0 +1,39 @@
+/*---------------------------------------------------------------------------------
+
+	Host stand-ins for running GBA code on a PC
+
+	The player code keeps addresses in 32 bit integers and writes to the
+	IO registers at their GBA addresses, so the EWRAM, IO and ROM areas
+	are mapped at the same addresses on the host.
+
+---------------------------------------------------------------------------------*/
+#ifndef _gbahost_h_
+#define _gbahost_h_
+
+#include <gba_base.h>
+
+#define GBAHOST_EWRAM	0x02000000
+#define GBAHOST_IO		0x04000000
+#define GBAHOST_ROM		0x08000000
+
+#define GBAHOST_EWRAM_SIZE	0x40000
+#define GBAHOST_IO_SIZE		0x1000
+#define GBAHOST_ROM_SIZE	0x2000000
+
+//---------------------------------------------------------------------------------
+// maps the areas, cleared, returns false if one of them is taken
+//---------------------------------------------------------------------------------
+bool gbaHostMap(void);
+
+//---------------------------------------------------------------------------------
+// reads a file to the start of the ROM area, returns its size or -1
+//---------------------------------------------------------------------------------
+long gbaHostLoadRom(const char *path);
+
+//---------------------------------------------------------------------------------
+// calls the handler irqSet gave an enabled interrupt, as if it had fired,
+// returns false if there is none
+//---------------------------------------------------------------------------------
+bool gbaHostInterrupt(int mask);
+
+#endif // _gbahost_h_
@@ -0,0 +1,31 @@
+/*---------------------------------------------------------------------------------
+
+	Decoder for the keypad recordings of keysRecordStart
+
+	A recording is a list of 16 bit little endian entries, one for each
+	run of frames with the same keys. The low 10 bits are the keys which
+	changed from the run before, the top 6 are the length of the run less
+	one, so longer runs are split over several entries.
+
+---------------------------------------------------------------------------------*/
+#include "keys_decode.h"
+
+//---------------------------------------------------------------------------------
+int keysDecode(const u8 *data, int size, u16 *frames, int maxFrames)
+//---------------------------------------------------------------------------------
+{
+	u16 keys = 0, entry;
+	int pos, run, count = 0;
+
+	for ( pos = 0; pos + 2 <= size; pos += 2) {
+		entry = data[pos] | (data[pos + 1] << 8);
+		keys ^= entry & 0x03ff;
+
+		for ( run = (entry >> 10) + 1; run > 0; run--) {
+			if ( frames != NULL && count < maxFrames) frames[count] = keys;
+			count++;
+		}
+	}
+
+	return count;
+}
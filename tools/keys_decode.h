@@ -0,0 +1,18 @@
+/*---------------------------------------------------------------------------------
+
+	Decoder for the keypad recordings of keysRecordStart
+
+---------------------------------------------------------------------------------*/
+#ifndef _keys_decode_h_
+#define _keys_decode_h_
+
+#include <gba_input.h>
+
+//---------------------------------------------------------------------------------
+// the keys held in each frame of a recording of size bytes, as scanKeys
+// saw them, up to maxFrames of them. Returns the number of frames in the
+// recording, frames may be NULL to only count them.
+//---------------------------------------------------------------------------------
+int keysDecode(const u8 *data, int size, u16 *frames, int maxFrames);
+
+#endif // _keys_decode_h_
@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------------
+
+	keysplay - play back a keypad recording made with keysRecordStart
+
+	Usage: keysplay recording.bin
+
+	Prints the keys held through the recording, a line for each run of
+	frames with the same keys: the first frame, the number of frames and
+	the keys.
+
+---------------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "keys_decode.h"
+
+static const char *keyNames[10] = {
+	"A", "B", "SELECT", "START", "RIGHT", "LEFT", "UP", "DOWN", "R", "L"
+};
+
+//---------------------------------------------------------------------------------
+int main(int argc, char **argv)
+//---------------------------------------------------------------------------------
+{
+	u8 *data;
+	u16 *frames;
+	long size;
+	int count, first, i, key;
+	FILE *f;
+
+	if ( argc != 2) {
+		fprintf(stderr, "usage: %s recording.bin\n", argv[0]);
+		return 1;
+	}
+
+	if ( (f = fopen(argv[1], "rb")) == NULL || fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0) {
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	rewind(f);
+
+	data = malloc(size + 1);
+	if ( data == NULL || fread(data, 1, size, f) != (size_t)size) {
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	fclose(f);
+
+	count = keysDecode(data, size, NULL, 0);
+	if ( (frames = malloc(count * sizeof(u16) + 1)) == NULL) {
+		fprintf(stderr, "%s: out of memory\n", argv[0]);
+		return 1;
+	}
+	keysDecode(data, size, frames, count);
+
+	for ( first = 0; first < count; first = i) {
+		for ( i = first + 1; i < count && frames[i] == frames[first]; i++);
+
+		printf("%8d %8d ", first, i - first);
+		if ( frames[first] == 0) printf(" -");
+		for ( key = 0; key < 10; key++) {
+			if ( frames[first] & (1 << key)) printf(" %s", keyNames[key]);
+		}
+		printf("\n");
+	}
+
+	printf("%d frames, %ld bytes\n", count, size);
+
+	free(data);
+	free(frames);
+
+	return 0;
+}
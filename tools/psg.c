@@ -0,0 +1,320 @@
+/*---------------------------------------------------------------------------------
+
+	Software model of the four GBA PSG channels
+
+	Timings follow the hardware: the tone channels step through 8 duty
+	steps every (2048 - freq) * 128 cycles, the wave channel through 32
+	samples every (2048 - freq) * 256 cycles, and the frame sequencer
+	clocks the lengths at 256Hz, the sweep at 128Hz and the envelopes
+	at 64Hz. Each output sample is the state at that point in time,
+	without the analogue filtering of the real output.
+
+---------------------------------------------------------------------------------*/
+#include "psg.h"
+
+#include <string.h>
+
+//---------------------------------------------------------------------------------
+// halfword indices of the registers from 0x60
+//---------------------------------------------------------------------------------
+enum {
+	PSG_SOUND1CNT_L	= 0,
+	PSG_SOUND1CNT_H	= 1,
+	PSG_SOUND1CNT_X	= 2,
+	PSG_SOUND2CNT_L	= 4,
+	PSG_SOUND2CNT_H	= 6,
+	PSG_SOUND3CNT_L	= 8,
+	PSG_SOUND3CNT_H	= 9,
+	PSG_SOUND3CNT_X	= 10,
+	PSG_SOUND4CNT_L	= 12,
+	PSG_SOUND4CNT_H	= 14,
+	PSG_SOUNDCNT_L	= 16,
+	PSG_SOUNDCNT_H	= 17,
+	PSG_SOUNDCNT_X	= 18,
+	PSG_WAVE_RAM	= 24
+};
+
+#define PSG_INIT		0x8000
+#define PSG_LENGTH_ON	0x4000
+
+// the envelope or length register and the control register of each channel
+static const int psgEnvelopeReg[4] = { PSG_SOUND1CNT_H, PSG_SOUND2CNT_L, PSG_SOUND3CNT_H, PSG_SOUND4CNT_L };
+static const int psgControlReg[4] = { PSG_SOUND1CNT_X, PSG_SOUND2CNT_H, PSG_SOUND3CNT_X, PSG_SOUND4CNT_H };
+
+// duty step patterns for 12.5%, 25%, 50% and 75%
+static const u8 psgDuty[4] = { 0x80, 0x81, 0xe1, 0x7e };
+
+//---------------------------------------------------------------------------------
+void psgInit(Psg *psg, int rate)
+//---------------------------------------------------------------------------------
+{
+	memset(psg, 0, sizeof(Psg));
+
+	psg->cyclesPerSample = PSG_CLOCK / rate;
+	psg->sequencerCounter = PSG_CLOCK / 512;
+}
+
+//---------------------------------------------------------------------------------
+static s32 psgNoisePeriod(u16 control)
+//---------------------------------------------------------------------------------
+{
+	int ratio = control & 7, shift = (control >> 4) & 15;
+
+	// the two highest shifts don't clock the noise at all
+	if ( shift >= 14) return 0;
+
+	return (ratio ? ratio * 64 : 32) << shift;
+}
+
+//---------------------------------------------------------------------------------
+static void psgSetFreq(PsgChannel *ch, int n, int freq)
+//---------------------------------------------------------------------------------
+{
+	ch->freq = freq;
+	ch->period = (2048 - freq) * (n == 2 ? 8 : 16);
+}
+
+//---------------------------------------------------------------------------------
+static void psgTrigger(Psg *psg, int n)
+//---------------------------------------------------------------------------------
+{
+	PsgChannel *ch = &psg->channel[n];
+	u16 envelope = psg->regs[psgEnvelopeReg[n]];
+	u16 control = psg->regs[psgControlReg[n]];
+	int sweep, shift;
+
+	ch->on = true;
+	ch->counter = 0;
+
+	if ( n == 2) {
+		ch->length = 256 - (envelope & 255);
+		ch->step = 0;
+		ch->on = (psg->regs[PSG_SOUND3CNT_L] & 0x80) != 0;
+		psgSetFreq(ch, n, control & 0x7ff);
+		return;
+	}
+
+	ch->length = 64 - (envelope & 63);
+	ch->volume = envelope >> 12;
+	ch->envelope = (envelope >> 8) & 7;
+	ch->envelopeTimer = ch->envelope;
+
+	// no volume and no increase turns the DAC off
+	if ( (envelope & 0xf800) == 0) ch->on = false;
+
+	if ( n == 3) {
+		ch->step = 0x7fff;
+		ch->period = psgNoisePeriod(control);
+		return;
+	}
+
+	psgSetFreq(ch, n, control & 0x7ff);
+
+	if ( n == 0) {
+		sweep = psg->regs[PSG_SOUND1CNT_L];
+		shift = sweep & 7;
+
+		ch->shadow = ch->freq;
+		ch->sweepTimer = (sweep >> 4) & 7;
+
+		if ( shift && !(sweep & 8) && ch->shadow + (ch->shadow >> shift) > 2047) ch->on = false;
+	}
+}
+
+//---------------------------------------------------------------------------------
+int psgUpdate(Psg *psg, vu16 *io)
+//---------------------------------------------------------------------------------
+{
+	vu16 *regs = io + 0x60 / 2;
+	int i, n, changed = 0;
+	u16 value, previous[4];
+
+	for ( n = 0; n < 4; n++) previous[n] = psg->regs[psgControlReg[n]];
+
+	for ( i = 0; i < 0x20; i++) {
+		value = regs[i];
+		if ( value != psg->regs[i]) changed++;
+		psg->regs[i] = value;
+	}
+
+	for ( i = 0; i < 16; i += 2) {
+		value = psg->regs[PSG_WAVE_RAM + i / 2];
+		psg->wave[i] = value & 255;
+		psg->wave[i + 1] = value >> 8;
+	}
+
+	for ( n = 0; n < 4; n++) {
+		value = psg->regs[psgControlReg[n]];
+
+		if ( value & PSG_INIT) {
+			value &= ~PSG_INIT;
+			regs[psgControlReg[n]] = psg->regs[psgControlReg[n]] = value;
+			psgTrigger(psg, n);
+		} else if ( n == 3) {
+			psg->channel[n].period = psgNoisePeriod(value);
+		} else if ( (value ^ previous[n]) & 0x7ff) {
+			// written without INIT, which changes the tone at once
+			psgSetFreq(&psg->channel[n], n, value & 0x7ff);
+		}
+	}
+
+	if ( !(psg->regs[PSG_SOUND3CNT_L] & 0x80)) psg->channel[2].on = false;
+
+	return changed;
+}
+
+//---------------------------------------------------------------------------------
+static void psgSequencer(Psg *psg)
+//---------------------------------------------------------------------------------
+{
+	PsgChannel *ch;
+	int n, sweep, shift, freq;
+
+	// lengths at 256Hz
+	if ( !(psg->sequencerStep & 1)) {
+		for ( n = 0; n < 4; n++) {
+			ch = &psg->channel[n];
+			if ( ch->on && (psg->regs[psgControlReg[n]] & PSG_LENGTH_ON) && ch->length > 0) {
+				if ( --ch->length == 0) ch->on = false;
+			}
+		}
+	}
+
+	// sweep at 128Hz
+	ch = &psg->channel[0];
+	if ( (psg->sequencerStep & 3) == 2 && ch->on) {
+		sweep = psg->regs[PSG_SOUND1CNT_L];
+		shift = sweep & 7;
+
+		if ( ((sweep >> 4) & 7) && --ch->sweepTimer <= 0) {
+			ch->sweepTimer = (sweep >> 4) & 7;
+
+			freq = (sweep & 8) ? ch->shadow - (ch->shadow >> shift) : ch->shadow + (ch->shadow >> shift);
+
+			if ( freq > 2047) {
+				ch->on = false;
+			} else if ( shift) {
+				ch->shadow = freq;
+				psgSetFreq(ch, 0, freq);
+			}
+		}
+	}
+
+	// envelopes at 64Hz
+	if ( psg->sequencerStep == 7) {
+		for ( n = 0; n < 4; n++) {
+			ch = &psg->channel[n];
+			if ( n == 2 || ch->envelope == 0 || --ch->envelopeTimer > 0) continue;
+
+			ch->envelopeTimer = ch->envelope;
+
+			if ( psg->regs[psgEnvelopeReg[n]] & 0x800) {
+				if ( ch->volume < 15) ch->volume++;
+			} else {
+				if ( ch->volume > 0) ch->volume--;
+			}
+		}
+	}
+
+	psg->sequencerStep = (psg->sequencerStep + 1) & 7;
+}
+
+//---------------------------------------------------------------------------------
+static void psgClock(Psg *psg, int n)
+//---------------------------------------------------------------------------------
+{
+	PsgChannel *ch = &psg->channel[n];
+	bool narrow = (psg->regs[PSG_SOUND4CNT_H] & 8) != 0;
+	u32 bit;
+
+	if ( !ch->on || ch->period == 0) return;
+
+	ch->counter -= psg->cyclesPerSample;
+
+	while ( ch->counter <= 0) {
+		ch->counter += ch->period;
+
+		if ( n == 3) {
+			bit = (ch->step ^ (ch->step >> 1)) & 1;
+			ch->step = (ch->step >> 1) | (bit << 14);
+			// the 7 bit mode feeds back into bit 6 as well
+			if ( narrow) ch->step = (ch->step & ~0x40) | (bit << 6);
+		} else {
+			ch->step++;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------
+// the output of a channel, from -15 to 15
+//---------------------------------------------------------------------------------
+static int psgOutput(Psg *psg, int n)
+//---------------------------------------------------------------------------------
+{
+	PsgChannel *ch = &psg->channel[n];
+	u16 control;
+	int sample;
+
+	if ( !ch->on) return 0;
+
+	switch ( n) {
+	case 0:
+	case 1:
+		control = psg->regs[n ? PSG_SOUND2CNT_L : PSG_SOUND1CNT_H];
+		return ( psgDuty[(control >> 6) & 3] & (0x80 >> (ch->step & 7))) ? ch->volume : -ch->volume;
+
+	case 2:
+		sample = psg->wave[(ch->step & 31) >> 1];
+		sample = ( ch->step & 1) ? sample & 15 : sample >> 4;
+		sample = sample * 2 - 15;
+
+		control = psg->regs[PSG_SOUND3CNT_H];
+		if ( control & 0x8000) return sample * 3 / 4;
+
+		switch ( (control >> 13) & 3) {
+		case 0:	return 0;
+		case 1:	return sample;
+		case 2:	return sample / 2;
+		default: return sample / 4;
+		}
+
+	default:
+		return ( ch->step & 1) ? -ch->volume : ch->volume;
+	}
+}
+
+//---------------------------------------------------------------------------------
+void psgRender(Psg *psg, s16 *out, int samples)
+//---------------------------------------------------------------------------------
+{
+	u16 mix = psg->regs[PSG_SOUNDCNT_L];
+	int ratio = psg->regs[PSG_SOUNDCNT_H] & 3;
+	int n, output, left, right;
+
+	// 100%, 50% or 25% of the full PSG volume
+	ratio = ( ratio == 3) ? 0 : 2 - ratio;
+
+	while ( samples--) {
+		psg->sequencerCounter -= psg->cyclesPerSample;
+		while ( psg->sequencerCounter <= 0) {
+			psg->sequencerCounter += PSG_CLOCK / 512;
+			psgSequencer(psg);
+		}
+
+		left = right = 0;
+
+		for ( n = 0; n < 4; n++) {
+			psgClock(psg, n);
+
+			output = psgOutput(psg, n);
+			if ( mix & (0x1000 << n)) left += output;
+			if ( mix & (0x100 << n)) right += output;
+		}
+
+		if ( !(psg->regs[PSG_SOUNDCNT_X] & 0x80)) left = right = 0;
+
+		// at most 4 channels * 15 * 8 * 64 = 30720 at full volume
+		*out++ = (left * (((mix >> 4) & 7) + 1) * 64) >> ratio;
+		*out++ = (right * ((mix & 7) + 1) * 64) >> ratio;
+	}
+}
@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------------
+
+	Software model of the four GBA PSG channels
+
+	The model reads the sound registers after the code under test has
+	written them, once a frame, and renders stereo 16 bit PCM from them.
+	A write with the INIT bit set starts a note, the bit is cleared in
+	the registers afterwards as it reads back 0 on the hardware.
+
+	Wave RAM is modelled as the one bank the CPU last wrote, which is
+	how players use the two banks: fill the idle one, then switch to it.
+
+---------------------------------------------------------------------------------*/
+#ifndef _psg_h_
+#define _psg_h_
+
+#include <gba_base.h>
+
+#define PSG_CLOCK		16777216
+#define PSG_FRAME_CYCLES	280896
+
+//---------------------------------------------------------------------------------
+typedef struct PsgChannel {
+	bool	on;
+	int		freq;			// 11 bit frequency of the tone and wave channels
+	s32		period;			// cycles per waveform step, 0 stops the steps
+	s32		counter;		// cycles to the next step
+	u32		step;			// waveform position, the LFSR of the noise channel
+	int		volume;
+	int		envelope;		// envelope period in 64ths of a second, 0 if fixed
+	int		envelopeTimer;
+	int		length;			// 256ths of a second left when the length is on
+	int		sweepTimer;		// sweep period count of channel 1
+	int		shadow;			// sweep frequency of channel 1
+} PsgChannel;
+
+//---------------------------------------------------------------------------------
+typedef struct Psg {
+	PsgChannel	channel[4];
+	u16		regs[0x20];		// the registers from 0x60 as last seen
+	u8		wave[16];
+	s32		cyclesPerSample;
+	s32		sequencerCounter;	// cycles to the next 512Hz frame sequencer step
+	int		sequencerStep;
+} Psg;
+
+//---------------------------------------------------------------------------------
+// starts with every channel off, rate is in Hz and should divide PSG_CLOCK
+//---------------------------------------------------------------------------------
+void psgInit(Psg *psg, int rate);
+
+//---------------------------------------------------------------------------------
+// takes in the sound registers of the IO page at io, starting the notes
+// written with INIT, returns how many register halfwords changed
+//---------------------------------------------------------------------------------
+int psgUpdate(Psg *psg, vu16 *io);
+
+//---------------------------------------------------------------------------------
+// renders interleaved left and right samples
+//---------------------------------------------------------------------------------
+void psgRender(Psg *psg, s16 *out, int samples);
+
+#endif // _psg_h_